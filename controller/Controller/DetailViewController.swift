@@ -116,35 +116,35 @@ class DetailViewController: UIViewController {
     }
     
     @IBAction func stop() {
-        send(topic: "stop", payload: "")
+        send(command: .stop)
     }
     
     @IBAction func automate() {
-        send(topic: "naos/set/automate", payload: "1")
+        send(command: .automate(true))
     }
     
     @IBAction func moveUp() {
-        send(topic: "move", payload: "up")
+        send(command: .moveUp)
     }
     
     @IBAction func moveDown() {
-        send(topic: "move", payload: "down")
+        send(command: .moveDown)
     }
     
     @IBAction func calibrate() {
-        send(topic: "calibrate", payload: "")
+        send(command: .calibrate)
     }
     
     @IBAction func flash() {
-        send(topic: "flash", payload: "512 512 512 512 500")
+        send(command: .flash(512, 512, 512, 512, 500))
     }
     
     @IBAction func disco() {
-        let red = String(Int(arc4random_uniform(1023)))
-        let green = String(Int(arc4random_uniform(1023)))
-        let blue = String(Int(arc4random_uniform(1023)))
+        let red = Int(arc4random_uniform(1023))
+        let green = Int(arc4random_uniform(1023))
+        let blue = Int(arc4random_uniform(1023))
         
-        send(topic: "fade", payload: String(format: "%@ %@ %@ 0 500", red, green, blue))
+        send(command: .fade(red, green, blue, 0, 500))
     }
     
     @IBAction func back(_ sender: Any) {
@@ -183,16 +183,16 @@ class DetailViewController: UIViewController {
             moveView!.alpha = 0
             
             // send move command
-            send(topic: "move", payload: String(format: "%.1f", newPosition))
+            send(command: .move(Double(newPosition)))
         }
     }
     
     // Helpers
     
-    func send(topic: String, payload: String) {
+    func send(command: Command) {
         // send message using the main view controller
         if let mvc = mainVC {
-            mvc.send(id: id, topic: topic, payload: payload)
+            mvc.send(id: id, command: command)
         }
     }
     
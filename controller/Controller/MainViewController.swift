@@ -26,10 +26,113 @@ let columns = grid[0].count
 let margin: Double = 150
 let marginTop: Double = 200
 
+enum Command {
+    case move(Double)
+    case moveUp
+    case moveDown
+    case stop
+    case automate(Bool)
+    case fade(Int, Int, Int, Int, Int)
+    case flash(Int, Int, Int, Int, Int)
+    case calibrate
+    
+    var topic: String {
+        switch self {
+        case .move, .moveUp, .moveDown: return "move"
+        case .stop: return "stop"
+        case .automate: return "automate"
+        case .fade: return "fade"
+        case .flash: return "flash"
+        case .calibrate: return "calibrate"
+        }
+    }
+    
+    var payload: String {
+        switch self {
+        case .move(let position): return String(format: "%.1f", position)
+        case .moveUp: return "up"
+        case .moveDown: return "down"
+        case .stop, .calibrate: return ""
+        case .automate(let enable): return enable ? "1" : "0"
+        case .fade(let r, let g, let b, let w, let time), .flash(let r, let g, let b, let w, let time):
+            return String(format: "%d %d %d %d %d", r, g, b, w, time)
+        }
+    }
+}
+
+struct Plan {
+    var received: Date
+    var position: Double
+    var velocity: Double
+    var target: Double
+    var maxVelocity: Double
+    var maxAcceleration: Double
+    
+    init?(payload: String, received: Date) {
+        // parse "start position velocity target max-velocity max-acceleration"
+        let fields = payload.split(separator: " ").compactMap { Double($0) }
+        if fields.count != 6 {
+            return nil
+        }
+        
+        // the plan starts when it is published, the device start time is not needed
+        self.received = received
+        position = fields[1]
+        velocity = fields[2]
+        target = fields[3]
+        maxVelocity = fields[4]
+        maxAcceleration = fields[5]
+    }
+    
+    func predict(at date: Date) -> (position: Double, done: Bool) {
+        // get distance and direction
+        let distance = abs(target - position)
+        let dir: Double = target >= position ? 1 : -1
+        
+        // check plan
+        let a = maxAcceleration
+        let vm = maxVelocity
+        if distance == 0 || a <= 0 || vm <= 0 {
+            return (target, true)
+        }
+        
+        // get initial velocity towards target
+        let v0 = min(max(velocity * dir, 0), vm)
+        
+        // calculate peak velocity and accelerate, cruise and decelerate phases (see twn_predict in the firmware)
+        var vp = vm
+        if (vm * vm - v0 * v0) / (2 * a) + vm * vm / (2 * a) > distance {
+            vp = max((a * distance + v0 * v0 / 2).squareRoot(), v0)
+        }
+        let t1 = (vp - v0) / a
+        let d1 = (v0 + vp) / 2 * t1
+        let t3 = vp / a
+        let d3 = vp * vp / (2 * a)
+        let d2 = max(distance - d1 - d3, 0)
+        let t2 = d2 / vp
+        
+        // calculate travelled distance at elapsed time in ms
+        let t = date.timeIntervalSince(received) * 1000
+        var d = distance
+        if t < t1 {
+            d = v0 * t + a * t * t / 2
+        } else if t < t1 + t2 {
+            d = d1 + vp * (t - t1)
+        } else if t < t1 + t2 + t3 {
+            let td = t - t1 - t2
+            d = d1 + d2 + vp * td - a * td * td / 2
+        }
+        
+        return (position + dir * min(d, distance), t >= t1 + t2 + t3)
+    }
+}
+
 class MainViewController: UIViewController, CircleViewDelegate, CocoaMQTTDelegate {
     var circleViews: [CircleView]?
     var client: CocoaMQTT?
     var detailVC: DetailViewController?
+    var plans = [Int: Plan]()
+    var planTimer: Timer?
     
     var connected = false
     
@@ -106,57 +209,87 @@ class MainViewController: UIViewController, CircleViewDelegate, CocoaMQTTDelegat
         
         // connect to broker
         client!.connect()
+        
+        // follow plans between updates
+        planTimer = Timer.scheduledTimer(timeInterval: 0.05, target: self, selector: #selector(follow), userInfo: nil, repeats: true)
     }
     
     @IBAction func stopAll() {
-        sendAll(topic: "stop", payload: "")
+        sendAll(command: .stop)
     }
     
     @IBAction func moveAllDown() {
-        sendAll(topic: "move", payload: "80")
+        sendAll(command: .move(80))
     }
     
     @IBAction func moveAllUp() {
-        sendAll(topic: "move", payload: "140")
+        sendAll(command: .move(140))
     }
     
     @IBAction func automateAll() {
-        sendAll(topic: "naos/set/automate", payload: "1")
+        sendAll(command: .automate(true))
     }
     
     @IBAction func flashAll() {
-        sendAll(topic: "flash", payload: "512 512 512 512 500")
+        sendAll(command: .flash(512, 512, 512, 512, 500))
     }
     
     @IBAction func discoAll() {
-        let red = String(Int(arc4random_uniform(1023)))
-        let green = String(Int(arc4random_uniform(1023)))
-        let blue = String(Int(arc4random_uniform(1023)))
+        let red = Int(arc4random_uniform(1023))
+        let green = Int(arc4random_uniform(1023))
+        let blue = Int(arc4random_uniform(1023))
         
-        sendAll(topic: "fade", payload: String(format: "%@ %@ %@ 0 500", red, green, blue))
+        sendAll(command: .fade(red, green, blue, 0, 500))
     }
     
     // Helpers
     
-    func send(id: Int, topic: String, payload: String) {
+    func send(id: Int, command: Command) {
         // return immediately if not connected
         if !connected {
             return
         }
         
         // send message
-        client!.publish("lights/" + String(id) + "/" + topic, withString: payload)
+        client!.publish("lights/" + String(id) + "/" + command.topic, withString: command.payload)
     }
     
-    func sendAll(topic: String, payload: String) {
+    func sendAll(command: Command) {
         // return immediately if not connected
         if !connected {
             return
         }
         
+        // format topic suffix and payload once
+        let topic = command.topic
+        let payload = command.payload
+        
         // send message to all lights
         for id in 1...circleViews!.count {
-            send(id: id, topic: topic, payload: payload)
+            client!.publish("lights/" + String(id) + "/" + topic, withString: payload)
+        }
+    }
+    
+    func update(id: Int, position: Double) {
+        // update circle view and detail view controller
+        for cv in circleViews! where cv.id == id {
+            cv.position = position
+        }
+        if detailVC?.id == id {
+            detailVC!.position = position
+        }
+    }
+    
+    @objc
+    func follow() {
+        // update positions from active plans and drop finished plans
+        let now = Date()
+        for (id, plan) in plans {
+            let prediction = plan.predict(at: now)
+            update(id: id, position: prediction.position)
+            if prediction.done {
+                plans[id] = nil
+            }
         }
     }
     
@@ -207,6 +340,7 @@ class MainViewController: UIViewController, CircleViewDelegate, CocoaMQTTDelegat
         
         // subscribe to topics
         client!.subscribe("lights/+/position")
+        client!.subscribe("lights/+/plan")
         client!.subscribe("lights/+/distance")
         client!.subscribe("lights/+/motion")
         client!.subscribe("lights/+/state")
@@ -245,9 +379,18 @@ class MainViewController: UIViewController, CircleViewDelegate, CocoaMQTTDelegat
             
             // update circle view and detail view controller based on the received information
             if segments.last == "position" {
+                // positions are only published while twin is disabled
                 let position = Double(String(data: Data(bytes: message.payload), encoding: .utf8) ?? "0") ?? 0
                 circleView?.position = position
                 detailViewController?.position = position
+            } else if segments.last == "plan" {
+                // follow the plan until it finished or is replaced
+                let payload = String(data: Data(bytes: message.payload), encoding: .utf8) ?? ""
+                if let plan = Plan(payload: payload, received: Date()) {
+                    plans[id] = plan
+                    circleView?.position = plan.position
+                    detailViewController?.position = plan.position
+                }
             } else if segments.last == "distance" {
                 let distance = Double(String(data: Data(bytes: message.payload), encoding: .utf8) ?? "0") ?? 0
                 circleView?.distance = distance
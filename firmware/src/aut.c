@@ -0,0 +1,65 @@
+#include <art32/numbers.h>
+#include <math.h>
+
+#include "aut.h"
+
+int aut_threshold(aut_config_t c, double position) {
+  // calculate dynamic pir threshold
+  return a32_safe_map_i((int)position, (int)c.idle_height, (int)c.rise_height, c.pir_low, c.pir_high);
+}
+
+double aut_target(aut_config_t c, double position, double distance, bool motion) {
+  // default target to idle height
+  double target = c.idle_height;
+
+  // check if we have motion or something below
+  if (motion || distance < c.approach_range) {
+    // approach object
+    target = a32_constrain_d(position + (-distance + c.approach_target), c.base_height, c.rise_height);
+  }
+
+  return target;
+}
+
+double aut_filter(aut_filter_t *f, double target, uint32_t now) {
+  // initialize filter
+  if (!f->ready) {
+    f->ready = true;
+    f->target = target;
+    f->direction = 0;
+    f->changed = now;
+    f->updated = now;
+    return f->target;
+  }
+
+  // get elapsed time
+  uint32_t elapsed = now - f->updated;
+  f->updated = now;
+
+  // ignore changes within deadband
+  double diff = target - f->target;
+  if (fabs(diff) < f->deadband) {
+    return f->target;
+  }
+
+  // require hysteresis and dwell before reversing direction
+  int direction = diff > 0 ? 1 : -1;
+  if (direction != f->direction) {
+    if (f->direction != 0 && (fabs(diff) < f->hysteresis || now - f->changed < f->dwell)) {
+      return f->target;
+    }
+    f->direction = direction;
+    f->changed = now;
+  }
+
+  // limit rate
+  double step = f->rate * (double)elapsed / 1000;
+  if (f->rate > 0 && fabs(diff) > step) {
+    diff = direction * step;
+  }
+
+  // apply change
+  f->target += diff;
+
+  return f->target;
+}
@@ -0,0 +1,90 @@
+#ifndef AUT_H
+#define AUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  /**
+   * The distance considered a valid approach range.
+   */
+  double approach_range;
+
+  /**
+   * The distance to approach from the detected object.
+   */
+  double approach_target;
+
+  /**
+   * The idle, base and rise heights.
+   */
+  double idle_height, base_height, rise_height;
+
+  /**
+   * The PIR sensitivities at idle and rise height.
+   */
+  int pir_low, pir_high;
+} aut_config_t;
+
+typedef struct {
+  /**
+   * The minimum target change in cm.
+   */
+  double deadband;
+
+  /**
+   * The minimum target change in cm to reverse the direction.
+   */
+  double hysteresis;
+
+  /**
+   * The maximum target change rate in cm/s (zero disables the limit).
+   */
+  double rate;
+
+  /**
+   * The minimum time in ms before the direction may be reversed again.
+   */
+  uint32_t dwell;
+
+  /**
+   * The filter state.
+   */
+  bool ready;
+  double target;
+  int direction;
+  uint32_t changed;
+  uint32_t updated;
+} aut_filter_t;
+
+/**
+ * Calculate the PIR threshold for the current position.
+ *
+ * @param c The configuration.
+ * @param position The current position.
+ * @return The threshold.
+ */
+int aut_threshold(aut_config_t c, double position);
+
+/**
+ * Calculate the automation target.
+ *
+ * @param c The configuration.
+ * @param position The current position.
+ * @param distance The current distance.
+ * @param motion Whether motion has been detected.
+ * @return The target position.
+ */
+double aut_target(aut_config_t c, double position, double distance, bool motion);
+
+/**
+ * Condition a target using deadband, hysteresis, rate limit and reversal dwell.
+ *
+ * @param f The filter.
+ * @param target The raw target.
+ * @param now The current time in ms.
+ * @return The conditioned target.
+ */
+double aut_filter(aut_filter_t *f, double target, uint32_t now);
+
+#endif  // AUT_H
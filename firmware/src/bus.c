@@ -0,0 +1,51 @@
+#include "bus.h"
+
+void *bus_claim(bus_topic_t *t) {
+  // get slot of next event
+  return t->ring + (t->head & (t->capacity - 1)) * t->size;
+}
+
+void bus_commit(bus_topic_t *t) {
+  // make event visible before advancing head
+  __sync_synchronize();
+
+  // advance head
+  t->head++;
+}
+
+void bus_subscribe(bus_sub_t *s, bus_topic_t *t) {
+  // set topic and cursor
+  s->topic = t;
+  s->cursor = t->head;
+  s->dropped = 0;
+}
+
+void bus_flush(bus_sub_t *s) {
+  // move cursor to head
+  s->cursor = s->topic->head;
+}
+
+const void *bus_next(bus_sub_t *s) {
+  // get head
+  uint32_t head = s->topic->head;
+
+  // check for new events
+  if (s->cursor == head) {
+    return NULL;
+  }
+
+  // skip events that have been overwritten
+  if (head - s->cursor > s->topic->capacity) {
+    s->dropped += head - s->cursor - (uint32_t)s->topic->capacity;
+    s->cursor = head - (uint32_t)s->topic->capacity;
+  }
+
+  // read barrier
+  __sync_synchronize();
+
+  // get event and advance cursor
+  const void *event = s->topic->ring + (s->cursor & (s->topic->capacity - 1)) * s->topic->size;
+  s->cursor++;
+
+  return event;
+}
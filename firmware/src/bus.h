@@ -0,0 +1,87 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  /**
+   * The statically allocated event ring.
+   */
+  uint8_t *ring;
+
+  /**
+   * The event size and the ring capacity (power of two).
+   */
+  size_t size, capacity;
+
+  /**
+   * The sequence of the next published event.
+   */
+  volatile uint32_t head;
+} bus_topic_t;
+
+typedef struct {
+  /**
+   * The subscribed topic.
+   */
+  bus_topic_t *topic;
+
+  /**
+   * The sequence of the next event to be read.
+   */
+  uint32_t cursor;
+
+  /**
+   * The number of events missed because the subscriber fell behind.
+   */
+  uint32_t dropped;
+} bus_sub_t;
+
+/**
+ * Define a topic for the specified event type with a static ring.
+ */
+#define BUS_TOPIC(name, type, cap)    \
+  static type name##_ring[cap];       \
+  bus_topic_t name = {.ring = (uint8_t *)name##_ring, .size = sizeof(type), .capacity = (cap), .head = 0}
+
+/**
+ * Claim the next slot of a topic to write an event in place. Each topic must have a single publisher.
+ *
+ * @param t The topic.
+ * @return The slot.
+ */
+void *bus_claim(bus_topic_t *t);
+
+/**
+ * Publish the previously claimed slot.
+ *
+ * @param t The topic.
+ */
+void bus_commit(bus_topic_t *t);
+
+/**
+ * Subscribe to a topic starting with the next published event.
+ *
+ * @param s The subscriber.
+ * @param t The topic.
+ */
+void bus_subscribe(bus_sub_t *s, bus_topic_t *t);
+
+/**
+ * Discard all pending events of a subscription. The dropped count is kept.
+ *
+ * @param s The subscriber.
+ */
+void bus_flush(bus_sub_t *s);
+
+/**
+ * Get the next event of a subscription. The event is read in place and remains valid until the publisher wraps
+ * around the ring.
+ *
+ * @param s The subscriber.
+ * @return The event or NULL if there are no new events.
+ */
+const void *bus_next(bus_sub_t *s);
+
+#endif  // BUS_H
@@ -0,0 +1,95 @@
+#include <string.h>
+
+#include "cmd.h"
+
+#define CMD_SLOTS 64
+
+static const cmd_t *cmd_table[CMD_SLOTS] = {0};
+
+static const cmd_t *cmd_list = NULL;
+static size_t cmd_num = 0;
+
+static uint32_t cmd_hash(const char *str) {
+  // calculate FNV-1a hash
+  uint32_t hash = 2166136261u;
+  while (*str != 0) {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static int cmd_count(const char *payload) {
+  // count space separated arguments
+  int count = 0;
+  bool in = false;
+  for (; *payload != 0; payload++) {
+    if (*payload == ' ') {
+      in = false;
+    } else if (!in) {
+      in = true;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+void cmd_init(const cmd_t *cmds, size_t num) {
+  // save list
+  cmd_list = cmds;
+  cmd_num = num;
+
+  // insert commands using linear probing
+  for (size_t i = 0; i < num && i < CMD_SLOTS; i++) {
+    uint32_t slot = cmd_hash(cmds[i].topic) % CMD_SLOTS;
+    while (cmd_table[slot] != NULL) {
+      slot = (slot + 1) % CMD_SLOTS;
+    }
+    cmd_table[slot] = &cmds[i];
+  }
+}
+
+void cmd_subscribe() {
+  // subscribe all topics
+  for (size_t i = 0; i < cmd_num; i++) {
+    if (cmd_list[i].scopes & CMD_LOCAL) {
+      naos_subscribe(cmd_list[i].topic, 0, NAOS_LOCAL);
+    }
+    if (cmd_list[i].scopes & CMD_GLOBAL) {
+      naos_subscribe(cmd_list[i].topic, 0, NAOS_GLOBAL);
+    }
+  }
+}
+
+bool cmd_dispatch(const char *topic, const char *payload, naos_scope_t scope, int state) {
+  // find command
+  const cmd_t *cmd = NULL;
+  for (uint32_t slot = cmd_hash(topic) % CMD_SLOTS; cmd_table[slot] != NULL; slot = (slot + 1) % CMD_SLOTS) {
+    if (strcmp(cmd_table[slot]->topic, topic) == 0) {
+      cmd = cmd_table[slot];
+      break;
+    }
+  }
+
+  // check command and scope
+  if (cmd == NULL || !(cmd->scopes & (scope == NAOS_LOCAL ? CMD_LOCAL : CMD_GLOBAL))) {
+    return false;
+  }
+
+  // check state
+  if (state < 0 || state >= 32 || !(cmd->states & (1u << state))) {
+    return false;
+  }
+
+  // validate payload
+  if (cmd_count(payload) < cmd->args) {
+    return false;
+  }
+
+  // call handler
+  cmd->handler(payload);
+
+  return true;
+}
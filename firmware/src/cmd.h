@@ -0,0 +1,72 @@
+#ifndef CMD_H
+#define CMD_H
+
+#include <naos.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CMD_LOCAL (1 << 0)
+#define CMD_GLOBAL (1 << 1)
+
+#define CMD_ANY 0xFFFFFFFF
+
+/**
+ * The command handler is called with the validated payload.
+ *
+ * @param payload The payload.
+ */
+typedef void (*cmd_handler_t)(const char *payload);
+
+typedef struct {
+  /**
+   * The command topic.
+   */
+  const char *topic;
+
+  /**
+   * The minimum number of space separated payload arguments.
+   */
+  int args;
+
+  /**
+   * The scopes the command is subscribed in (CMD_LOCAL and/or CMD_GLOBAL).
+   */
+  uint8_t scopes;
+
+  /**
+   * The states the command is accepted in as a bitmask of (1 << state) or CMD_ANY.
+   */
+  uint32_t states;
+
+  /**
+   * The command handler.
+   */
+  cmd_handler_t handler;
+} cmd_t;
+
+/**
+ * Initialize the command registry and build the topic hash table.
+ *
+ * @param cmds The command table.
+ * @param num The number of commands.
+ */
+void cmd_init(const cmd_t *cmds, size_t num);
+
+/**
+ * Subscribe all command topics.
+ */
+void cmd_subscribe();
+
+/**
+ * Dispatch a message to its command handler.
+ *
+ * @param topic The topic.
+ * @param payload The payload.
+ * @param scope The scope.
+ * @param state The current state, no command is accepted before the first state.
+ * @return Whether the message has been dispatched.
+ */
+bool cmd_dispatch(const char *topic, const char *payload, naos_scope_t scope, int state);
+
+#endif  // CMD_H
@@ -4,13 +4,17 @@
 #include <driver/timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
-#include <freertos/task.h>
-#include <naos.h>
 
 #include "dst.h"
+#include "raw.h"
+#include "sch.h"
+#include "trc.h"
 
 #define DST_RANGE_MIN 1
 #define DST_RANGE_MAX 300
+#define DST_US_PER_CM 58.7  // 29.3866996 us/cm
+#define DST_PULSE_MIN ((uint32_t)(DST_RANGE_MIN * DST_US_PER_CM))
+#define DST_PULSE_MAX ((uint32_t)(DST_RANGE_MAX * DST_US_PER_CM))
 #define DST_INTERVAL 100
 #define DST_TIMEOUT 2000
 
@@ -18,12 +22,18 @@
 #define DST_TIMER_NUM TIMER_0
 #define DST_TRIGGER_RMT_CHANNEL RMT_CHANNEL_0
 
-static dst_callback_t dst_callback;
+BUS_TOPIC(dst_bus, dst_event_t, 8);
 
 static QueueHandle_t dst_queue;
 
+static int dst_queue_peak = 0;
+
 static a32_smooth_t *dst_smooth;
 
+static sch_pt_t dst_pt;
+
+static volatile bool dst_simulated = false;
+
 static void dst_handler(void *_) {
   // track if we are currently reading
   static bool reading = false;
@@ -39,22 +49,43 @@ static void dst_handler(void *_) {
 
   // measure pulse if reading
   if (reading) {
+    // begin trace
+    trc_begin(TRC_ISR, 22);
+
     // get timer value and pause timer
     uint64_t value = 0;
     ESP_ERROR_CHECK(timer_get_counter_value(DST_TIMER_GROUP, DST_TIMER_NUM, &value));
     ESP_ERROR_CHECK(timer_pause(DST_TIMER_GROUP, DST_TIMER_NUM));
 
-    // calculate real distance
-    double distance = (double)value / 58.7;  // 29.3866996 us/cm
+    // record pulse width
+    uint32_t pulse = (uint32_t)value;
+    raw_record(RAW_DST, (int16_t)(pulse > INT16_MAX ? INT16_MAX : pulse));
 
-    // send distance if value is in acceptable range
-    if (distance >= DST_RANGE_MIN && distance <= DST_RANGE_MAX) {
-      xQueueSendFromISR(dst_queue, &distance, NULL);
+    // send pulse width if value is in acceptable range and the sensor is not simulated
+    if (!dst_simulated && pulse >= DST_PULSE_MIN && pulse <= DST_PULSE_MAX) {
+      xQueueSendFromISR(dst_queue, &pulse, NULL);
+      sch_signal_from_isr(&dst_pt);
     }
+
+    // end trace
+    trc_end(TRC_ISR, 22);
   }
 }
 
-static void dst_task(void *p) {
+static bool dst_receive(uint32_t *pulse) {
+  // clear signal so the next reading wakes the scheduler again
+  sch_take(&dst_pt);
+
+  // receive reading
+  return xQueueReceive(dst_queue, pulse, 0) == pdTRUE;
+}
+
+static void dst_thread(sch_pt_t *pt) {
+  // the reading is kept across awaits
+  static uint32_t pulse = 0;
+
+  SCH_BEGIN(pt);
+
   // loop forever
   for (;;) {
     // create rmt waveform item
@@ -69,31 +100,36 @@ static void dst_task(void *p) {
     ESP_ERROR_CHECK(rmt_write_items(DST_TRIGGER_RMT_CHANNEL, &item, 1, false));
 
     // wait for distance reading
-    double distance = 0;
-    if (xQueueReceive(dst_queue, &distance, DST_TIMEOUT / portTICK_PERIOD_MS) == pdFALSE) {
+    SCH_AWAIT(pt, dst_receive(&pulse), DST_TIMEOUT);
+    if (pt->timeout) {
       // try again if no reading was received after 2s
       continue;
     }
 
-    // smooth distance
-    distance = a32_smooth_update(dst_smooth, distance);
+    // track peak queue depth
+    int depth = (int)uxQueueMessagesWaiting(dst_queue) + 1;
+    if (depth > dst_queue_peak) {
+      dst_queue_peak = depth;
+    }
 
-    // call callback
-    naos_acquire();
-    dst_callback(distance);
-    naos_release();
+    // calculate real distance
+    double distance = (double)pulse / DST_US_PER_CM;
+
+    // smooth distance and publish event
+    dst_event_t *e = bus_claim(&dst_bus);
+    e->distance = a32_smooth_update(dst_smooth, distance);
+    bus_commit(&dst_bus);
 
     // wait for next reading
-    naos_delay(DST_INTERVAL);
+    SCH_DELAY(pt, DST_INTERVAL);
   }
-}
 
-void dst_init(dst_callback_t cb) {
-  // save callback
-  dst_callback = cb;
+  SCH_END(pt);
+}
 
+void dst_init() {
   // initialize queue
-  dst_queue = xQueueCreate(16, sizeof(double));
+  dst_queue = xQueueCreate(16, sizeof(uint32_t));
 
   // create smooth
   dst_smooth = a32_smooth_new(10);
@@ -150,6 +186,24 @@ void dst_init(dst_callback_t cb) {
   // attach handler
   ESP_ERROR_CHECK(gpio_isr_handler_add(GPIO_NUM_22, dst_handler, NULL));
 
-  // run async task
-  xTaskCreatePinnedToCore(&dst_task, "dst", 8192, NULL, 2, NULL, 1);
+  // add thread
+  sch_add(&dst_pt, dst_thread);
+}
+
+int dst_peak() { return dst_queue_peak; }
+
+void dst_simulate(bool on) {
+  // set flag
+  dst_simulated = on;
+}
+
+void dst_inject(double distance) {
+  // convert to pulse width
+  uint32_t pulse = (uint32_t)(distance * DST_US_PER_CM);
+
+  // send pulse width if value is in acceptable range
+  if (pulse >= DST_PULSE_MIN && pulse <= DST_PULSE_MAX) {
+    xQueueSend(dst_queue, &pulse, 0);
+    sch_signal(&dst_pt);
+  }
 }
@@ -1,18 +1,47 @@
 #ifndef DST_H
 #define DST_H
 
+#include <stdbool.h>
+
+#include "bus.h"
+
+typedef struct {
+  /**
+   * The smoothed distance in cm.
+   */
+  double distance;
+} dst_event_t;
+
 /**
- * The distance callback is called with new distance readings.
- *
- * @param d The distance.
+ * The topic that receives new distance readings.
  */
-typedef void (*dst_callback_t)(double d);
+extern bus_topic_t dst_bus;
 
 /**
  * Initialize ultra sonic distance sensor.
+ */
+void dst_init();
+
+/**
+ * Get the peak number of readings waiting in the queue.
+ *
+ * @return The peak queue depth.
+ */
+int dst_peak();
+
+/**
+ * Enable or disable the simulation of the sensor. While simulated, sensor readings are dropped and only injected
+ * readings are processed.
+ *
+ * @param on Whether the sensor is simulated.
+ */
+void dst_simulate(bool on);
+
+/**
+ * Inject a simulated reading. The reading passes the same range check and smoothing as a sensor reading.
  *
- * @param cb The distance callback.
+ * @param distance The raw distance in cm.
  */
-void dst_init(dst_callback_t cb);
+void dst_inject(double distance);
 
 #endif  // DST_H
@@ -1,25 +1,27 @@
 #include <driver/gpio.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
-#include <naos.h>
 
 #include "enc.h"
+#include "raw.h"
+#include "sch.h"
+#include "trc.h"
 
 // https://github.com/PaulStoffregen/Encoder/blob/master/Encoder.h
 
 #define ENC_RESOLUTION 20
 
-#define END_BIT (1 << 0)
+static sch_pt_t enc_pt;
 
-static EventGroupHandle_t enc_group;
-
-static enc_callback_t enc_callback;
+BUS_TOPIC(enc_bus, enc_event_t, 32);
 
 static volatile uint8_t enc_state = 0;
 
-static volatile int16_t enc_total = 0;
+static volatile int32_t enc_total = 0;
 
 static void enc_rotation_handler(void *_) {
+  // begin trace
+  trc_begin(TRC_ISR, 23);
+
   // read GPIOs
   int p1 = gpio_get_level(GPIO_NUM_23);
   int p2 = gpio_get_level(GPIO_NUM_25);
@@ -30,6 +32,9 @@ static void enc_rotation_handler(void *_) {
   if (p2) state |= 8;
   enc_state = (state >> 2);
 
+  // record transition
+  raw_record(RAW_ENC, state);
+
   // save relative change
   switch (state) {
     case 1:
@@ -61,53 +66,47 @@ static void enc_rotation_handler(void *_) {
     }
   }
 
-  // send event
-  xEventGroupSetBitsFromISR(enc_group, END_BIT, NULL);
+  // signal thread
+  sch_signal_from_isr(&enc_pt);
+
+  // end trace
+  trc_end(TRC_ISR, 23);
 }
 
 static double enc_get() {
   // prepare mutex
   static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 
-  // get saved total
+  // get cumulative total
   vTaskEnterCritical(&mux);
   double total = enc_total;
-  enc_total = 0;
   vTaskExitCritical(&mux);
 
   // calculate and return real rotation
   return total / ENC_RESOLUTION;
 }
 
-static void enc_task(void *p) {
+static void enc_thread(sch_pt_t *pt) {
+  SCH_BEGIN(pt);
+
   // loop forever
   for (;;) {
-    // wait for bit
-    EventBits_t bits = xEventGroupWaitBits(enc_group, END_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
-    if ((bits & END_BIT) != END_BIT) {
-      continue;
-    }
+    // wait for signal
+    SCH_SIGNAL(pt);
 
-    // call callback
-    naos_acquire();
-    enc_callback(enc_get());
-    naos_release();
+    // publish event
+    enc_event_t *e = bus_claim(&enc_bus);
+    e->rotations = enc_get();
+    bus_commit(&enc_bus);
 
     // wait for 1ms
-    naos_delay(1);
-
-    // clear bit
-    xEventGroupClearBits(enc_group, END_BIT);
+    SCH_DELAY(pt, 1);
   }
-}
 
-void enc_init(enc_callback_t cb) {
-  // save callback
-  enc_callback = cb;
-
-  // create mutex
-  enc_group = xEventGroupCreate();
+  SCH_END(pt);
+}
 
+void enc_init() {
   // configure rotation pins
   gpio_config_t rc;
   rc.pin_bit_mask = GPIO_SEL_23 | GPIO_SEL_25;
@@ -125,6 +124,6 @@ void enc_init(enc_callback_t cb) {
   gpio_isr_handler_add(GPIO_NUM_23, enc_rotation_handler, NULL);
   gpio_isr_handler_add(GPIO_NUM_25, enc_rotation_handler, NULL);
 
-  // run async task
-  xTaskCreatePinnedToCore(&enc_task, "enc", 8192, NULL, 2, NULL, 1);
+  // add thread
+  sch_add(&enc_pt, enc_thread);
 }
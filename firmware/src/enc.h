@@ -3,18 +3,24 @@
 
 #include <stdbool.h>
 
+#include "bus.h"
+
+typedef struct {
+  /**
+   * The total rotations measured since boot.
+   */
+  double rotations;
+} enc_event_t;
+
 /**
- * Callback is execute with rotational change up to a frequency of 1ms.
- *
- * @param r The measured rotations.
+ * The topic that receives the cumulative rotations up to a frequency of 1ms. Subscribers derive movement from the
+ * difference between totals so that overwritten events do not lose rotations.
  */
-typedef void (*enc_callback_t)(double r);
+extern bus_topic_t enc_bus;
 
 /**
  * Initialize the encoder sub system.
- *
- * @param cb The encoder callback.
  */
-void enc_init(enc_callback_t cb);
+void enc_init();
 
 #endif  // ENC_H
@@ -1,52 +1,51 @@
 #include <driver/gpio.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
 #include <naos.h>
 
 #include "end.h"
+#include "sch.h"
+#include "trc.h"
 
 #define END_DELAY 50
 
-#define END_BIT (1 << 0)
+static sch_pt_t end_pt;
 
-static EventGroupHandle_t end_group;
-
-static end_callback_t end_callback;
+BUS_TOPIC(end_bus, end_event_t, 8);
 
 static void end_handler(void *args) {
-  // send event
-  xEventGroupSetBitsFromISR(end_group, END_BIT, NULL);
+  // begin trace
+  trc_begin(TRC_ISR, 13);
+
+  // signal thread
+  sch_signal_from_isr(&end_pt);
+
+  // end trace
+  trc_end(TRC_ISR, 13);
 }
 
-static void end_task(void *p) {
+static void end_thread(sch_pt_t *pt) {
+  SCH_BEGIN(pt);
+
   // loop forever
   for (;;) {
-    // wait for bit
-    EventBits_t bits = xEventGroupWaitBits(end_group, END_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
-    if ((bits & END_BIT) != END_BIT) {
-      continue;
-    }
+    // wait for signal
+    SCH_SIGNAL(pt);
 
-    // call callback
-    naos_acquire();
-    end_callback();
-    naos_release();
+    // publish event
+    end_event_t *e = bus_claim(&end_bus);
+    e->time = naos_millis();
+    bus_commit(&end_bus);
 
     // delay next reading
-    naos_delay(END_DELAY);
+    SCH_DELAY(pt, END_DELAY);
 
-    // clear bit
-    xEventGroupClearBits(end_group, END_BIT);
+    // clear signal
+    sch_take(pt);
   }
-}
-
-void end_init(end_callback_t cb) {
-  // save callback
-  end_callback = cb;
 
-  // create mutex
-  end_group = xEventGroupCreate();
+  SCH_END(pt);
+}
 
+void end_init() {
   // prepare in a+b config
   gpio_config_t end = {.pin_bit_mask = GPIO_SEL_13,
                        .mode = GPIO_MODE_INPUT,
@@ -60,8 +59,8 @@ void end_init(end_callback_t cb) {
   // register interrupt handler
   gpio_isr_handler_add(GPIO_NUM_13, &end_handler, NULL);
 
-  // run async task
-  xTaskCreatePinnedToCore(&end_task, "end", 8192, NULL, 2, NULL, 1);
+  // add thread
+  sch_add(&end_pt, end_thread);
 }
 
 bool end_read() { return gpio_get_level(GPIO_NUM_13) == 1; }
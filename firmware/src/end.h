@@ -3,17 +3,24 @@
 
 #include <stdbool.h>
 
+#include "bus.h"
+
+typedef struct {
+  /**
+   * The time the end stop has been hit.
+   */
+  uint32_t time;
+} end_event_t;
+
 /**
- * The end stop callback.
+ * The topic that receives end stop events.
  */
-typedef void (*end_callback_t)();
+extern bus_topic_t end_bus;
 
 /**
  * Initialize the end stop system.
- *
- * @param cb The end stop callback.
  */
-void end_init(end_callback_t cb);
+void end_init();
 
 /**
  * Read end switch.
@@ -0,0 +1,88 @@
+#include <math.h>
+#include <string.h>
+
+#include "fld.h"
+
+#define FLD_PI 3.14159265358979323846
+
+static double fld_hash(int32_t x, int32_t y, int32_t z) {
+  // mix coordinates
+  uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u + (uint32_t)z * 2246822519u;
+  h = (h ^ (h >> 13)) * 1274126177u;
+  h = h ^ (h >> 16);
+
+  // map to -1 to 1
+  return (double)(h & 0xFFFF) / 32767.5 - 1;
+}
+
+static double fld_lerp(double a, double b, double t) { return a + (b - a) * t; }
+
+static double fld_noise(double x, double y, double z) {
+  // get lattice cell
+  double xf = floor(x);
+  double yf = floor(y);
+  double zf = floor(z);
+  int32_t xi = (int32_t)xf;
+  int32_t yi = (int32_t)yf;
+  int32_t zi = (int32_t)zf;
+
+  // get smoothed fractions
+  double u = x - xf;
+  double v = y - yf;
+  double w = z - zf;
+  u = u * u * (3 - 2 * u);
+  v = v * v * (3 - 2 * v);
+  w = w * w * (3 - 2 * w);
+
+  // interpolate corners
+  double x00 = fld_lerp(fld_hash(xi, yi, zi), fld_hash(xi + 1, yi, zi), u);
+  double x10 = fld_lerp(fld_hash(xi, yi + 1, zi), fld_hash(xi + 1, yi + 1, zi), u);
+  double x01 = fld_lerp(fld_hash(xi, yi, zi + 1), fld_hash(xi + 1, yi, zi + 1), u);
+  double x11 = fld_lerp(fld_hash(xi, yi + 1, zi + 1), fld_hash(xi + 1, yi + 1, zi + 1), u);
+
+  return fld_lerp(fld_lerp(x00, x10, v), fld_lerp(x01, x11, v), w);
+}
+
+fld_type_t fld_parse(const char *str) {
+  if (strcmp(str, "wave") == 0) {
+    return FLD_WAVE;
+  } else if (strcmp(str, "ripple") == 0) {
+    return FLD_RIPPLE;
+  } else if (strcmp(str, "noise") == 0) {
+    return FLD_NOISE;
+  }
+
+  return FLD_FLAT;
+}
+
+double fld_eval(fld_t f, double x, double y, uint32_t t) {
+  // check wavelength and period
+  if (f.wavelength <= 0 || f.period <= 0) {
+    return 0;
+  }
+
+  // calculate temporal phase
+  double phase = (double)t / f.period;
+
+  // evaluate field
+  double value = 0;
+  switch (f.type) {
+    case FLD_FLAT: {
+      break;
+    }
+    case FLD_WAVE: {
+      value = sin(2 * FLD_PI * (x / f.wavelength - phase));
+      break;
+    }
+    case FLD_RIPPLE: {
+      value = sin(2 * FLD_PI * (sqrt(x * x + y * y) / f.wavelength - phase));
+      break;
+    }
+    case FLD_NOISE: {
+      value = fld_noise(x / f.wavelength, y / f.wavelength, phase);
+      break;
+    }
+  }
+
+  return value * f.amplitude;
+}
@@ -0,0 +1,54 @@
+#ifndef FLD_H
+#define FLD_H
+
+#include <stdint.h>
+
+typedef enum {
+  FLD_FLAT,    // constant field
+  FLD_WAVE,    // plane wave along the x axis
+  FLD_RIPPLE,  // circular wave around the origin
+  FLD_NOISE,   // smooth value noise
+} fld_type_t;
+
+typedef struct {
+  /**
+   * The field type.
+   */
+  fld_type_t type;
+
+  /**
+   * The amplitude in cm.
+   */
+  double amplitude;
+
+  /**
+   * The spatial wavelength in cm.
+   */
+  double wavelength;
+
+  /**
+   * The temporal period in ms.
+   */
+  double period;
+} fld_t;
+
+/**
+ * Parse a field type name.
+ *
+ * @param str The name ("flat", "wave", "ripple" or "noise").
+ * @return The field type.
+ */
+fld_type_t fld_parse(const char *str);
+
+/**
+ * Evaluate a field at the specified location and time.
+ *
+ * @param f The field.
+ * @param x The x location in cm.
+ * @param y The y location in cm.
+ * @param t The time since field start in ms.
+ * @return The field value from -amplitude to +amplitude.
+ */
+double fld_eval(fld_t f, double x, double y, uint32_t t);
+
+#endif  // FLD_H
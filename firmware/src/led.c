@@ -1,14 +1,12 @@
+#include <art32/numbers.h>
 #include <driver/ledc.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/event_groups.h>
-#include <freertos/task.h>
 #include <naos.h>
 
 #include "led.h"
+#include "sch.h"
+#include "wht.h"
 
-#define LED_BIT (1 << 0)
-
-static EventGroupHandle_t led_group;
+static sch_pt_t led_pt;
 
 static led_color_t led_constant_color;
 static led_color_t led_fade_in_color;
@@ -17,7 +15,21 @@ static led_color_t led_fade_out_color;
 static int led_fade_time;
 static bool led_fade_out = false;
 
-static void led_write(led_color_t c, int t) {
+static bool led_extract = false;
+static int led_white_r = 1023;
+static int led_white_g = 1023;
+static int led_white_b = 1023;
+
+static led_color_t led_convert(led_color_t c) {
+  // extract white if enabled
+  if (!led_extract) {
+    return c;
+  }
+
+  return wht_extract(c, led_white_r, led_white_g, led_white_b);
+}
+
+static void led_start(led_color_t c, int t) {
   // set colors
   ESP_ERROR_CHECK(ledc_set_fade_with_time(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_1, (uint32_t)c.r, t));
   ESP_ERROR_CHECK(ledc_set_fade_with_time(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_2, (uint32_t)c.g, t));
@@ -29,10 +41,9 @@ static void led_write(led_color_t c, int t) {
   ESP_ERROR_CHECK(ledc_fade_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_2, LEDC_FADE_NO_WAIT));
   ESP_ERROR_CHECK(ledc_fade_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_3, LEDC_FADE_NO_WAIT));
   ESP_ERROR_CHECK(ledc_fade_start(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_4, LEDC_FADE_NO_WAIT));
+}
 
-  // await fade
-  naos_delay((uint32_t)t + 10);
-
+static void led_finish(led_color_t c) {
   // set colors
   ESP_ERROR_CHECK(ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_1, (uint32_t)c.r));
   ESP_ERROR_CHECK(ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_2, (uint32_t)c.g));
@@ -40,17 +51,24 @@ static void led_write(led_color_t c, int t) {
   ESP_ERROR_CHECK(ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_4, (uint32_t)c.w));
 }
 
-static void led_task(void *p) {
+static void led_thread(sch_pt_t *pt) {
+  // the fade is kept across awaits
+  static led_color_t color;
+  static int duration;
+
+  SCH_BEGIN(pt);
+
   // loop forever
   for (;;) {
-    // wait for bit
-    EventBits_t bits = xEventGroupWaitBits(led_group, LED_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
-    if ((bits & LED_BIT) != LED_BIT) {
-      continue;
-    }
+    // wait for signal
+    SCH_SIGNAL(pt);
 
     // perform fade in
-    led_write(led_fade_in_color, led_fade_time);
+    color = led_convert(led_fade_in_color);
+    duration = led_fade_time;
+    led_start(color, duration);
+    SCH_DELAY(pt, (uint32_t)duration + 10);
+    led_finish(color);
 
     // skip fade out if not needed
     if (!led_fade_out) {
@@ -58,14 +76,16 @@ static void led_task(void *p) {
     }
 
     // fade out
-    led_write(led_fade_out_color, led_fade_time);
+    color = led_convert(led_fade_out_color);
+    led_start(color, duration);
+    SCH_DELAY(pt, (uint32_t)duration + 10);
+    led_finish(color);
   }
+
+  SCH_END(pt);
 }
 
 void led_init() {
-  // create mutex
-  led_group = xEventGroupCreate();
-
   // install ledc fade service
   ESP_ERROR_CHECK(ledc_fade_func_install(0));
 
@@ -109,8 +129,16 @@ void led_init() {
   // reset led
   led_fade(led_mono(0), 100);
 
-  // run async task
-  xTaskCreatePinnedToCore(&led_task, "led", 8192, NULL, 2, NULL, 1);
+  // add thread
+  sch_add(&led_pt, led_thread);
+}
+
+void led_configure(bool extract, int r, int g, int b) {
+  // set calibration
+  led_extract = extract;
+  led_white_r = a32_constrain_i(r, 0, 1023);
+  led_white_g = a32_constrain_i(g, 0, 1023);
+  led_white_b = a32_constrain_i(b, 0, 1023);
 }
 
 void led_fade(led_color_t c, int t) {
@@ -120,8 +148,8 @@ void led_fade(led_color_t c, int t) {
   led_fade_time = t;
   led_fade_out = false;
 
-  // unlock led task
-  xEventGroupSetBits(led_group, LED_BIT);
+  // signal thread
+  sch_signal(&led_pt);
 }
 
 void led_flash(led_color_t c, int t) {
@@ -131,10 +159,12 @@ void led_flash(led_color_t c, int t) {
   led_fade_time = t / 2;
   led_fade_out = true;
 
-  // unlock led task
-  xEventGroupSetBits(led_group, LED_BIT);
+  // signal thread
+  sch_signal(&led_pt);
 }
 
+led_color_t led_get() { return led_constant_color; }
+
 led_color_t led_color(int r, int g, int b, int w) { return (led_color_t){r, g, b, w}; }
 
 led_color_t led_mono(int b) { return (led_color_t){b, b, b, b}; }
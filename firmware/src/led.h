@@ -1,6 +1,8 @@
 #ifndef LED_H
 #define LED_H
 
+#include <stdbool.h>
+
 typedef struct {
   /**
    * The individual channels in values from 0 to 1023.
@@ -13,6 +15,16 @@ typedef struct {
  */
 void led_init();
 
+/**
+ * Configure the extraction of the common white component of RGB colors into the white channel.
+ *
+ * @param extract Whether extraction is enabled.
+ * @param r The red output of the white channel at full duty from 0 to 1023.
+ * @param g The green output of the white channel at full duty from 0 to 1023.
+ * @param b The blue output of the white channel at full duty from 0 to 1023.
+ */
+void led_configure(bool extract, int r, int g, int b);
+
 /**
  * Set constant led color.
  *
@@ -29,6 +41,13 @@ void led_fade(led_color_t c, int t);
  */
 void led_flash(led_color_t c, int t);
 
+/**
+ * Get the current constant color.
+ *
+ * @return The color.
+ */
+led_color_t led_get();
+
 /**
  * Mix a color.
  *
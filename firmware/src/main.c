@@ -1,27 +1,57 @@
 #include <art32/motion.h>
 #include <art32/numbers.h>
-#include <art32/smooth.h>
 #include <driver/adc.h>
+#include <esp_system.h>
+#include <esp_wifi.h>
 #include <math.h>
 #include <naos.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "aut.h"
+#include "cmd.h"
 #include "dst.h"
 #include "enc.h"
 #include "end.h"
+#include "fld.h"
 #include "led.h"
 #include "mot.h"
+#include "now.h"
 #include "pir.h"
-
-#define WINDING_LENGTH 7.5
+#include "pub.h"
+#include "raw.h"
+#include "sch.h"
+#include "scn.h"
+#include "sum.h"
+#include "twn.h"
+#include "udp.h"
+#include "trc.h"
 
 #define CALIBRATION_SAMPLES 20
 #define CALIBRATION_TIMEOUT 1000 * 120
 #define CALIBRATION_LEEWAY 20
+#define CALIBRATION_SLOT 1000 * 180
+#define CALIBRATION_NEIGHBORS 8
 
 #define RESET_OFFSET 10
 
+#define FIELD_HEIGHT_THRESHOLD 0.5
+#define FIELD_LIGHT_THRESHOLD 4
+
+#define TRACE_CHUNK 64
+
+#define RAW_FRAME 1024
+
+#define PROFILE_PAIRS 16
+
+#define REPORT_DELAY 500
+
+#define ALIVE_INTERVAL 10000
+
+// the heartbeats with bank zero sent after connecting or clearing the bank to remove the light from the supply
+#define ALIVE_ZERO 3
+
 #define COLOR_OFFLINE led_color(127, 0, 0, 0)
 #define COLOR_CALIBRATE led_color(0, 0, 127, 0)
 #define COLOR_MOVE led_color(0, 127, 0, 0)
@@ -36,10 +66,15 @@ typedef enum {
   MOVE,       // move up, down to position
   AUTOMATE,   // moves according to sensors
   RESET,      // resets position
+  FIELD,      // follows a generative field
+  STREAM,     // follows streamed frames
 } state_t;
 
 state_t state = -1;
 
+static uint32_t state_since = 0;
+static uint32_t state_time[STREAM + 1] = {0};
+
 /* parameters */
 
 static bool debug = false;
@@ -57,6 +92,48 @@ static int pir_low = 0;
 static int pir_high = 0;
 static int pir_interval = 0;
 static int calib_interval = 0;
+static double field_x = 0;
+static double field_y = 0;
+static int field_rate = 0;
+static bool remote_automate = false;
+static int remote_budget = 0;
+static bool simulate = false;
+static int health_interval = 0;
+static int raw_rate = 0;
+static bool coalesce = false;
+static int coalesce_time = 0;
+static double winding_length = 0;
+static double mot_up_gain = 0;
+static double mot_up_offset = 0;
+static double mot_down_gain = 0;
+static double mot_down_offset = 0;
+static double creep_speed = 0;
+static double target_deadband = 0;
+static double target_hysteresis = 0;
+static double target_rate = 0;
+static int target_dwell = 0;
+static int summary_interval = 0;
+static bool raw_events = false;
+static int calib_quiet = 0;
+static int calib_jitter = 0;
+static int calib_deadline = 0;
+static int calib_max = 0;
+static bool twin = false;
+static double twin_bound = 0;
+static int group = 0;
+static bool now_fallback = false;
+static int stream_slot = 0;
+static int stream_port = 0;
+static char *stream_group = NULL;
+static int supply_bank = 0;
+static bool white_extract = false;
+static int white_r = 0;
+static int white_g = 0;
+static int white_b = 0;
+
+static const char *profile_params[] = {"approach-range",  "approach-target",   "idle-height", "base-height",
+                                       "rise-height",     "pir-low",           "pir-high",    "pir-interval",
+                                       "target-deadband", "target-hysteresis", "target-rate", "target-dwell"};
 
 /* variables */
 
@@ -66,8 +143,155 @@ static double position = 0;
 static double usage = 0;
 static double move_to = 0;
 static bool calibrated = false;
-static a32_smooth_t *calibration_data = NULL;
+static bool calibration_active = false;
+static double calibration_samples[CALIBRATION_SAMPLES] = {0};
+static int calibration_count = 0;
+static int calibration_index = 0;
 static uint32_t calibration_timeout = 0;
+static fld_t field = {0};
+static double field_height = 0;
+static uint32_t field_start = 0;
+static uint32_t field_frame = 0;
+static double field_target = 0;
+static int field_light = 0;
+static int pir_value = 0;
+static double remote_target = 0;
+static uint32_t remote_time = 0;
+static bus_sub_t pir_sub;
+static bus_sub_t end_sub;
+static bus_sub_t enc_sub;
+static bus_sub_t dst_sub;
+static bus_sub_t now_sub;
+static bus_sub_t udp_sub;
+static double enc_rotations = 0;
+static int scene_pending = -1;
+static uint32_t scene_at = 0;
+static aut_filter_t target_filter = {0};
+static int automate_override = -1;
+static sum_stat_t position_stat = {0};
+static sum_stat_t distance_stat = {0};
+static uint32_t motion_since = 0;
+static uint32_t motion_time = 0;
+static bool approaching = false;
+static uint32_t approaches = 0;
+static uint32_t summary_reversals = 0;
+static uint32_t summary_state_time[STREAM + 1] = {0};
+static uint32_t motion_end = 0;
+static bool calibration_due = false;
+static uint32_t calibration_due_at = 0;
+static uint32_t calibration_delay = 0;
+static uint32_t calibration_neighbors[CALIBRATION_NEIGHBORS] = {0};
+static twn_plan_t twin_plan = {0};
+static uint32_t neighbor_at = 0;
+static bool report_due = false;
+static uint32_t report_at = 0;
+static uint32_t param_writes = 0;
+static char alive_id[16] = {0};
+static int alive_zero = 0;
+static double stream_target = 0;
+static udp_event_t stream_frame = {0};
+
+/* publishing */
+
+static void publish(const char *topic, const char *value) {
+  // buffer or publish value
+  if (coalesce) {
+    pub_add(topic, value);
+  } else {
+    naos_publish(topic, value, 0, false, NAOS_LOCAL);
+  }
+}
+
+static void publish_d(const char *topic, double value) {
+  // buffer or publish value
+  if (coalesce) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%f", value);
+    pub_add(topic, buf);
+  } else {
+    naos_publish_d(topic, value, 0, false, NAOS_LOCAL);
+  }
+}
+
+static void publish_b(const char *topic, bool value) {
+  // buffer or publish value
+  if (coalesce) {
+    pub_add(topic, value ? "1" : "0");
+  } else {
+    naos_publish_b(topic, value, 0, false, NAOS_LOCAL);
+  }
+}
+
+/* calibration */
+
+static bool calibration_result(double *mean) {
+  // check sample count
+  if (calibration_count < CALIBRATION_SAMPLES) {
+    return false;
+  }
+
+  // calculate range and total
+  double min = calibration_samples[0];
+  double max = calibration_samples[0];
+  double total = 0;
+  for (int i = 0; i < CALIBRATION_SAMPLES; i++) {
+    min = fmin(min, calibration_samples[i]);
+    max = fmax(max, calibration_samples[i]);
+    total += calibration_samples[i];
+  }
+
+  // check error
+  if (max - min >= 2) {
+    return false;
+  }
+
+  // set mean
+  *mean = total / CALIBRATION_SAMPLES;
+
+  return true;
+}
+
+static bool calibration_ready() {
+  // get time
+  uint32_t now = naos_millis();
+
+  // force calibration once the deadline has passed
+  if (calib_deadline > 0 && now - calibration_due_at >= (uint32_t)calib_deadline) {
+    return true;
+  }
+
+  // wait until the motion sensor has been quiet long enough
+  if (motion || now - motion_end < (uint32_t)calib_quiet + calibration_delay) {
+    return false;
+  }
+
+  // count neighbors that announced a calibration recently
+  int busy = 0;
+  for (int i = 0; i < CALIBRATION_NEIGHBORS; i++) {
+    if (calibration_neighbors[i] != 0 && now - calibration_neighbors[i] < CALIBRATION_SLOT) {
+      busy++;
+    }
+  }
+
+  return calib_max <= 0 || busy < calib_max;
+}
+
+/* automation */
+
+static bool automating() {
+  // prefer volatile override over persisted parameter
+  return automate_override >= 0 ? automate_override == 1 : automate;
+}
+
+static aut_config_t automation() {
+  return (aut_config_t){.approach_range = approach_range,
+                        .approach_target = approach_target,
+                        .idle_height = idle_height,
+                        .base_height = base_height,
+                        .rise_height = rise_height,
+                        .pir_low = pir_low,
+                        .pir_high = pir_high};
+}
 
 /* state machine */
 
@@ -85,6 +309,10 @@ static const char *state_str(state_t s) {
       return "AUTOMATE";
     case RESET:
       return "RESET";
+    case FIELD:
+      return "FIELD";
+    case STREAM:
+      return "STREAM";
     default:
       return "UNKNOWN";
   }
@@ -129,13 +357,10 @@ static void state_transition(state_t new_state) {
         led_fade(COLOR_CALIBRATE, 100);
       }
 
-      // free existing calibration
-      if (calibration_data != NULL) {
-        a32_smooth_free(calibration_data);
-      }
-
-      // create new calibration
-      calibration_data = a32_smooth_new(CALIBRATION_SAMPLES);
+      // reset calibration
+      calibration_active = true;
+      calibration_count = 0;
+      calibration_index = 0;
 
       // save current time
       calibration_timeout = naos_millis() + CALIBRATION_TIMEOUT;
@@ -166,6 +391,9 @@ static void state_transition(state_t new_state) {
       // enable idle light
       led_fade(led_mono(idle_light), 100);
 
+      // reset target filter
+      target_filter.ready = false;
+
       break;
     }
 
@@ -183,37 +411,73 @@ static void state_transition(state_t new_state) {
 
       break;
     }
+
+    case FIELD: {
+      // reset field start and force evaluation
+      field_start = naos_millis();
+      field_frame = 0;
+      field_target = position;
+      field_light = -1;
+
+      break;
+    }
+
+    case STREAM: {
+      // hold position until the first frame arrives and force color update
+      stream_target = position;
+      stream_frame.red = -1;
+
+      break;
+    }
+  }
+
+  // track time spent in previous state
+  uint32_t now = naos_millis();
+  if ((int)state >= 0) {
+    state_time[state] += now - state_since;
   }
+  state_since = now;
 
   // set new state
   state = new_state;
 
   // publish new state
-  naos_publish("state", state_str(state), 0, false, NAOS_LOCAL);
+  trc_begin(TRC_PUBLISH, 3);
+  publish("state", state_str(state));
+  trc_end(TRC_PUBLISH, 3);
 
   // feed state machine
   state_feed();
 }
 
 static void state_feed() {
+  // begin trace
+  trc_begin(TRC_FEED, (uint16_t)state);
+
   // publish update if position changed more than 1cm
   static double _position = 0;
-  if (position > _position + 1 || position < _position - 1) {
-    naos_publish_d("position", position, 0, false, NAOS_LOCAL);
+  if (raw_events && !twin && (position > _position + 1 || position < _position - 1)) {
+    trc_begin(TRC_PUBLISH, 0);
+    publish_d("position", position);
+    trc_end(TRC_PUBLISH, 0);
     _position = position;
   }
 
   // publish update if distance changed more than 2cm
   static double _distance = 0;
-  if (distance > _distance + 2 || distance < _distance - 2) {
-    naos_publish_d("distance", distance, 0, false, NAOS_LOCAL);
+  if (raw_events && (distance > _distance + 2 || distance < _distance - 2)) {
+    trc_begin(TRC_PUBLISH, 1);
+    publish_d("distance", distance);
+    trc_end(TRC_PUBLISH, 1);
     _distance = distance;
   }
 
   // publish update if motion has changed
   static bool _motion = false;
-  if (motion != _motion) {
-    naos_publish_b("motion", motion, 0, false, NAOS_LOCAL);
+  if (raw_events && motion != _motion) {
+    trc_begin(TRC_PUBLISH, 2);
+    publish_b("motion", motion);
+    trc_end(TRC_PUBLISH, 2);
     _motion = motion;
   }
 
@@ -226,14 +490,15 @@ static void state_feed() {
 
     case CALIBRATE: {
       // perform physical calibration if automate is on and timeout has been reached
-      if (automate && calibration_timeout < naos_millis()) {
+      if (automating() && calibration_timeout < naos_millis()) {
         mot_approach(position, 1000, 1);
         break;
       }
 
       // calibrate if we have all samples and error is within 2cm
-      if (calibration_data->count == CALIBRATION_SAMPLES && calibration_data->max - calibration_data->min < 2) {
-        position = calibration_data->total / calibration_data->num;
+      double mean = 0;
+      if (calibration_result(&mean)) {
+        position = mean;
         calibrated = true;
         state_transition(STANDBY);
         break;
@@ -250,7 +515,7 @@ static void state_feed() {
       }
 
       // transition to automate if enabled
-      if (automate) {
+      if (automating()) {
         state_transition(AUTOMATE);
         break;
       }
@@ -270,20 +535,38 @@ static void state_feed() {
 
     case AUTOMATE: {
       // transition back to standby if disabled
-      if (!automate) {
+      if (!automating()) {
         state_transition(STANDBY);
         break;
       }
 
-      // default target to idle height
-      double target = idle_height;
+      // use remote target if it arrived within the latency budget, otherwise calculate local target
+      double target = 0;
+      if (remote_automate && remote_time != 0 && naos_millis() - remote_time <= (uint32_t)remote_budget) {
+        target = remote_target;
+      } else {
+        target = aut_target(automation(), position, distance, motion);
 
-      // check if we have motion or something below
-      if (motion || distance < approach_range) {
-        // approach object
-        target = a32_constrain_d(position + (-distance + approach_target), base_height, rise_height);
+        // rise to base height if a neighbor recently detected motion
+        if (neighbor_at != 0 && naos_millis() - neighbor_at < (uint32_t)pir_interval) {
+          target = a32_constrain_d(target, base_height, rise_height);
+        }
       }
 
+      // count approaches
+      bool approach = motion || distance < approach_range;
+      if (approach && !approaching) {
+        approaches++;
+      }
+      approaching = approach;
+
+      // condition target
+      target_filter.deadband = target_deadband;
+      target_filter.hysteresis = target_hysteresis;
+      target_filter.rate = target_rate;
+      target_filter.dwell = (uint32_t)target_dwell;
+      target = aut_filter(&target_filter, target, naos_millis());
+
       // approach new target
       mot_approach(position, target, 1);
 
@@ -300,119 +583,720 @@ static void state_feed() {
 
       break;
     }
+
+    case FIELD: {
+      // evaluate field once per frame
+      if (field_frame == 0 || naos_millis() - field_frame >= (uint32_t)field_rate) {
+        field_frame = naos_millis();
+
+        // evaluate field at own location
+        double value = fld_eval(field, field_x, field_y, field_frame - field_start);
+
+        // update target if changed significantly
+        double target = a32_constrain_d(field_height + value, idle_height, reset_height - RESET_OFFSET);
+        if (fabs(target - field_target) > FIELD_HEIGHT_THRESHOLD) {
+          field_target = target;
+        }
+
+        // update light if changed significantly
+        int light = idle_light;
+        if (field.amplitude > 0) {
+          light = a32_constrain_i(idle_light + (int)(value / field.amplitude * idle_light), 0, 1023);
+        }
+        if (abs(light - field_light) > FIELD_LIGHT_THRESHOLD) {
+          led_fade(led_mono(light), field_rate);
+          field_light = light;
+        }
+      }
+
+      // approach field target
+      mot_approach(position, field_target, 1);
+
+      break;
+    }
+
+    case STREAM: {
+      // approach streamed target
+      mot_approach(position, stream_target, 1);
+
+      break;
+    }
   }
+
+  // end trace
+  trc_end(TRC_FEED, (uint16_t)state);
 }
 
 /* naos callbacks */
 
+static void events();
+static void pir(int m);
+static void neighbor(const now_event_t *e);
+static void report();
+
+static void dump() {
+  // prepare chunk with header (time, index, count) and events
+  static uint8_t chunk[8 + TRACE_CHUNK * sizeof(trc_event_t)];
+  uint16_t index = 0;
+
+  for (;;) {
+    // collect events
+    size_t count = trc_collect((trc_event_t *)(chunk + 8), TRACE_CHUNK);
+
+    // write header
+    uint32_t now = trc_now();
+    uint16_t num = (uint16_t)count;
+    memcpy(chunk, &now, 4);
+    memcpy(chunk + 4, &index, 2);
+    memcpy(chunk + 6, &num, 2);
+
+    // publish chunk
+    naos_publish_r("trace-data", chunk, 8 + count * sizeof(trc_event_t), 0, false, NAOS_LOCAL);
+    index++;
+
+    // stop after last chunk
+    if (count < TRACE_CHUNK) {
+      break;
+    }
+  }
+}
+
+static void health() {
+  // get time spent in states including the current state
+  uint32_t t[STREAM + 1];
+  memcpy(t, state_time, sizeof(t));
+  if ((int)state >= 0) {
+    t[state] += naos_millis() - state_since;
+  }
+
+  // get dropped events
+  uint32_t dropped =
+      pir_sub.dropped + end_sub.dropped + enc_sub.dropped + dst_sub.dropped + now_sub.dropped + udp_sub.dropped;
+
+  // publish report
+  static char buf[384];
+  snprintf(buf, sizeof(buf),
+           "uptime=%u heap=%u min-heap=%u stack=%u queue=%d dropped=%u frames-dropped=%u saved=%u flash=%u "
+           "offline=%u calibrate=%u standby=%u move=%u automate=%u reset=%u field=%u stream=%u",
+           (unsigned int)naos_millis(), (unsigned int)esp_get_free_heap_size(),
+           (unsigned int)esp_get_minimum_free_heap_size(), (unsigned int)sch_stack(), dst_peak(),
+           (unsigned int)dropped, (unsigned int)udp_dropped(), (unsigned int)pub_saved(), (unsigned int)(scn_writes() + param_writes),
+           (unsigned int)t[OFFLINE], (unsigned int)t[CALIBRATE], (unsigned int)t[STANDBY], (unsigned int)t[MOVE],
+           (unsigned int)t[AUTOMATE], (unsigned int)t[RESET], (unsigned int)t[FIELD], (unsigned int)t[STREAM]);
+  naos_publish("health", buf, 0, false, NAOS_LOCAL);
+}
+
+static void summary() {
+  // get time spent in states during the window including the current state
+  uint32_t now = naos_millis();
+  uint32_t t[STREAM + 1];
+  for (int i = 0; i <= STREAM; i++) {
+    t[i] = state_time[i] - summary_state_time[i];
+    summary_state_time[i] = state_time[i];
+  }
+  if ((int)state >= 0) {
+    t[state] += now - state_since;
+    summary_state_time[state] += now - state_since;
+  }
+
+  // get motion duration including the current motion
+  uint32_t mt = motion_time;
+  if (motion) {
+    mt += now - motion_since;
+    motion_since = now;
+  }
+
+  // format position and distance statistics
+  static char buf[400];
+  int n = sum_format(&position_stat, "position", buf, sizeof(buf));
+  buf[n++] = ' ';
+  n += sum_format(&distance_stat, "distance", buf + n, sizeof(buf) - n);
+
+  // get motor reversals during the window
+  uint32_t reversals = mot_reversals() - summary_reversals;
+  summary_reversals += reversals;
+
+  // format motion, approaches, reversals and states
+  snprintf(buf + n, sizeof(buf) - n,
+           " motion=%u approaches=%u reversals=%u offline=%u calibrate=%u standby=%u move=%u automate=%u reset=%u "
+           "field=%u stream=%u",
+           (unsigned int)mt, (unsigned int)approaches, (unsigned int)reversals, (unsigned int)t[OFFLINE],
+           (unsigned int)t[CALIBRATE], (unsigned int)t[STANDBY], (unsigned int)t[MOVE], (unsigned int)t[AUTOMATE],
+           (unsigned int)t[RESET], (unsigned int)t[FIELD], (unsigned int)t[STREAM]);
+
+  // publish summary
+  naos_publish("summary", buf, 0, false, NAOS_LOCAL);
+
+  // reset window
+  sum_reset(&position_stat);
+  sum_reset(&distance_stat);
+  motion_time = 0;
+  approaches = 0;
+}
+
+static void plan() {
+  // get current target and velocity
+  uint32_t now = naos_millis();
+  double target = position;
+  double velocity = 0;
+  mot_status(&target, &velocity);
+
+  // keep plan while target and prediction are within the bound
+  if (fabs(target - twin_plan.target) <= twin_bound && fabs(position - twn_predict(&twin_plan, now)) <= twin_bound) {
+    return;
+  }
+
+  // set new plan
+  twin_plan = (twn_plan_t){.start = now,
+                           .position = position,
+                           .velocity = velocity,
+                           .target = target,
+                           .max_velocity = MOT_MAX_VELOCITY,
+                           .max_acceleration = MOT_MAX_ACCELERATION};
+
+  // publish plan
+  char buf[96];
+  snprintf(buf, sizeof(buf), "%u %.2f %.5f %.2f %.5f %.7f", (unsigned int)twin_plan.start, twin_plan.position,
+           twin_plan.velocity, twin_plan.target, twin_plan.max_velocity, twin_plan.max_acceleration);
+  naos_publish("plan", buf, 0, false, NAOS_LOCAL);
+}
+
+static void recall(int slot) {
+  // get scene
+  scn_t s;
+  if (!scn_get(slot, &s)) {
+    return;
+  }
+
+  // fade color
+  led_fade(s.color, s.time);
+
+  // set volatile automate
+  automate_override = s.automate ? 1 : 0;
+
+  // move to height if not automating and calibrated
+  if (!s.automate && calibrated) {
+    move_to = a32_constrain_d(s.height, idle_height, reset_height);
+    state_transition(MOVE);
+  }
+}
+
 static void ping() {
   // flash white
   led_flash(led_white(512), 100);
 }
 
 static void online() {
-  // subscribe local topics
-  naos_subscribe("move", 0, NAOS_LOCAL);
-  naos_subscribe("stop", 0, NAOS_LOCAL);
-  naos_subscribe("fade", 0, NAOS_LOCAL);
-  naos_subscribe("flash", 0, NAOS_LOCAL);
-  naos_subscribe("calibrate", 0, NAOS_LOCAL);
+  // initialize esp-now
+  now_init();
+
+  // subscribe commands
+  cmd_subscribe();
+
+  // start frame receiver
+  udp_start(stream_group, stream_port, stream_slot);
+
+  // get heartbeat id
+  uint8_t mac[6] = {0};
+  esp_wifi_get_mac(ESP_IF_WIFI_STA, mac);
+  snprintf(alive_id, sizeof(alive_id), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  alive_zero = ALIVE_ZERO;
+
+  // report configuration
+  report();
+
+  // discard events received while offline, the encoder keeps its subscription as its totals are cumulative
+  bus_flush(&pir_sub);
+  bus_flush(&end_sub);
+  bus_flush(&dst_sub);
+  bus_flush(&now_sub);
+  bus_flush(&udp_sub);
 
   // transition to standby
   state_transition(STANDBY);
 }
 
 static void offline() {
+  // stop frame receiver
+  udp_stop();
+
   // transition into offline state
   state_transition(OFFLINE);
 }
 
 static void update(const char *param, const char *value) {
+  // count parameter write
+  param_writes++;
+
+  // clear volatile automate if parameter has been set
+  if (strcmp(param, "automate") == 0) {
+    automate_override = -1;
+  }
+
+  // announce a cleared supply bank
+  if (strcmp(param, "supply-bank") == 0) {
+    alive_zero = ALIVE_ZERO;
+  }
+
+  // report configuration once updates settled
+  report_due = true;
+  report_at = naos_millis();
+
+  // restart frame receiver if configuration changed
+  if (strncmp(param, "stream-", 7) == 0) {
+    udp_start(stream_group, stream_port, stream_slot);
+  }
+
+  // update motor model
+  mot_configure(mot_up_gain, mot_up_offset, mot_down_gain, mot_down_offset, creep_speed);
+
+  // update sensor simulation
+  dst_simulate(simulate);
+
+  // update white extraction
+  led_configure(white_extract, white_r, white_g, white_b);
+
   // feed state machine
   state_feed();
 }
 
 static void message(const char *topic, uint8_t *payload, size_t len, naos_scope_t scope) {
-  // check for "move" command
-  if (strcmp(topic, "move") == 0 && scope == NAOS_LOCAL) {
-    // set target
-    if (strcmp((const char *)payload, "up") == 0) {
-      move_to = 1000;
-    } else if (strcmp((const char *)payload, "down") == 0) {
-      move_to = -1000;
-    } else {
-      move_to = a32_constrain_d(strtod((const char *)payload, NULL), idle_height, reset_height);
+  // dispatch command
+  cmd_dispatch(topic, (const char *)payload, scope, state);
+}
+
+static void loop() {
+  // handle events
+  events();
+
+  // persist changed scenes
+  scn_flush(false);
+
+  // recall scheduled scene once no reset is being performed
+  if (scene_pending >= 0 && (int32_t)(naos_millis() - scene_at) >= 0 && state != RESET) {
+    int slot = scene_pending;
+    scene_pending = -1;
+    recall(slot);
+  }
+
+  // publish health report
+  static uint32_t last_health = 0;
+  if (health_interval > 0 && naos_millis() - last_health >= (uint32_t)health_interval) {
+    last_health = naos_millis();
+    health();
+  }
+
+  // perform due calibration once quiet and no reset is being performed
+  if (calibration_due && state != RESET && state != CALIBRATE && calibration_ready()) {
+    calibration_due = false;
+    usage = 0;
+    naos_publish("calibrating", alive_id, 0, false, NAOS_GLOBAL);
+    state_transition(CALIBRATE);
+  }
+
+  // publish heartbeat for the supply watchdog, without a bank only a few times to be removed
+  static uint32_t last_alive = 0;
+  if ((supply_bank > 0 || alive_zero > 0) && naos_millis() - last_alive >= ALIVE_INTERVAL) {
+    last_alive = naos_millis();
+    if (supply_bank == 0) {
+      alive_zero--;
     }
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%s %d", alive_id, supply_bank);
+    naos_publish("alive", buf, 0, false, NAOS_GLOBAL);
+  }
 
-    // change state if safe
-    if (state != RESET) {
-      state_transition(MOVE);
-      return;
+  // sample position once per tick so the summary also covers a stationary light
+  sum_add(&position_stat, position);
+
+  // publish summary
+  static uint32_t last_summary = 0;
+  if (summary_interval > 0 && naos_millis() - last_summary >= (uint32_t)summary_interval) {
+    last_summary = naos_millis();
+    summary();
+  }
+
+  // stream raw samples
+  static uint32_t last_raw = 0;
+  if (raw_rate > 0 && naos_millis() - last_raw >= 1000 / (uint32_t)raw_rate) {
+    last_raw = naos_millis();
+    static uint8_t frame[RAW_FRAME];
+    size_t len = raw_frame(frame, sizeof(frame));
+    if (len > 0) {
+      naos_publish_r("raw-data", frame, len, 0, false, NAOS_LOCAL);
     }
   }
 
-  // check for "stop" command
-  else if (strcmp(topic, "stop") == 0 && scope == NAOS_LOCAL) {
-    // disable automate
-    naos_set_b("automate", false);
+  // feed state machine
+  state_feed();
+
+  // report changed configuration
+  if (report_due && naos_millis() - report_at >= REPORT_DELAY) {
+    report();
+  }
+
+  // publish motion plan
+  if (twin) {
+    plan();
+  }
 
-    // change state if safe
-    if (state != RESET) {
-      state_transition(STANDBY);
-      return;
+  // flush coalesced publishes
+  if (pub_due(coalesce ? (uint32_t)coalesce_time : 0)) {
+    pub_flush();
+  }
+}
+
+/* commands */
+
+static void cmd_move(const char *payload) {
+  // set target
+  if (strcmp(payload, "up") == 0) {
+    move_to = 1000;
+  } else if (strcmp(payload, "down") == 0) {
+    move_to = -1000;
+  } else {
+    move_to = a32_constrain_d(strtod(payload, NULL), idle_height, reset_height);
+  }
+
+  // change state
+  state_transition(MOVE);
+}
+
+static void cmd_stop(const char *payload) {
+  // disable automate without persisting
+  automate_override = 0;
+
+  // change state
+  state_transition(STANDBY);
+}
+
+static void cmd_fade(const char *payload) {
+  // read colors and time
+  int red = 0;
+  int green = 0;
+  int blue = 0;
+  int white = 0;
+  int time = 0;
+  sscanf(payload, "%d %d %d %d %d", &red, &green, &blue, &white, &time);
+
+  // fade color
+  if (!debug || (state == STANDBY || state == AUTOMATE)) {
+    led_fade(led_color(red, green, blue, white), time);
+  }
+}
+
+static void cmd_flash(const char *payload) {
+  // read colors and time
+  int red = 0;
+  int green = 0;
+  int blue = 0;
+  int white = 0;
+  int time = 0;
+  sscanf(payload, "%d %d %d %d %d", &red, &green, &blue, &white, &time);
+
+  // flash color
+  led_flash(led_color(red, green, blue, white), time);
+}
+
+static void cmd_calibrate(const char *payload) {
+  // clear due calibration
+  calibration_due = false;
+  usage = 0;
+
+  // change state
+  state_transition(CALIBRATE);
+}
+
+static void cmd_calibrating(const char *payload) {
+  // ignore own announcement
+  if (strcmp(payload, alive_id) == 0) {
+    return;
+  }
+
+  // replace oldest neighbor announcement
+  int oldest = 0;
+  for (int i = 1; i < CALIBRATION_NEIGHBORS; i++) {
+    if (naos_millis() - calibration_neighbors[i] > naos_millis() - calibration_neighbors[oldest]) {
+      oldest = i;
     }
   }
+  calibration_neighbors[oldest] = naos_millis();
+}
+
+static void cmd_field(const char *payload) {
+  // read type, height, amplitude, wavelength, period and optional phase
+  char type[8] = {0};
+  double height = 0;
+  double amplitude = 0;
+  double wavelength = 0;
+  double period = 0;
+  unsigned int phase = 0;
+  sscanf(payload, "%7s %lf %lf %lf %lf %u", type, &height, &amplitude, &wavelength, &period, &phase);
+
+  // set field
+  field = (fld_t){.type = fld_parse(type), .amplitude = amplitude, .wavelength = wavelength, .period = period};
+  field_height = height;
+
+  // change state if calibrated
+  if (calibrated) {
+    state_transition(FIELD);
+  }
+
+  // align field time with the sender so all lights share the same phase
+  field_start = naos_millis() - phase;
+  field_frame = 0;
+}
+
+static void cmd_target(const char *payload) {
+  // read target and sensor timestamp
+  double target = 0;
+  unsigned int stamp = 0;
+  sscanf(payload, "%lf %u", &target, &stamp);
+
+  // default to receive time if no timestamp has been provided
+  if (stamp == 0) {
+    stamp = naos_millis();
+  }
 
-  // check for "fade" command
-  else if (strcmp(topic, "fade") == 0 && scope == NAOS_LOCAL) {
-    // read colors and time
-    int red = 0;
-    int green = 0;
-    int blue = 0;
-    int white = 0;
-    int time = 0;
-    sscanf((const char *)payload, "%d %d %d %d %d", &red, &green, &blue, &white, &time);
+  // ignore targets that missed the latency budget
+  if (naos_millis() - stamp > (uint32_t)remote_budget) {
+    return;
+  }
 
-    // fade color
-    if (!debug || (state == STANDBY || state == AUTOMATE)) {
-      led_fade(led_color(red, green, blue, white), time);
+  // set remote target
+  remote_target = a32_constrain_d(target, idle_height, reset_height - RESET_OFFSET);
+  remote_time = stamp;
+}
+
+static void cmd_profile(const char *payload) {
+  // reject oversize payloads
+  static char buf[256];
+  if (strlen(payload) >= sizeof(buf)) {
+    naos_log("profile: payload too long");
+    return;
+  }
+  strcpy(buf, payload);
+
+  // collect and validate all "name=value" pairs
+  char *names[PROFILE_PAIRS];
+  char *values[PROFILE_PAIRS];
+  int count = 0;
+  for (char *pair = strtok(buf, " "); pair != NULL; pair = strtok(NULL, " ")) {
+    // split pair
+    char *value = strchr(pair, '=');
+    if (value == NULL || count == PROFILE_PAIRS) {
+      naos_log("profile: invalid pair '%s'", pair);
+      return;
     }
+    *value = 0;
+
+    // check name against automation parameters
+    bool allowed = false;
+    for (size_t i = 0; i < sizeof(profile_params) / sizeof(profile_params[0]); i++) {
+      if (strcmp(pair, profile_params[i]) == 0) {
+        allowed = true;
+        break;
+      }
+    }
+    if (!allowed) {
+      naos_log("profile: parameter '%s' not allowed", pair);
+      return;
+    }
+
+    // add pair
+    names[count] = pair;
+    values[count] = value + 1;
+    count++;
   }
 
-  // check for "flash" command
-  else if (strcmp(topic, "flash") == 0 && scope == NAOS_LOCAL) {
-    // read colors and time
-    int red = 0;
-    int green = 0;
-    int blue = 0;
-    int white = 0;
-    int time = 0;
-    sscanf((const char *)payload, "%d %d %d %d %d", &red, &green, &blue, &white, &time);
+  // apply profile
+  for (int i = 0; i < count; i++) {
+    naos_set(names[i], values[i]);
+  }
+}
 
-    // flash color
-    led_flash(led_color(red, green, blue, white), time);
+static void cmd_sense(const char *payload) {
+  // check simulation
+  if (!simulate) {
+    return;
   }
 
-  // check for "calibrate" command
-  else if (strcmp(topic, "calibrate") == 0 && scope == NAOS_LOCAL) {
-    state_transition(CALIBRATE);
+  // read motion and distance
+  int m = -1;
+  double d = -1;
+  sscanf(payload, "%d %lf", &m, &d);
+
+  // feed simulated readings
+  if (m >= 0) {
+    pir(m);
+  }
+  if (d >= 0) {
+    dst_inject(d);
+  }
+}
+
+static void cmd_trace(const char *payload) {
+  if (strcmp(payload, "start") == 0) {
+    trc_enable(true);
+  } else if (strcmp(payload, "stop") == 0) {
+    trc_enable(false);
+  } else if (strcmp(payload, "dump") == 0) {
+    dump();
+  }
+}
+
+static void cmd_automate(const char *payload) {
+  // set volatile automate
+  automate_override = strcmp(payload, "1") == 0 ? 1 : 0;
+}
+
+static void cmd_raw(const char *payload) {
+  if (strcmp(payload, "start") == 0) {
+    raw_enable(true);
+  } else if (strcmp(payload, "stop") == 0) {
+    raw_enable(false);
+  }
+}
+
+static void cmd_scene(const char *payload) {
+  // read slot and delay
+  int slot = -1;
+  int delay = 0;
+  sscanf(payload, "%d %d", &slot, &delay);
+
+  // recall immediately or schedule recall
+  if (delay <= 0) {
+    scene_pending = -1;
+    recall(slot);
+  } else {
+    scene_pending = slot;
+    scene_at = naos_millis() + delay;
+  }
+}
+
+static void cmd_scene_record(const char *payload) {
+  // read slot and time
+  int slot = -1;
+  int time = 1000;
+  sscanf(payload, "%d %d", &slot, &time);
+
+  // store current state
+  scn_set(slot, (scn_t){.height = position, .color = led_get(), .time = time, .automate = automating()});
+}
+
+static void cmd_scene_store(const char *payload) {
+  // read slot, height, colors, time and automate
+  int slot = -1;
+  double height = 0;
+  int red = 0;
+  int green = 0;
+  int blue = 0;
+  int white = 0;
+  int time = 0;
+  int enable = 0;
+  sscanf(payload, "%d %lf %d %d %d %d %d %d", &slot, &height, &red, &green, &blue, &white, &time, &enable);
+
+  // store scene
+  scn_set(slot, (scn_t){.height = height,
+                        .color = led_color(red, green, blue, white),
+                        .time = time,
+                        .automate = enable != 0});
+}
+
+static void cmd_neighbor(const char *payload) {
+  // read sender, sequence, group, type and value
+  unsigned int mac[6] = {0};
+  unsigned int seq = 0;
+  int grp = 0;
+  int type = 0;
+  int value = 0;
+  if (sscanf(payload, "%2x%2x%2x%2x%2x%2x %u %d %d %d", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5], &seq,
+             &grp, &type, &value) != 10) {
     return;
   }
+
+  // handle message
+  now_event_t e = {.group = (uint8_t)grp, .type = (uint8_t)type, .seq = seq, .value = value};
+  for (int i = 0; i < 6; i++) {
+    e.mac[i] = (uint8_t)mac[i];
+  }
+  neighbor(&e);
 }
 
-static void loop() {
-  // feed state machine
-  state_feed();
+static void cmd_stream(const char *payload) {
+  // start or stop following frames if calibrated
+  if (strcmp(payload, "start") == 0 && calibrated) {
+    state_transition(STREAM);
+  } else if (strcmp(payload, "stop") == 0 && state == STREAM) {
+    state_transition(STANDBY);
+  }
 }
 
-/* custom callbacks */
+// the states in which commands may change the motion
+#define SAFE (CMD_ANY & ~(1u << RESET))
+
+static const cmd_t commands[] = {
+    {.topic = "move", .args = 1, .scopes = CMD_LOCAL, .states = SAFE, .handler = cmd_move},
+    {.topic = "stop", .args = 0, .scopes = CMD_LOCAL, .states = SAFE, .handler = cmd_stop},
+    {.topic = "fade", .args = 5, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_fade},
+    {.topic = "flash", .args = 5, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_flash},
+    {.topic = "calibrate", .args = 0, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_calibrate},
+    {.topic = "calibrating", .args = 1, .scopes = CMD_GLOBAL, .states = CMD_ANY, .handler = cmd_calibrating},
+    {.topic = "field", .args = 2, .scopes = CMD_LOCAL | CMD_GLOBAL, .states = SAFE, .handler = cmd_field},
+    {.topic = "target", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_target},
+    {.topic = "profile", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_profile},
+    {.topic = "sense", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_sense},
+    {.topic = "trace", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_trace},
+    {.topic = "automate", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_automate},
+    {.topic = "raw", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_raw},
+    {.topic = "scene", .args = 1, .scopes = CMD_LOCAL | CMD_GLOBAL, .states = SAFE, .handler = cmd_scene},
+    {.topic = "scene-record", .args = 1, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_scene_record},
+    {.topic = "scene-store", .args = 8, .scopes = CMD_LOCAL, .states = CMD_ANY, .handler = cmd_scene_store},
+    {.topic = "neighbor", .args = 5, .scopes = CMD_GLOBAL, .states = CMD_ANY, .handler = cmd_neighbor},
+    {.topic = "stream", .args = 1, .scopes = CMD_LOCAL, .states = SAFE, .handler = cmd_stream},
+};
+
+/* event handlers */
+
+static void stream() {
+  // check mode and state
+  if (!remote_automate || state != AUTOMATE) {
+    return;
+  }
+
+  // publish sensor data with timestamp
+  static char buf[64];
+  snprintf(buf, sizeof(buf), "%u %.2f %.2f %d", (unsigned int)naos_millis(), position, distance, pir_value);
+  naos_publish("sensors", buf, 0, false, NAOS_LOCAL);
+}
+
+static void announce() {
+  // check group
+  if (group <= 0) {
+    return;
+  }
+
+  // broadcast motion to neighbors
+  now_event_t e = now_send((uint8_t)group, NOW_MOTION, 1);
+
+  // also send over the broker if enabled
+  if (now_fallback) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%02x%02x%02x%02x%02x%02x %u %d %d %d", e.mac[0], e.mac[1], e.mac[2], e.mac[3],
+             e.mac[4], e.mac[5], (unsigned int)e.seq, e.group, e.type, (int)e.value);
+    naos_publish("neighbor", buf, 0, false, NAOS_GLOBAL);
+  }
+}
 
 static void pir(int m) {
+  // save value
+  pir_value = m;
+
   // track last motion
   static uint32_t last = 0;
 
   // calculate dynamic pir threshold
-  int threshold = a32_safe_map_i((int)position, (int)idle_height, (int)rise_height, pir_low, pir_high);
+  int threshold = aut_threshold(automation(), position);
 
   // update timestamp if motion detected
   if (m > threshold) {
@@ -420,8 +1304,36 @@ static void pir(int m) {
   }
 
   // check if there was a motion in the last interval
+  bool was = motion;
   motion = last > naos_millis() - pir_interval;
 
+  // track motion duration
+  if (motion && !was) {
+    motion_since = naos_millis();
+    announce();
+  } else if (!motion && was) {
+    motion_time += naos_millis() - motion_since;
+    motion_end = naos_millis();
+  }
+
+  // stream sensor data
+  stream();
+
+  // feed state machine
+  state_feed();
+}
+
+static void neighbor(const now_event_t *e) {
+  // ignore own, foreign and already handled messages
+  if (group <= 0 || e->group != group || now_own(e) || !now_accept(e)) {
+    return;
+  }
+
+  // save neighbor motion
+  if (e->type == NOW_MOTION && e->value != 0) {
+    neighbor_at = naos_millis();
+  }
+
   // feed state machine
   state_feed();
 }
@@ -435,7 +1347,7 @@ static void end() {
 
 static void enc(double r) {
   // movement
-  double movement = (invert_encoder ? r * -1 : r) * WINDING_LENGTH;
+  double movement = (invert_encoder ? r * -1 : r) * winding_length;
 
   // apply rotation
   position += movement;
@@ -443,10 +1355,12 @@ static void enc(double r) {
   // apply movement
   usage += fabs(movement);
 
-  // re-calibrate if usage is high and no reset is being performed
-  if (state != RESET && usage > calib_interval) {
-    usage = 0;
-    state_transition(CALIBRATE);
+  // mark calibration as due if usage is high
+  if (!calibration_due && usage > calib_interval) {
+    calibration_due = true;
+    calibration_due_at = naos_millis();
+    calibration_delay = calib_jitter > 0 ? esp_random() % (uint32_t)calib_jitter : 0;
+    publish("calibration", "due");
   }
 
   // feed state machine
@@ -457,15 +1371,88 @@ static void dst(double d) {
   // update distance
   distance = d;
 
+  // update summary
+  sum_add(&distance_stat, d);
+
   // update calibration data
-  if (calibration_data != NULL && d >= (idle_height - CALIBRATION_LEEWAY) && d <= (rise_height + CALIBRATION_LEEWAY)) {
-    a32_smooth_update(calibration_data, d);
+  if (calibration_active && d >= (idle_height - CALIBRATION_LEEWAY) && d <= (rise_height + CALIBRATION_LEEWAY)) {
+    calibration_samples[calibration_index] = d;
+    calibration_index = (calibration_index + 1) % CALIBRATION_SAMPLES;
+    if (calibration_count < CALIBRATION_SAMPLES) {
+      calibration_count++;
+    }
   }
 
+  // stream sensor data
+  stream();
+
   // feed state machine
   state_feed();
 }
 
+static void frame(const udp_event_t *e) {
+  // update target
+  stream_target = a32_constrain_d(e->height, idle_height, reset_height - RESET_OFFSET);
+
+  // fade color if changed
+  if (state == STREAM && (e->red != stream_frame.red || e->green != stream_frame.green ||
+                          e->blue != stream_frame.blue || e->white != stream_frame.white)) {
+    led_fade(led_color(e->red, e->green, e->blue, e->white), 0);
+  }
+
+  // save frame
+  stream_frame = *e;
+}
+
+static void events() {
+  // handle motion events, ignore sensor while simulating
+  const pir_event_t *pe;
+  while ((pe = bus_next(&pir_sub)) != NULL) {
+    if (!simulate) {
+      pir(pe->motion);
+    }
+  }
+
+  // handle end stop events
+  while (bus_next(&end_sub) != NULL) {
+    end();
+  }
+
+  // handle encoder events, only the latest total matters
+  const enc_event_t *ee;
+  const enc_event_t *total = NULL;
+  while ((ee = bus_next(&enc_sub)) != NULL) {
+    total = ee;
+  }
+  if (total != NULL) {
+    double rotations = total->rotations;
+    enc(rotations - enc_rotations);
+    enc_rotations = rotations;
+  }
+
+  // handle neighbor events
+  const now_event_t *ne;
+  while ((ne = bus_next(&now_sub)) != NULL) {
+    neighbor(ne);
+  }
+
+  // handle stream frames, only the latest frame matters
+  const udp_event_t *ue;
+  const udp_event_t *latest = NULL;
+  while ((ue = bus_next(&udp_sub)) != NULL) {
+    latest = ue;
+  }
+  if (latest != NULL) {
+    frame(latest);
+  }
+
+  // handle distance events
+  const dst_event_t *de;
+  while ((de = bus_next(&dst_sub)) != NULL) {
+    dst(de->distance);
+  }
+}
+
 /* initialization */
 
 static naos_param_t params[] = {
@@ -484,12 +1471,50 @@ static naos_param_t params[] = {
     {.name = "pir-high", .type = NAOS_LONG, .default_l = 400, .sync_l = &pir_high},
     {.name = "pir-interval", .type = NAOS_LONG, .default_l = 2000, .sync_l = &pir_interval},
     {.name = "calib-interval", .type = NAOS_LONG, .default_l = 200, .sync_l = &calib_interval},
+    {.name = "field-x", .type = NAOS_DOUBLE, .default_d = 0, .sync_d = &field_x},
+    {.name = "field-y", .type = NAOS_DOUBLE, .default_d = 0, .sync_d = &field_y},
+    {.name = "field-rate", .type = NAOS_LONG, .default_l = 50, .sync_l = &field_rate},
+    {.name = "remote-automate", .type = NAOS_BOOL, .default_b = false, .sync_b = &remote_automate},
+    {.name = "remote-budget", .type = NAOS_LONG, .default_l = 250, .sync_l = &remote_budget},
+    {.name = "simulate", .type = NAOS_BOOL, .default_b = false, .sync_b = &simulate},
+    {.name = "health-interval", .type = NAOS_LONG, .default_l = 60000, .sync_l = &health_interval},
+    {.name = "raw-rate", .type = NAOS_LONG, .default_l = 10, .sync_l = &raw_rate},
+    {.name = "coalesce", .type = NAOS_BOOL, .default_b = false, .sync_b = &coalesce},
+    {.name = "coalesce-time", .type = NAOS_LONG, .default_l = 50, .sync_l = &coalesce_time},
+    {.name = "winding-length", .type = NAOS_DOUBLE, .default_d = 7.5, .sync_d = &winding_length},
+    {.name = "mot-up-gain", .type = NAOS_DOUBLE, .default_d = 69.88908, .sync_d = &mot_up_gain},
+    {.name = "mot-up-offset", .type = NAOS_DOUBLE, .default_d = 142.488, .sync_d = &mot_up_offset},
+    {.name = "mot-down-gain", .type = NAOS_DOUBLE, .default_d = 59.54553, .sync_d = &mot_down_gain},
+    {.name = "mot-down-offset", .type = NAOS_DOUBLE, .default_d = 65.3359, .sync_d = &mot_down_offset},
+    {.name = "creep-speed", .type = NAOS_DOUBLE, .default_d = 1, .sync_d = &creep_speed},
+    {.name = "target-deadband", .type = NAOS_DOUBLE, .default_d = 1, .sync_d = &target_deadband},
+    {.name = "target-hysteresis", .type = NAOS_DOUBLE, .default_d = 4, .sync_d = &target_hysteresis},
+    {.name = "target-rate", .type = NAOS_DOUBLE, .default_d = 10, .sync_d = &target_rate},
+    {.name = "target-dwell", .type = NAOS_LONG, .default_l = 1000, .sync_l = &target_dwell},
+    {.name = "summary-interval", .type = NAOS_LONG, .default_l = 60000, .sync_l = &summary_interval},
+    {.name = "raw-events", .type = NAOS_BOOL, .default_b = true, .sync_b = &raw_events},
+    {.name = "calib-quiet", .type = NAOS_LONG, .default_l = 30000, .sync_l = &calib_quiet},
+    {.name = "calib-jitter", .type = NAOS_LONG, .default_l = 10000, .sync_l = &calib_jitter},
+    {.name = "calib-deadline", .type = NAOS_LONG, .default_l = 1800000, .sync_l = &calib_deadline},
+    {.name = "calib-max", .type = NAOS_LONG, .default_l = 2, .sync_l = &calib_max},
+    {.name = "twin", .type = NAOS_BOOL, .default_b = false, .sync_b = &twin},
+    {.name = "twin-bound", .type = NAOS_DOUBLE, .default_d = 2, .sync_d = &twin_bound},
+    {.name = "group", .type = NAOS_LONG, .default_l = 0, .sync_l = &group},
+    {.name = "now-fallback", .type = NAOS_BOOL, .default_b = false, .sync_b = &now_fallback},
+    {.name = "stream-slot", .type = NAOS_LONG, .default_l = -1, .sync_l = &stream_slot},
+    {.name = "stream-port", .type = NAOS_LONG, .default_l = 7000, .sync_l = &stream_port},
+    {.name = "stream-group", .type = NAOS_STRING, .default_s = "239.0.0.100", .sync_s = &stream_group},
+    {.name = "supply-bank", .type = NAOS_LONG, .default_l = 0, .sync_l = &supply_bank},
+    {.name = "white-extract", .type = NAOS_BOOL, .default_b = false, .sync_b = &white_extract},
+    {.name = "white-r", .type = NAOS_LONG, .default_l = 1023, .sync_l = &white_r},
+    {.name = "white-g", .type = NAOS_LONG, .default_l = 1023, .sync_l = &white_g},
+    {.name = "white-b", .type = NAOS_LONG, .default_l = 1023, .sync_l = &white_b},
 };
 
 static naos_config_t config = {.device_type = "tm-lo",
                                .firmware_version = "1.3.3",
                                .parameters = params,
-                               .num_parameters = 15,
+                               .num_parameters = 53,
                                .ping_callback = ping,
                                .online_callback = online,
                                .offline_callback = offline,
@@ -499,34 +1524,103 @@ static naos_config_t config = {.device_type = "tm-lo",
                                .loop_interval = 1,
                                .password = "tm2018"};
 
+static void report() {
+  // hash all parameter values
+  uint32_t digest = 2166136261u;
+  for (size_t i = 0; i < config.num_parameters; i++) {
+    // format value
+    char value[32] = {0};
+    naos_param_t *p = &params[i];
+    switch (p->type) {
+      case NAOS_STRING:
+        snprintf(value, sizeof(value), "%s", *p->sync_s != NULL ? *p->sync_s : "");
+        break;
+      case NAOS_BOOL:
+        snprintf(value, sizeof(value), "%d", *p->sync_b);
+        break;
+      case NAOS_LONG:
+        snprintf(value, sizeof(value), "%d", (int)*p->sync_l);
+        break;
+      case NAOS_DOUBLE:
+        snprintf(value, sizeof(value), "%.6g", *p->sync_d);
+        break;
+    }
+
+    // add "name=value;" to digest
+    const char *parts[] = {p->name, "=", value, ";"};
+    for (int j = 0; j < 4; j++) {
+      for (const char *c = parts[j]; *c != 0; c++) {
+        digest ^= (uint8_t)*c;
+        digest *= 16777619u;
+      }
+    }
+  }
+
+  // publish retained report
+  char buf[96];
+  snprintf(buf, sizeof(buf), "type=%s version=%s params=%u digest=%08x", config.device_type, config.firmware_version,
+           (unsigned int)config.num_parameters, (unsigned int)digest);
+  naos_publish("config", buf, 0, true, NAOS_LOCAL);
+
+  // clear flag
+  report_due = false;
+}
+
 void app_main() {
   // install global interrupt service
   ESP_ERROR_CHECK(gpio_install_isr_service(0));
 
+  // initialize scheduler
+  sch_init();
+
+  // subscribe to events
+  bus_subscribe(&pir_sub, &pir_bus);
+  bus_subscribe(&end_sub, &end_bus);
+  bus_subscribe(&enc_sub, &enc_bus);
+  bus_subscribe(&dst_sub, &dst_bus);
+  bus_subscribe(&now_sub, &now_bus);
+  bus_subscribe(&udp_sub, &udp_bus);
+
   // initialize motor
   mot_init();
 
   // initialize led
   led_init();
 
+  // register commands
+  cmd_init(commands, sizeof(commands) / sizeof(cmd_t));
+
   // initialize naos
   naos_init(&config);
 
+  // initialize scenes
+  scn_init();
+
+  // configure motor model
+  mot_configure(mot_up_gain, mot_up_offset, mot_down_gain, mot_down_offset, creep_speed);
+
+  // configure white extraction
+  led_configure(white_extract, white_r, white_g, white_b);
+
   // initialize motion sensor
-  pir_init(pir);
+  pir_init();
 
   // initialize end stop
-  end_init(end);
+  end_init();
 
   // initialize encoder
-  enc_init(enc);
+  enc_init();
 
   // initialize distance sensor
-  dst_init(dst);
+  dst_init();
+  dst_simulate(simulate);
+
+  // initialize frame receiver
+  udp_init();
 
-  // disable automate mode if end switch is pressed
+  // disable automate mode without persisting if end switch is pressed
   if (end_read()) {
-    naos_set_b("automate", false);
+    automate_override = 0;
   }
 
   // activate first state
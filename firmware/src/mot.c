@@ -2,14 +2,37 @@
 #include <art32/numbers.h>
 #include <driver/ledc.h>
 #include <math.h>
+#include <naos.h>
 
 #include "mot.h"
+#include "trc.h"
+
+// the motor model uses 10 bit duties while the pwm runs at 12 bit
+#define MOT_SCALE 4
+
+// the interval in ms at which the creep accumulator decides to pulse
+#define MOT_CREEP_TICK 10
 
 static a32_motion_t mot_mp;
+static double mot_target = 0;
+static bool mot_active = false;
+
+static double mot_up_gain = 69.88908;
+static double mot_up_offset = 142.488;
+static double mot_down_gain = 59.54553;
+static double mot_down_offset = 65.3359;
+static double mot_creep_speed = 0;
+
+static double mot_creep = 0;
+static bool mot_creep_on = false;
+static uint32_t mot_creep_at = 0;
+
+static int mot_direction = 0;
+static uint32_t mot_reversal_count = 0;
 
 static void mot_set(int speed) {
   // cap speed
-  speed = a32_constrain_i(speed, -1023, 1023);
+  speed = a32_constrain_i(speed, -4095, 4095);
 
   // set motor state
   if (speed == 0) {
@@ -26,6 +49,15 @@ static void mot_set(int speed) {
     ESP_ERROR_CHECK(gpio_set_level(GPIO_NUM_16, 0));
   }
 
+  // count direction reversals
+  if (speed != 0) {
+    int direction = speed > 0 ? 1 : -1;
+    if (mot_direction != 0 && direction != mot_direction) {
+      mot_reversal_count++;
+    }
+    mot_direction = direction;
+  }
+
   // handle minus speeds
   if (speed < 0) {
     speed = speed * -1;
@@ -36,13 +68,36 @@ static void mot_set(int speed) {
   ESP_ERROR_CHECK(ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0));
 }
 
+static int mot_raw(double gain, double offset, double speed) {
+  // dither between stop and creep speed to reach average speeds below the dead band
+  if (speed < mot_creep_speed) {
+    // step accumulator once per tick independently of the update rate
+    if (naos_millis() - mot_creep_at >= MOT_CREEP_TICK) {
+      mot_creep_at = naos_millis();
+      mot_creep += speed / mot_creep_speed;
+      mot_creep_on = mot_creep >= 1;
+      if (mot_creep_on) {
+        mot_creep -= 1;
+      }
+    }
+
+    // pause until the next pulse
+    if (!mot_creep_on) {
+      return 0;
+    }
+    speed = mot_creep_speed;
+  }
+
+  // calculate raw speed
+  return (int)floor((gain * speed + offset) * MOT_SCALE);
+}
+
 static void mot_move_up(double speed) {
   // cap speed
   speed = a32_constrain_d(speed, 0, 12);
 
   // calculate and set raw speed
-  int raw = (int)floor(69.88908 * speed + 142.488);
-  mot_set(raw);
+  mot_set(mot_raw(mot_up_gain, mot_up_offset, speed));
 }
 
 static void mot_move_down(double speed) {
@@ -50,8 +105,7 @@ static void mot_move_down(double speed) {
   speed = a32_constrain_d(speed, 0, 12);
 
   // calculate and set raw speed
-  int raw = (int)floor(59.54553 * speed + 65.3359);
-  mot_set(-raw);
+  mot_set(-mot_raw(mot_down_gain, mot_down_offset, speed));
 }
 
 void mot_init() {
@@ -66,7 +120,7 @@ void mot_init() {
   ESP_ERROR_CHECK(gpio_config(&in_ab));
 
   // prepare ledc timer config
-  ledc_timer_config_t t = {.duty_resolution = LEDC_TIMER_10_BIT,
+  ledc_timer_config_t t = {.duty_resolution = LEDC_TIMER_12_BIT,
                            .freq_hz = 10000,
                            .speed_mode = LEDC_HIGH_SPEED_MODE,
                            .timer_num = LEDC_TIMER_0};
@@ -89,10 +143,26 @@ void mot_init() {
   mot_stop();
 }
 
+void mot_configure(double up_gain, double up_offset, double down_gain, double down_offset, double creep_speed) {
+  // set model
+  mot_up_gain = up_gain;
+  mot_up_offset = up_offset;
+  mot_down_gain = down_gain;
+  mot_down_offset = down_offset;
+  mot_creep_speed = creep_speed;
+}
+
 bool mot_approach(double position, double target, uint32_t time) {
+  // begin trace
+  trc_begin(TRC_APPROACH, 0);
+
   // configure motion profile
-  mot_mp.max_velocity = 12.0 /* cm */ / 1000 /* s */ * 1.25;
-  mot_mp.max_acceleration = 0.01 /* cm */ / 1000 /* s */;
+  mot_mp.max_velocity = MOT_MAX_VELOCITY;
+  mot_mp.max_acceleration = MOT_MAX_ACCELERATION;
+
+  // save target
+  mot_target = target;
+  mot_active = true;
 
   // provide measured position
   mot_mp.position = position;
@@ -105,6 +175,9 @@ bool mot_approach(double position, double target, uint32_t time) {
     // stop motor
     mot_stop();
 
+    // end trace
+    trc_end(TRC_APPROACH, 0);
+
     return true;
   }
 
@@ -115,6 +188,9 @@ bool mot_approach(double position, double target, uint32_t time) {
     mot_move_down(fabs(mot_mp.velocity) * 1000 * 0.8);
   }
 
+  // end trace
+  trc_end(TRC_APPROACH, 0);
+
   return false;
 }
 
@@ -122,6 +198,23 @@ void mot_stop() {
   // set zero speed to stop motor
   mot_set(0);
 
-  // reset motion profile
+  // reset motion profile and creep
   mot_mp = (a32_motion_t){0};
+  mot_creep = 0;
+  mot_creep_on = false;
+
+  // clear target
+  mot_active = false;
 }
+
+bool mot_status(double *target, double *velocity) {
+  // get target and velocity
+  if (mot_active) {
+    *target = mot_target;
+  }
+  *velocity = mot_mp.velocity;
+
+  return mot_active;
+}
+
+uint32_t mot_reversals() { return mot_reversal_count; }
@@ -4,11 +4,26 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// the motion profile limits in cm/ms and cm/ms^2
+#define MOT_MAX_VELOCITY (12.0 / 1000 * 1.25)
+#define MOT_MAX_ACCELERATION (0.01 / 1000)
+
 /**
  * Initialize motor.
  */
 void mot_init();
 
+/**
+ * Configure the motor model that maps speeds to raw duties.
+ *
+ * @param up_gain The raw duty per cm/s when moving up.
+ * @param up_offset The dead band duty when moving up.
+ * @param down_gain The raw duty per cm/s when moving down.
+ * @param down_offset The dead band duty when moving down.
+ * @param creep_speed The speed in cm/s below which the motor is pulsed to creep.
+ */
+void mot_configure(double up_gain, double up_offset, double down_gain, double down_offset, double creep_speed);
+
 /**
  * Approach specified target.
  *
@@ -24,4 +39,20 @@ bool mot_approach(double position, double target, uint32_t time);
  */
 void mot_stop();
 
+/**
+ * Get the current approach target and profile velocity.
+ *
+ * @param target The target position, left unchanged if the motor is stopped.
+ * @param velocity The profile velocity in cm/ms.
+ * @return Whether the motor is approaching a target.
+ */
+bool mot_status(double *target, double *velocity);
+
+/**
+ * Get the number of motor direction reversals since boot.
+ *
+ * @return The reversals.
+ */
+uint32_t mot_reversals();
+
 #endif  // MOT_H
@@ -0,0 +1,127 @@
+#include <esp_now.h>
+#include <esp_system.h>
+#include <esp_wifi.h>
+#include <string.h>
+
+#include "now.h"
+
+#define NOW_MAGIC 0x7A
+#define NOW_PEERS 32
+#define NOW_WINDOW 1024
+
+typedef struct __attribute__((packed)) {
+  uint8_t magic;
+  uint8_t group;
+  uint8_t type;
+  uint8_t _;
+  uint32_t seq;
+  int32_t value;
+} now_packet_t;
+
+typedef struct {
+  uint8_t mac[6];
+  bool used;
+  uint32_t seq;
+} now_peer_t;
+
+BUS_TOPIC(now_bus, now_event_t, 16);
+
+static const uint8_t now_broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static bool now_ready = false;
+static uint8_t now_mac[6] = {0};
+static uint32_t now_seq = 0;
+static now_peer_t now_peers[NOW_PEERS] = {0};
+static int now_next = 0;
+
+static void now_receive(const uint8_t *mac, const uint8_t *data, int len) {
+  // check packet
+  if (len != sizeof(now_packet_t) || data[0] != NOW_MAGIC) {
+    return;
+  }
+
+  // copy packet
+  now_packet_t p;
+  memcpy(&p, data, sizeof(p));
+
+  // publish event
+  now_event_t *e = bus_claim(&now_bus);
+  memcpy(e->mac, mac, 6);
+  e->group = p.group;
+  e->type = p.type;
+  e->seq = p.seq;
+  e->value = p.value;
+  bus_commit(&now_bus);
+}
+
+void now_init() {
+  // check state
+  if (now_ready) {
+    return;
+  }
+
+  // get own address
+  ESP_ERROR_CHECK(esp_wifi_get_mac(ESP_IF_WIFI_STA, now_mac));
+
+  // start with a random sequence so neighbors accept messages after a reboot
+  now_seq = esp_random();
+
+  // initialize esp-now
+  ESP_ERROR_CHECK(esp_now_init());
+  ESP_ERROR_CHECK(esp_now_register_recv_cb(now_receive));
+
+  // add broadcast peer on the current channel
+  esp_now_peer_info_t peer = {0};
+  memcpy(peer.peer_addr, now_broadcast, 6);
+  peer.channel = 0;
+  peer.ifidx = ESP_IF_WIFI_STA;
+  peer.encrypt = false;
+  ESP_ERROR_CHECK(esp_now_add_peer(&peer));
+
+  // set flag
+  now_ready = true;
+}
+
+now_event_t now_send(uint8_t group, now_type_t type, int32_t value) {
+  // prepare message
+  now_event_t e = {.group = group, .type = (uint8_t)type, .seq = ++now_seq, .value = value};
+  memcpy(e.mac, now_mac, 6);
+
+  // broadcast packet if ready
+  if (now_ready) {
+    now_packet_t p = {.magic = NOW_MAGIC, .group = group, .type = (uint8_t)type, .seq = e.seq, .value = value};
+    esp_now_send(now_broadcast, (const uint8_t *)&p, sizeof(p));
+  }
+
+  return e;
+}
+
+bool now_accept(const now_event_t *e) {
+  // find sender
+  for (int i = 0; i < NOW_PEERS; i++) {
+    if (now_peers[i].used && memcmp(now_peers[i].mac, e->mac, 6) == 0) {
+      // reject duplicate and recently superseded messages
+      int32_t diff = (int32_t)(e->seq - now_peers[i].seq);
+      if (diff <= 0 && diff > -NOW_WINDOW) {
+        return false;
+      }
+
+      // save sequence
+      now_peers[i].seq = e->seq;
+
+      return true;
+    }
+  }
+
+  // add sender replacing the oldest added sender
+  now_peers[now_next] = (now_peer_t){.used = true, .seq = e->seq};
+  memcpy(now_peers[now_next].mac, e->mac, 6);
+  now_next = (now_next + 1) % NOW_PEERS;
+
+  return true;
+}
+
+bool now_own(const now_event_t *e) {
+  // compare address
+  return memcmp(e->mac, now_mac, 6) == 0;
+}
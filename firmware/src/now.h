@@ -0,0 +1,72 @@
+#ifndef NOW_H
+#define NOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus.h"
+
+typedef enum {
+  NOW_MOTION,
+} now_type_t;
+
+typedef struct {
+  /**
+   * The MAC address of the sender.
+   */
+  uint8_t mac[6];
+
+  /**
+   * The group and message type.
+   */
+  uint8_t group, type;
+
+  /**
+   * The sender sequence number.
+   */
+  uint32_t seq;
+
+  /**
+   * The value.
+   */
+  int32_t value;
+} now_event_t;
+
+/**
+ * The topic that receives messages from neighbors.
+ */
+extern bus_topic_t now_bus;
+
+/**
+ * Initialize ESP-NOW. Must be called once Wi-Fi is started, subsequent calls are ignored.
+ */
+void now_init();
+
+/**
+ * Broadcast a message to all neighbors.
+ *
+ * @param group The group.
+ * @param type The type.
+ * @param value The value.
+ * @return The message with sender and sequence set for use with a fallback transport.
+ */
+now_event_t now_send(uint8_t group, now_type_t type, int32_t value);
+
+/**
+ * Check if a message has not been seen before. Messages with an equal or slightly older sequence than the last
+ * accepted message of the same sender are rejected.
+ *
+ * @param e The message.
+ * @return Whether the message should be handled.
+ */
+bool now_accept(const now_event_t *e);
+
+/**
+ * Check if a message has been sent by this device.
+ *
+ * @param e The message.
+ * @return Whether the message is our own.
+ */
+bool now_own(const now_event_t *e);
+
+#endif  // NOW_H
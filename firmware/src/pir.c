@@ -1,39 +1,43 @@
 #include <driver/adc.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <naos.h>
 #include <stdlib.h>
 
 #include "pir.h"
+#include "raw.h"
+#include "sch.h"
 
-static pir_callback_t pir_callback;
+BUS_TOPIC(pir_bus, pir_event_t, 8);
+
+static sch_pt_t pir_pt;
+
+static void pir_thread(sch_pt_t *pt) {
+  SCH_BEGIN(pt);
 
-static void pir_task(void *p) {
   // loop forever
   for (;;) {
-    // read pir
-    int v = abs(590 - adc1_get_raw(ADC1_CHANNEL_6));
+    // read and record pir
+    int r = adc1_get_raw(ADC1_CHANNEL_6);
+    raw_record(RAW_PIR, (int16_t)r);
+    int v = abs(590 - r);
 
-    // call callback
-    naos_acquire();
-    pir_callback(v);
-    naos_release();
+    // publish event
+    pir_event_t *e = bus_claim(&pir_bus);
+    e->motion = v;
+    bus_commit(&pir_bus);
 
     // wait 100ms
-    naos_delay(100);
+    SCH_DELAY(pt, 100);
   }
-}
 
-void pir_init(pir_callback_t cb) {
-  // save callback
-  pir_callback = cb;
+  SCH_END(pt);
+}
 
+void pir_init() {
   // set adc width
   ESP_ERROR_CHECK(adc1_config_width(ADC_WIDTH_10Bit));
 
   // prepare analog pin config
   ESP_ERROR_CHECK(adc1_config_channel_atten(ADC1_CHANNEL_6, ADC_ATTEN_11db));
 
-  // run async task
-  xTaskCreatePinnedToCore(&pir_task, "pir", 8192, NULL, 2, NULL, 1);
+  // add thread
+  sch_add(&pir_pt, pir_thread);
 }
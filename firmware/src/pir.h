@@ -3,18 +3,23 @@
 
 #include <stdbool.h>
 
+#include "bus.h"
+
+typedef struct {
+  /**
+   * The motion from 0 to ~400.
+   */
+  int motion;
+} pir_event_t;
+
 /**
- * The PIR callback.
- *
- * @param m The motion from 0 to ~400.
+ * The topic that receives new PIR readings.
  */
-typedef void (*pir_callback_t)(int m);
+extern bus_topic_t pir_bus;
 
 /**
  * Initialize PIR sensor.
- *
- * @param cb The PIR callback.
  */
-void pir_init(pir_callback_t cb);
+void pir_init();
 
 #endif  // PIR_H
@@ -0,0 +1,81 @@
+#include <naos.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pub.h"
+
+#define PUB_TOPIC "telemetry"
+#define PUB_ENTRIES 8
+#define PUB_VALUE 24
+
+typedef struct {
+  const char *key;
+  char value[PUB_VALUE];
+} pub_entry_t;
+
+static pub_entry_t pub_entries[PUB_ENTRIES];
+static int pub_count = 0;
+static uint32_t pub_first = 0;
+
+static uint32_t pub_added = 0;
+static uint32_t pub_sent = 0;
+
+void pub_add(const char *key, const char *value) {
+  // find existing entry
+  int i = 0;
+  while (i < pub_count && strcmp(pub_entries[i].key, key) != 0) {
+    i++;
+  }
+
+  // flush if full
+  if (i == PUB_ENTRIES) {
+    pub_flush();
+    i = 0;
+  }
+
+  // save time of first entry
+  if (pub_count == 0) {
+    pub_first = naos_millis();
+  }
+
+  // set entry
+  pub_entries[i].key = key;
+  strncpy(pub_entries[i].value, value, PUB_VALUE - 1);
+  pub_entries[i].value[PUB_VALUE - 1] = 0;
+  if (i == pub_count) {
+    pub_count++;
+  }
+
+  // increment counter
+  pub_added++;
+}
+
+bool pub_due(uint32_t hold) { return pub_count > 0 && naos_millis() - pub_first >= hold; }
+
+void pub_flush() {
+  // check count
+  if (pub_count == 0) {
+    return;
+  }
+
+  // write "key=value" pairs
+  static char buf[PUB_ENTRIES * (PUB_VALUE + 16)];
+  size_t len = 0;
+  for (int i = 0; i < pub_count; i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, i == 0 ? "%s=%s" : " %s=%s", pub_entries[i].key,
+                    pub_entries[i].value);
+    if (len >= sizeof(buf)) {
+      len = sizeof(buf) - 1;
+      break;
+    }
+  }
+
+  // publish message
+  naos_publish(PUB_TOPIC, buf, 0, false, NAOS_LOCAL);
+
+  // reset buffer
+  pub_count = 0;
+  pub_sent++;
+}
+
+uint32_t pub_saved() { return pub_added - pub_sent; }
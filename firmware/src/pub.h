@@ -0,0 +1,35 @@
+#ifndef PUB_H
+#define PUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Add a value to the outbound buffer. A pending value with the same key is replaced.
+ *
+ * @param key The key.
+ * @param value The value.
+ */
+void pub_add(const char *key, const char *value);
+
+/**
+ * Check if the buffer should be flushed.
+ *
+ * @param hold The maximum time in milliseconds a value may be held.
+ * @return Whether the buffer holds values that reached the hold time.
+ */
+bool pub_due(uint32_t hold);
+
+/**
+ * Publish all buffered values as a single "telemetry" message.
+ */
+void pub_flush();
+
+/**
+ * Get the number of publishes that have been saved by coalescing.
+ *
+ * @return The saved publishes.
+ */
+uint32_t pub_saved();
+
+#endif  // PUB_H
@@ -0,0 +1,73 @@
+#include <esp_timer.h>
+#include <string.h>
+
+#include "raw.h"
+
+#define RAW_SIZE 1024
+#define RAW_HEADER 8
+
+static raw_sample_t raw_ring[RAW_SIZE];
+
+static volatile bool raw_on = false;
+static volatile uint32_t raw_head = 0;
+static uint32_t raw_tail = 0;
+static uint32_t raw_seq = 0;
+
+void raw_enable(bool on) {
+  // reset ring
+  raw_on = false;
+  raw_head = 0;
+  raw_tail = 0;
+  raw_seq = 0;
+
+  // set flag
+  raw_on = on;
+}
+
+void raw_record(raw_type_t type, int16_t value) {
+  // check flag
+  if (!raw_on) {
+    return;
+  }
+
+  // claim slot
+  uint32_t i = __sync_fetch_and_add(&raw_head, 1);
+
+  // write sample
+  raw_ring[i % RAW_SIZE] =
+      (raw_sample_t){.time = (uint32_t)esp_timer_get_time(), .type = (uint8_t)type, .value = value};
+}
+
+size_t raw_frame(uint8_t *buf, size_t size) {
+  // get head
+  uint32_t head = raw_head;
+
+  // check for samples
+  if (!raw_on || head == raw_tail) {
+    return 0;
+  }
+
+  // skip overwritten samples
+  uint16_t lost = 0;
+  if (head - raw_tail > RAW_SIZE) {
+    lost = (uint16_t)(head - raw_tail - RAW_SIZE);
+    raw_tail = head - RAW_SIZE;
+  }
+
+  // copy samples
+  uint16_t count = 0;
+  size_t max = (size - RAW_HEADER) / sizeof(raw_sample_t);
+  while (raw_tail != head && count < max) {
+    memcpy(buf + RAW_HEADER + count * sizeof(raw_sample_t), &raw_ring[raw_tail % RAW_SIZE], sizeof(raw_sample_t));
+    raw_tail++;
+    count++;
+  }
+
+  // write header
+  memcpy(buf, &raw_seq, 4);
+  memcpy(buf + 4, &count, 2);
+  memcpy(buf + 6, &lost, 2);
+  raw_seq++;
+
+  return RAW_HEADER + count * sizeof(raw_sample_t);
+}
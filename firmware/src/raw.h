@@ -0,0 +1,56 @@
+#ifndef RAW_H
+#define RAW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  RAW_ENC,  // encoder transition (value: 4 bit state)
+  RAW_DST,  // sonar pulse width (value: µs)
+  RAW_PIR,  // PIR ADC sample (value: raw)
+} raw_type_t;
+
+typedef struct __attribute__((packed)) {
+  /**
+   * The time in microseconds.
+   */
+  uint32_t time;
+
+  /**
+   * The sample type.
+   */
+  uint8_t type, _;
+
+  /**
+   * The raw value.
+   */
+  int16_t value;
+} raw_sample_t;
+
+/**
+ * Enable or disable capturing. Enabling clears the ring and resets the sequence.
+ *
+ * @param on Whether to capture.
+ */
+void raw_enable(bool on);
+
+/**
+ * Record a sample. May be called from tasks and interrupts.
+ *
+ * @param type The sample type.
+ * @param value The raw value.
+ */
+void raw_record(raw_type_t type, int16_t value);
+
+/**
+ * Write the next frame. A frame starts with the sequence (uint32), the sample count (uint16) and the number of samples
+ * lost since the previous frame (uint16) followed by the samples.
+ *
+ * @param buf The frame buffer.
+ * @param size The buffer size.
+ * @return The frame length or zero if there are no samples.
+ */
+size_t raw_frame(uint8_t *buf, size_t size);
+
+#endif  // RAW_H
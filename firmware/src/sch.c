@@ -0,0 +1,140 @@
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <naos.h>
+
+#include "sch.h"
+#include "trc.h"
+
+#define SCH_MAX_THREADS 8
+
+static portMUX_TYPE sch_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t sch_handle = NULL;
+
+static sch_pt_t *sch_states[SCH_MAX_THREADS];
+static sch_thread_t sch_threads[SCH_MAX_THREADS];
+static size_t sch_count = 0;
+
+static void sch_task(void *p) {
+  // loop forever
+  for (;;) {
+    // get thread count
+    portENTER_CRITICAL(&sch_mux);
+    size_t count = sch_count;
+    portEXIT_CRITICAL(&sch_mux);
+
+    // resume all threads
+    for (size_t i = 0; i < count; i++) {
+      trc_begin(TRC_THREAD, (uint16_t)i);
+      sch_threads[i](sch_states[i]);
+      trc_end(TRC_THREAD, (uint16_t)i);
+    }
+
+    // find next deadline
+    uint32_t now = naos_millis();
+    uint32_t timeout = SCH_FOREVER;
+    for (size_t i = 0; i < count; i++) {
+      // skip threads without deadline
+      if (!sch_states[i]->armed) {
+        continue;
+      }
+
+      // get remaining time
+      int32_t remaining = (int32_t)(sch_states[i]->deadline - now);
+      if (remaining <= 0) {
+        timeout = 0;
+        break;
+      } else if ((uint32_t)remaining < timeout) {
+        timeout = (uint32_t)remaining;
+      }
+    }
+
+    // sleep until signaled or the next deadline expires
+    ulTaskNotifyTake(pdTRUE, timeout == SCH_FOREVER ? portMAX_DELAY
+                                                    : (timeout + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+  }
+}
+
+void sch_init() {
+  // run async task
+  xTaskCreatePinnedToCore(&sch_task, "sch", 8192, NULL, 2, &sch_handle, 1);
+}
+
+void sch_add(sch_pt_t *pt, sch_thread_t t) {
+  // add thread
+  portENTER_CRITICAL(&sch_mux);
+  if (sch_count < SCH_MAX_THREADS) {
+    sch_states[sch_count] = pt;
+    sch_threads[sch_count] = t;
+    sch_count++;
+  }
+  portEXIT_CRITICAL(&sch_mux);
+
+  // wake scheduler
+  xTaskNotifyGive(sch_handle);
+}
+
+uint32_t sch_stack() {
+  // get high water mark
+  return (uint32_t)uxTaskGetStackHighWaterMark(sch_handle);
+}
+
+void sch_signal(sch_pt_t *pt) {
+  // set signal
+  pt->signal = true;
+
+  // wake scheduler if running
+  if (sch_handle != NULL) {
+    xTaskNotifyGive(sch_handle);
+  }
+}
+
+void sch_signal_from_isr(sch_pt_t *pt) {
+  // set signal and remember previous state
+  portENTER_CRITICAL_ISR(&sch_mux);
+  bool signaled = pt->signal;
+  pt->signal = true;
+  portEXIT_CRITICAL_ISR(&sch_mux);
+
+  // return if already signaled
+  if (signaled) {
+    return;
+  }
+
+  // wake scheduler
+  vTaskNotifyGiveFromISR(sch_handle, NULL);
+}
+
+bool sch_take(sch_pt_t *pt) {
+  // read and clear signal
+  portENTER_CRITICAL(&sch_mux);
+  bool signaled = pt->signal;
+  pt->signal = false;
+  portEXIT_CRITICAL(&sch_mux);
+
+  return signaled;
+}
+
+void sch_arm(sch_pt_t *pt, uint32_t ms) {
+  // set deadline
+  pt->armed = ms != SCH_FOREVER;
+  pt->deadline = naos_millis() + ms;
+}
+
+bool sch_ready(sch_pt_t *pt, bool cond) {
+  // check condition
+  if (cond) {
+    pt->armed = false;
+    pt->timeout = false;
+    return true;
+  }
+
+  // check deadline
+  if (pt->armed && (int32_t)(naos_millis() - pt->deadline) >= 0) {
+    pt->armed = false;
+    pt->timeout = true;
+    return true;
+  }
+
+  return false;
+}
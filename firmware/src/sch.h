@@ -0,0 +1,147 @@
+#ifndef SCH_H
+#define SCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The timeout used to wait without a deadline.
+ */
+#define SCH_FOREVER UINT32_MAX
+
+typedef struct {
+  /**
+   * The line to resume at.
+   */
+  uint16_t line;
+
+  /**
+   * Whether a deadline is armed and when it expires.
+   */
+  bool armed;
+  uint32_t deadline;
+
+  /**
+   * Whether the last await ended with a timeout.
+   */
+  bool timeout;
+
+  /**
+   * Whether the thread has been signaled.
+   */
+  volatile bool signal;
+} sch_pt_t;
+
+/**
+ * A thread is a function that is resumed by the scheduler. It may not keep state in local variables between awaits.
+ */
+typedef void (*sch_thread_t)(sch_pt_t *pt);
+
+/**
+ * Marks the intended fall through into the resume label of an await.
+ */
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define SCH_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define SCH_FALLTHROUGH
+#endif
+
+/**
+ * Begin a thread body.
+ */
+#define SCH_BEGIN(pt)     \
+  switch ((pt)->line) {   \
+    case 0:
+
+/**
+ * End a thread body.
+ */
+#define SCH_END(pt) \
+  }                 \
+  (pt)->line = 0
+
+/**
+ * Yield until the condition is true or the timeout in milliseconds has been reached. The condition is evaluated on
+ * every resumption and the timeout flag of the thread tells if the wait ended without the condition.
+ */
+#define SCH_AWAIT(pt, cond, ms)        \
+  do {                                 \
+    sch_arm(pt, ms);                   \
+    (pt)->line = __LINE__;             \
+    SCH_FALLTHROUGH;                   \
+    case __LINE__:                     \
+      if (!sch_ready(pt, (cond))) {    \
+        return;                        \
+      }                                \
+  } while (0)
+
+/**
+ * Yield until the thread has been signaled.
+ */
+#define SCH_SIGNAL(pt) SCH_AWAIT(pt, sch_take(pt), SCH_FOREVER)
+
+/**
+ * Yield for the specified amount of milliseconds.
+ */
+#define SCH_DELAY(pt, ms) SCH_AWAIT(pt, false, ms)
+
+/**
+ * Initialize the scheduler and run its task.
+ */
+void sch_init();
+
+/**
+ * Add a thread to the scheduler.
+ *
+ * @param pt The thread state.
+ * @param t The thread function.
+ */
+void sch_add(sch_pt_t *pt, sch_thread_t t);
+
+/**
+ * Get the minimum amount of stack that remained free in the scheduler task.
+ *
+ * @return The stack high water mark in bytes.
+ */
+uint32_t sch_stack();
+
+/**
+ * Signal a thread from a task.
+ *
+ * @param pt The thread state.
+ */
+void sch_signal(sch_pt_t *pt);
+
+/**
+ * Signal a thread from an interrupt.
+ *
+ * @param pt The thread state.
+ */
+void sch_signal_from_isr(sch_pt_t *pt);
+
+/**
+ * Consume a pending signal.
+ *
+ * @param pt The thread state.
+ * @return Whether the thread was signaled.
+ */
+bool sch_take(sch_pt_t *pt);
+
+/**
+ * Arm the deadline of a thread. Used by SCH_AWAIT.
+ *
+ * @param pt The thread state.
+ * @param ms The timeout.
+ */
+void sch_arm(sch_pt_t *pt, uint32_t ms);
+
+/**
+ * Check if a waiting thread may resume. Used by SCH_AWAIT.
+ *
+ * @param pt The thread state.
+ * @param cond The condition.
+ * @return Whether the thread may resume.
+ */
+bool sch_ready(sch_pt_t *pt, bool cond);
+
+#endif  // SCH_H
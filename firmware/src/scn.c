@@ -0,0 +1,92 @@
+#include <naos.h>
+#include <nvs.h>
+#include <stdio.h>
+
+#include "scn.h"
+
+#define SCN_FLUSH_DELAY 5000
+
+static nvs_handle scn_handle;
+
+static scn_t scn_scenes[SCN_SLOTS] = {0};
+
+static uint32_t scn_dirty = 0;
+static uint32_t scn_changed = 0;
+static uint32_t scn_commits = 0;
+
+void scn_init() {
+  // open namespace
+  ESP_ERROR_CHECK(nvs_open("scenes", NVS_READWRITE, &scn_handle));
+
+  // load scenes
+  for (int i = 0; i < SCN_SLOTS; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "scn-%d", i);
+    size_t len = sizeof(scn_t);
+    if (nvs_get_blob(scn_handle, key, &scn_scenes[i], &len) != ESP_OK || len != sizeof(scn_t)) {
+      scn_scenes[i] = (scn_t){0};
+    }
+  }
+}
+
+bool scn_get(int slot, scn_t *s) {
+  // check slot
+  if (slot < 0 || slot >= SCN_SLOTS || !scn_scenes[slot].used) {
+    return false;
+  }
+
+  // get scene
+  *s = scn_scenes[slot];
+
+  return true;
+}
+
+bool scn_set(int slot, scn_t s) {
+  // check slot
+  if (slot < 0 || slot >= SCN_SLOTS) {
+    return false;
+  }
+
+  // set scene and mark dirty
+  s.used = true;
+  scn_scenes[slot] = s;
+  scn_dirty |= 1u << slot;
+  scn_changed = naos_millis();
+
+  return true;
+}
+
+void scn_flush(bool force) {
+  // check if dirty and delay has passed
+  if (scn_dirty == 0 || (!force && naos_millis() - scn_changed < SCN_FLUSH_DELAY)) {
+    return;
+  }
+
+  // write dirty scenes
+  for (int i = 0; i < SCN_SLOTS; i++) {
+    if (scn_dirty & (1u << i)) {
+      char key[8];
+      snprintf(key, sizeof(key), "scn-%d", i);
+      esp_err_t err = nvs_set_blob(scn_handle, key, &scn_scenes[i], sizeof(scn_t));
+      if (err != ESP_OK) {
+        // keep dirty and retry after delay
+        naos_log("scn: failed to write %s: %s", key, esp_err_to_name(err));
+        scn_changed = naos_millis();
+        return;
+      }
+    }
+  }
+
+  // commit once
+  esp_err_t err = nvs_commit(scn_handle);
+  if (err != ESP_OK) {
+    // keep dirty and retry after delay
+    naos_log("scn: failed to commit: %s", esp_err_to_name(err));
+    scn_changed = naos_millis();
+    return;
+  }
+  scn_commits++;
+  scn_dirty = 0;
+}
+
+uint32_t scn_writes() { return scn_commits; }
@@ -0,0 +1,71 @@
+#ifndef SCN_H
+#define SCN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "led.h"
+
+#define SCN_SLOTS 8
+
+typedef struct {
+  /**
+   * Whether the slot holds a scene.
+   */
+  bool used;
+
+  /**
+   * The target height.
+   */
+  double height;
+
+  /**
+   * The color and fade time.
+   */
+  led_color_t color;
+  int time;
+
+  /**
+   * Whether automate should be enabled.
+   */
+  bool automate;
+} scn_t;
+
+/**
+ * Initialize the scene store and load all scenes from NVS.
+ */
+void scn_init();
+
+/**
+ * Get a scene.
+ *
+ * @param slot The slot.
+ * @param s The scene.
+ * @return Whether the slot holds a scene.
+ */
+bool scn_get(int slot, scn_t *s);
+
+/**
+ * Store a scene. The scene is persisted to NVS with the next flush.
+ *
+ * @param slot The slot.
+ * @param s The scene.
+ * @return Whether the scene has been stored.
+ */
+bool scn_set(int slot, scn_t s);
+
+/**
+ * Persist changed scenes to NVS once no scene has changed for a while.
+ *
+ * @param force Whether to persist immediately.
+ */
+void scn_flush(bool force);
+
+/**
+ * Get the number of NVS commits since boot.
+ *
+ * @return The commits.
+ */
+uint32_t scn_writes();
+
+#endif  // SCN_H
@@ -0,0 +1,33 @@
+#include <stdio.h>
+
+#include "sum.h"
+
+void sum_add(sum_stat_t *stat, double value) {
+  // update min and max
+  if (stat->count == 0 || value < stat->min) {
+    stat->min = value;
+  }
+  if (stat->count == 0 || value > stat->max) {
+    stat->max = value;
+  }
+
+  // update total and count
+  stat->total += value;
+  stat->count++;
+}
+
+int sum_format(sum_stat_t *stat, const char *name, char *buf, int len) {
+  // calculate mean
+  double mean = stat->count > 0 ? stat->total / stat->count : 0;
+
+  // format statistic
+  int n = snprintf(buf, (size_t)len, "%s-min=%.1f %s-max=%.1f %s-mean=%.1f %s-count=%u", name, stat->min, name,
+                   stat->max, name, mean, name, (unsigned int)stat->count);
+
+  return n < len ? n : len - 1;
+}
+
+void sum_reset(sum_stat_t *stat) {
+  // clear statistic
+  *stat = (sum_stat_t){0};
+}
@@ -0,0 +1,49 @@
+#ifndef SUM_H
+#define SUM_H
+
+#include <stdint.h>
+
+typedef struct {
+  /**
+   * The minimum and maximum value.
+   */
+  double min, max;
+
+  /**
+   * The sum of all values.
+   */
+  double total;
+
+  /**
+   * The number of values.
+   */
+  uint32_t count;
+} sum_stat_t;
+
+/**
+ * Add a value to the statistic.
+ *
+ * @param stat The statistic.
+ * @param value The value.
+ */
+void sum_add(sum_stat_t *stat, double value);
+
+/**
+ * Format the statistic as "name-min=X name-max=X name-mean=X name-count=X".
+ *
+ * @param stat The statistic.
+ * @param name The name.
+ * @param buf The buffer.
+ * @param len The buffer length.
+ * @return The number of written characters.
+ */
+int sum_format(sum_stat_t *stat, const char *name, char *buf, int len);
+
+/**
+ * Reset the statistic.
+ *
+ * @param stat The statistic.
+ */
+void sum_reset(sum_stat_t *stat);
+
+#endif  // SUM_H
@@ -0,0 +1,73 @@
+#ifdef TRC_HOST
+#include <time.h>
+#else
+#include <esp_timer.h>
+#endif
+
+#include "trc.h"
+
+#define TRC_SIZE 1024
+
+static trc_event_t trc_ring[TRC_SIZE];
+
+static volatile bool trc_on = false;
+static volatile uint32_t trc_head = 0;
+static uint32_t trc_tail = 0;
+
+uint32_t trc_now() {
+#ifdef TRC_HOST
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#else
+  return (uint32_t)esp_timer_get_time();
+#endif
+}
+
+void trc_enable(bool on) {
+  // keep recorded events when disabling
+  if (!on) {
+    trc_on = false;
+    return;
+  }
+
+  // reset ring
+  trc_on = false;
+  trc_head = 0;
+  trc_tail = 0;
+
+  // set flag
+  trc_on = true;
+}
+
+void trc_record(trc_id_t id, trc_phase_t phase, uint16_t arg) {
+  // check flag
+  if (!trc_on) {
+    return;
+  }
+
+  // claim slot
+  uint32_t i = __sync_fetch_and_add(&trc_head, 1);
+
+  // write event
+  trc_ring[i % TRC_SIZE] = (trc_event_t){.time = trc_now(), .id = (uint8_t)id, .phase = (uint8_t)phase, .arg = arg};
+}
+
+size_t trc_collect(trc_event_t *buf, size_t num) {
+  // get head
+  uint32_t head = trc_head;
+
+  // skip overwritten events
+  if (head - trc_tail > TRC_SIZE) {
+    trc_tail = head - TRC_SIZE;
+  }
+
+  // copy events
+  size_t n = 0;
+  while (trc_tail != head && n < num) {
+    buf[n++] = trc_ring[trc_tail % TRC_SIZE];
+    trc_tail++;
+  }
+
+  return n;
+}
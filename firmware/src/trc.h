@@ -0,0 +1,80 @@
+#ifndef TRC_H
+#define TRC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  TRC_THREAD,    // scheduler thread run (arg: thread index)
+  TRC_ISR,       // interrupt handler (arg: gpio)
+  TRC_FEED,      // state machine feed (arg: state)
+  TRC_APPROACH,  // motor approach
+  TRC_PUBLISH,   // telemetry publish
+} trc_id_t;
+
+typedef enum {
+  TRC_BEGIN,  // begin of span
+  TRC_END,    // end of span
+} trc_phase_t;
+
+typedef struct __attribute__((packed)) {
+  /**
+   * The time in microseconds.
+   */
+  uint32_t time;
+
+  /**
+   * The trace id and phase.
+   */
+  uint8_t id, phase;
+
+  /**
+   * The optional argument.
+   */
+  uint16_t arg;
+} trc_event_t;
+
+/**
+ * Enable or disable recording. Enabling clears the ring.
+ *
+ * @param on Whether to record.
+ */
+void trc_enable(bool on);
+
+/**
+ * Record an event. May be called from tasks and interrupts.
+ *
+ * @param id The trace id.
+ * @param phase The phase.
+ * @param arg The argument.
+ */
+void trc_record(trc_id_t id, trc_phase_t phase, uint16_t arg);
+
+/**
+ * Record the begin of a span.
+ */
+#define trc_begin(id, arg) trc_record(id, TRC_BEGIN, arg)
+
+/**
+ * Record the end of a span.
+ */
+#define trc_end(id, arg) trc_record(id, TRC_END, arg)
+
+/**
+ * Collect the recorded events that have not been collected yet, oldest first.
+ *
+ * @param buf The event buffer.
+ * @param num The buffer size.
+ * @return The number of collected events.
+ */
+size_t trc_collect(trc_event_t *buf, size_t num);
+
+/**
+ * Get the current trace time.
+ *
+ * @return The time in microseconds.
+ */
+uint32_t trc_now();
+
+#endif  // TRC_H
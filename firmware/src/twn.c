@@ -0,0 +1,47 @@
+#include <math.h>
+
+#include "twn.h"
+
+double twn_predict(twn_plan_t *plan, uint32_t time) {
+  // get distance and direction
+  double distance = fabs(plan->target - plan->position);
+  double dir = plan->target >= plan->position ? 1 : -1;
+
+  // check plan
+  double a = plan->max_acceleration;
+  double vm = plan->max_velocity;
+  if (distance == 0 || a <= 0 || vm <= 0) {
+    return plan->target;
+  }
+
+  // get initial velocity towards target (movements away from the target are left to corrections)
+  double v0 = fmin(fmax(plan->velocity * dir, 0), vm);
+
+  // calculate peak velocity and accelerate, cruise and decelerate phases
+  double vp = vm;
+  if ((vm * vm - v0 * v0) / (2 * a) + vm * vm / (2 * a) > distance) {
+    vp = fmax(sqrt(a * distance + v0 * v0 / 2), v0);
+  }
+  double t1 = (vp - v0) / a;
+  double d1 = (v0 + vp) / 2 * t1;
+  double t3 = vp / a;
+  double d3 = vp * vp / (2 * a);
+  double d2 = fmax(distance - d1 - d3, 0);
+  double t2 = d2 / vp;
+
+  // calculate travelled distance at elapsed time
+  double t = (double)(uint32_t)(time - plan->start);
+  double d = 0;
+  if (t < t1) {
+    d = v0 * t + a * t * t / 2;
+  } else if (t < t1 + t2) {
+    d = d1 + vp * (t - t1);
+  } else if (t < t1 + t2 + t3) {
+    double td = t - t1 - t2;
+    d = d1 + d2 + vp * td - a * td * td / 2;
+  } else {
+    d = distance;
+  }
+
+  return plan->position + dir * fmin(d, distance);
+}
@@ -0,0 +1,38 @@
+#ifndef TWN_H
+#define TWN_H
+
+#include <stdint.h>
+
+typedef struct {
+  /**
+   * The time in milliseconds the plan started.
+   */
+  uint32_t start;
+
+  /**
+   * The position in cm and velocity in cm/ms at the start of the plan.
+   */
+  double position, velocity;
+
+  /**
+   * The target position in cm.
+   */
+  double target;
+
+  /**
+   * The profile limits in cm/ms and cm/ms^2.
+   */
+  double max_velocity, max_acceleration;
+} twn_plan_t;
+
+/**
+ * Predict the position of a trapezoidal motion plan. The function has no device dependencies and may be compiled
+ * by observers to follow a light between plan updates.
+ *
+ * @param plan The plan.
+ * @param time The time in milliseconds.
+ * @return The predicted position.
+ */
+double twn_predict(twn_plan_t *plan, uint32_t time);
+
+#endif  // TWN_H
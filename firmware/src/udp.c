@@ -0,0 +1,215 @@
+#include <freertos/FreeRTOS.h>
+#include <lwip/sockets.h>
+#include <string.h>
+
+#include "sch.h"
+#include "udp.h"
+
+#define UDP_MAGIC 0x544D
+#define UDP_HEADER 8
+#define UDP_SLOT 10
+#define UDP_SLOTS 146   // (1472 - header) / slot
+#define UDP_DRAIN 32    // datagrams read per tick
+#define UDP_RESYNC 500  // frames, a larger backward jump is a restarted sender
+
+BUS_TOPIC(udp_bus, udp_event_t, 4);
+
+static portMUX_TYPE udp_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static sch_pt_t udp_pt;
+
+// the requested configuration, applied by the thread
+static bool udp_pending = false;
+static bool udp_want = false;
+static char udp_want_group[16] = {0};
+static int udp_want_port = 0;
+static int udp_want_slot = 0;
+
+// the active socket, owned by the thread
+static int udp_socket = -1;
+static int udp_slot = 0;
+static bool udp_first = true;
+static uint32_t udp_seq = 0;
+static volatile uint32_t udp_drops = 0;
+
+static uint16_t udp_u16(const uint8_t *buf) {
+  // read little endian value
+  return (uint16_t)(buf[0] | buf[1] << 8);
+}
+
+static int udp_receive(udp_event_t *e) {
+  // receive only the header and the frame up to the own slot, the rest of the datagram is discarded
+  static uint8_t buf[UDP_HEADER + UDP_SLOTS * UDP_SLOT];
+  size_t want = UDP_HEADER + (size_t)(udp_slot + 1) * UDP_SLOT;
+  int len = recv(udp_socket, buf, want, 0);
+  if (len < 0) {
+    return -1;
+  } else if (len < UDP_HEADER || udp_u16(buf) != UDP_MAGIC) {
+    return 0;
+  }
+
+  // read sequence and count
+  uint32_t seq = (uint32_t)udp_u16(buf + 2) | (uint32_t)udp_u16(buf + 4) << 16;
+  uint16_t count = udp_u16(buf + 6);
+
+  // drop late frames unless the sender restarted and frames without own slot
+  bool late = !udp_first && (int32_t)(seq - udp_seq) <= 0 && udp_seq - seq <= UDP_RESYNC;
+  if (late || udp_slot >= count || len < (int)want) {
+    udp_drops++;
+    return 0;
+  }
+
+  // save sequence
+  udp_first = false;
+  udp_seq = seq;
+
+  // decode slot
+  const uint8_t *s = buf + UDP_HEADER + udp_slot * UDP_SLOT;
+  e->seq = seq;
+  e->height = udp_u16(s) / 10.0;
+  e->red = udp_u16(s + 2);
+  e->green = udp_u16(s + 4);
+  e->blue = udp_u16(s + 6);
+  e->white = udp_u16(s + 8);
+
+  return 1;
+}
+
+static void udp_drain() {
+  // read queued datagrams and keep the newest frame
+  udp_event_t latest;
+  bool found = false;
+  for (int i = 0; i < UDP_DRAIN; i++) {
+    int ret = udp_receive(&latest);
+    if (ret < 0) {
+      break;
+    }
+    found = found || ret > 0;
+  }
+
+  // publish newest frame
+  if (found) {
+    *(udp_event_t *)bus_claim(&udp_bus) = latest;
+    bus_commit(&udp_bus);
+  }
+}
+
+static void udp_close() {
+  // close socket
+  if (udp_socket >= 0) {
+    close(udp_socket);
+    udp_socket = -1;
+  }
+}
+
+static void udp_open(const char *group, int port, int slot) {
+  // create socket
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  if (s < 0) {
+    return;
+  }
+
+  // bind to port
+  struct sockaddr_in addr = {0};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(s);
+    return;
+  }
+
+  // join multicast group
+  struct ip_mreq mreq = {0};
+  mreq.imr_multiaddr.s_addr = inet_addr(group);
+  mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+    close(s);
+    return;
+  }
+
+  // make non-blocking
+  fcntl(s, F_SETFL, O_NONBLOCK);
+
+  // reset sequence
+  udp_first = true;
+  udp_slot = slot;
+  udp_socket = s;
+}
+
+static void udp_apply() {
+  // take requested configuration
+  portENTER_CRITICAL(&udp_mux);
+  bool pending = udp_pending;
+  bool want = udp_want;
+  char group[sizeof(udp_want_group)];
+  memcpy(group, udp_want_group, sizeof(group));
+  int port = udp_want_port;
+  int slot = udp_want_slot;
+  udp_pending = false;
+  portEXIT_CRITICAL(&udp_mux);
+
+  // reopen socket
+  if (pending) {
+    udp_close();
+    if (want) {
+      udp_open(group, port, slot);
+    }
+  }
+}
+
+static void udp_thread(sch_pt_t *pt) {
+  SCH_BEGIN(pt);
+
+  // loop forever
+  for (;;) {
+    // apply configuration changes
+    udp_apply();
+
+    // receive pending frames
+    if (udp_socket >= 0) {
+      udp_drain();
+    }
+
+    // wait 2ms while streaming or until reconfigured
+    if (udp_socket >= 0) {
+      SCH_AWAIT(pt, sch_take(pt), 2);
+    } else {
+      SCH_SIGNAL(pt);
+    }
+  }
+
+  SCH_END(pt);
+}
+
+void udp_init() {
+  // add thread
+  sch_add(&udp_pt, udp_thread);
+}
+
+void udp_start(const char *group, int port, int slot) {
+  // request socket, invalid slots and groups close the socket
+  portENTER_CRITICAL(&udp_mux);
+  udp_pending = true;
+  udp_want = slot >= 0 && slot < UDP_SLOTS && strlen(group) < sizeof(udp_want_group);
+  strncpy(udp_want_group, group, sizeof(udp_want_group) - 1);
+  udp_want_port = port;
+  udp_want_slot = slot;
+  portEXIT_CRITICAL(&udp_mux);
+
+  // wake thread
+  sch_signal(&udp_pt);
+}
+
+void udp_stop() {
+  // request close
+  portENTER_CRITICAL(&udp_mux);
+  udp_pending = true;
+  udp_want = false;
+  portEXIT_CRITICAL(&udp_mux);
+
+  // wake thread
+  sch_signal(&udp_pt);
+}
+
+uint32_t udp_dropped() { return udp_drops; }
@@ -0,0 +1,63 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus.h"
+
+typedef struct {
+  /**
+   * The frame sequence number.
+   */
+  uint32_t seq;
+
+  /**
+   * The target height in cm.
+   */
+  double height;
+
+  /**
+   * The color from 0 to 1023.
+   */
+  int red, green, blue, white;
+} udp_event_t;
+
+/**
+ * The topic that receives the own slot of new frames.
+ */
+extern bus_topic_t udp_bus;
+
+/**
+ * Initialize the frame receiver.
+ */
+void udp_init();
+
+/**
+ * Start receiving frames from a multicast group.
+ *
+ * Frames start with a header of a magic (uint16, 0x544D), the sequence (uint32) and the slot count (uint16)
+ * followed by 10 byte slots: height in mm (uint16) and red, green, blue and white (uint16). All values are little
+ * endian. Frames that are older than the last received frame are dropped unless the sequence jumped back far
+ * enough to indicate a restarted sender. Queued frames are drained every 2 ms and only the newest is published.
+ * The socket is opened by the receiver thread, so the function may be called from any task.
+ *
+ * @param group The multicast group address.
+ * @param port The port.
+ * @param slot The slot of this light.
+ */
+void udp_start(const char *group, int port, int slot);
+
+/**
+ * Stop receiving frames. The socket is closed by the receiver thread.
+ */
+void udp_stop();
+
+/**
+ * Get the number of frames dropped because they arrived late or did not include the slot.
+ *
+ * @return The dropped frames.
+ */
+uint32_t udp_dropped();
+
+#endif  // UDP_H
@@ -0,0 +1,30 @@
+#include <art32/numbers.h>
+
+#include "wht.h"
+
+led_color_t wht_extract(led_color_t c, int r, int g, int b) {
+  // check calibration
+  if (r == 0 && g == 0 && b == 0) {
+    return c;
+  }
+
+  // find largest white duty that fits into all channels and the remaining white headroom (fixed point, 0 to 1023)
+  int w = a32_constrain_i(1023 - c.w, 0, 1023);
+  if (r > 0) {
+    w = a32_constrain_i(c.r * 1023 / r, 0, w);
+  }
+  if (g > 0) {
+    w = a32_constrain_i(c.g * 1023 / g, 0, w);
+  }
+  if (b > 0) {
+    w = a32_constrain_i(c.b * 1023 / b, 0, w);
+  }
+
+  // move white component from color channels to white channel
+  c.r -= w * r / 1023;
+  c.g -= w * g / 1023;
+  c.b -= w * b / 1023;
+  c.w = a32_constrain_i(c.w + w, 0, 1023);
+
+  return c;
+}
@@ -0,0 +1,19 @@
+#ifndef WHT_H
+#define WHT_H
+
+#include "led.h"
+
+/**
+ * Extract the common white component of a color into the white channel. The largest white duty that fits into the
+ * color channels and the remaining headroom of the white channel is moved to the white channel using integer math
+ * only. The function has no device dependencies and may be compiled by hosts to check the color accuracy.
+ *
+ * @param c The color.
+ * @param r The red output of the white channel at full duty from 0 to 1023.
+ * @param g The green output of the white channel at full duty from 0 to 1023.
+ * @param b The blue output of the white channel at full duty from 0 to 1023.
+ * @return The converted color or the color if the calibration is zero.
+ */
+led_color_t wht_extract(led_color_t c, int r, int g, int b);
+
+#endif  // WHT_H
@@ -28,6 +28,30 @@ let dotSize = 16
 let marginX: Double = 250
 let marginY: Double = 200
 
+enum Command {
+    case flash(UIColor, Int)
+    
+    var topic: String {
+        switch self {
+        case .flash: return "flash"
+        }
+    }
+    
+    var payload: String {
+        switch self {
+        case .flash(let color, let time):
+            // get color components
+            var red: CGFloat = 0
+            var green: CGFloat = 0
+            var blue: CGFloat = 0
+            color.getRed(&red, green: &green, blue: &blue, alpha: nil)
+            
+            // format payload
+            return String(format: "%d %d %d 0 %d", Int(red * 1023), Int(green * 1023), Int(blue * 1023), time)
+        }
+    }
+}
+
 class ViewController: UIViewController, CocoaMQTTDelegate {
     var container: UIView?
     var circles: [[UIView]]?
@@ -164,21 +188,36 @@ class ViewController: UIViewController, CocoaMQTTDelegate {
     
     @objc
     func animation() {
-        // get current color
-        var red: CGFloat = 0
-        var green: CGFloat = 0
-        var blue: CGFloat = 0
-        onColor.getRed(&red, green: &green, blue: &blue, alpha: nil)
+        // flash all lights
+        sendAll(command: .flash(onColor, 4000))
+    }
+    
+    func send(id: Int, command: Command) {
+        // return immediately if not connected
+        if !connected {
+            return
+        }
+        
+        // send message
+        client!.publish("lights/" + String(id) + "/" + command.topic, withString: command.payload)
+    }
+    
+    func sendAll(command: Command) {
+        // return immediately if not connected
+        if !connected {
+            return
+        }
         
-        // construct payload
-        let payload = String(Int(red * 1023)) + " " + String(Int(green * 1023)) + " " + String(Int(blue * 1023)) + " 0 4000"
+        // format topic suffix and payload once
+        let topic = command.topic
+        let payload = command.payload
         
         // send messages
         for id in 1...24 {
-            client!.publish("lights/" + String(id) + "/flash", withString: payload)
+            client!.publish("lights/" + String(id) + "/" + topic, withString: payload)
         }
     }
- 
+    
     func handleTouches(touches: Set<UITouch>) {
         // handle all touches
         touches.forEach { (touch) in
@@ -218,20 +257,8 @@ class ViewController: UIViewController, CocoaMQTTDelegate {
         // get view from array
         let v = circles![yy][xx]
         
-        // send message
-        if connected {
-            // get current color
-            var red: CGFloat = 0
-            var green: CGFloat = 0
-            var blue: CGFloat = 0
-            onColor.getRed(&red, green: &green, blue: &blue, alpha: nil)
-            
-            // construct payload
-            let payload = String(Int(red * 1023)) + " " + String(Int(green * 1023)) + " " + String(Int(blue * 1023)) + " 0 500"
-            
-            // perform flash
-            client!.publish("lights/" + String(id) + "/flash", withString: payload)
-        }
+        // perform flash
+        send(id: id, command: .flash(onColor, 500))
         
         // set state
         states![yy][xx] = true
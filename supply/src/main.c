@@ -1,24 +1,43 @@
 #include <driver/gpio.h>
 #include <naos.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "led.h"
 #include "rls.h"
+#include "wdg.h"
+
+// the time a bank is powered off when cycled
+#define CYCLE_TIME 5000
 
 static bool r1 = false;
 static bool r2 = false;
 static bool r3 = false;
+static bool watchdog = false;
+static int watchdog_timeout = 0;
+
+static int cycle_bank = 0;
+static uint32_t cycle_start = 0;
 
 static naos_status_t st;
 
-static void update(const char *param, const char *value) {
-  rls_set(r1, r2, r3);
+static void report();
+
+static void relays() {
+  // set relays with a cycled bank powered off
+  rls_set(r1 && cycle_bank != 1, r2 && cycle_bank != 2, r3 && cycle_bank != 3);
 }
 
-static void status(naos_status_t status) {
-  // save status
-  st = status;
+static void update(const char *param, const char *value) {
+  relays();
+
+  // report configuration
+  report();
+}
 
-  switch (status) {
+static void leds() {
+  // show network status
+  switch (st) {
     case NAOS_DISCONNECTED:
       led_set(false, false);
       break;
@@ -31,27 +50,141 @@ static void status(naos_status_t status) {
   }
 }
 
+static void status(naos_status_t status) {
+  // save status
+  st = status;
+
+  // update leds
+  leds();
+}
+
+static void online() {
+  // forget lights and attempts
+  wdg_reset();
+
+  // subscribe heartbeats
+  naos_subscribe("alive", 0, NAOS_GLOBAL);
+
+  // report configuration
+  report();
+}
+
+static void message(const char *topic, uint8_t *payload, size_t len, naos_scope_t scope) {
+  // track light heartbeats
+  if (strcmp(topic, "alive") == 0 && scope == NAOS_GLOBAL) {
+    char id[16] = {0};
+    int bank = 0;
+    if (sscanf((const char *)payload, "%15s %d", id, &bank) == 2) {
+      wdg_seen(id, bank, naos_millis());
+    }
+  }
+}
+
+static void loop() {
+  // restore power after cycle
+  if (cycle_bank != 0) {
+    if (naos_millis() - cycle_start >= CYCLE_TIME) {
+      naos_log("watchdog: restored bank %d", cycle_bank);
+      cycle_bank = 0;
+      relays();
+    }
+    return;
+  }
+
+  // check for silent lights
+  if (!watchdog || st != NAOS_NETWORKED) {
+    return;
+  }
+
+  // forget banks that are switched off
+  bool on[3] = {r1, r2, r3};
+  for (int b = 0; b < 3; b++) {
+    if (!on[b]) {
+      wdg_forget(b + 1);
+    }
+  }
+
+  // get bank to cycle
+  int bank = wdg_check(naos_millis(), (uint32_t)watchdog_timeout);
+  if (bank == 0) {
+    return;
+  }
+
+  // power off bank
+  naos_log("watchdog: cycling bank %d", bank);
+  cycle_bank = bank;
+  cycle_start = naos_millis();
+  relays();
+
+  // publish cycle
+  char buf[4];
+  snprintf(buf, sizeof(buf), "%d", bank);
+  naos_publish("cycle", buf, 0, false, NAOS_LOCAL);
+}
+
 static void ping() {
+  // flash both leds
   led_set(true, true);
   naos_delay(300);
-  status(st);
+  leds();
 }
 
-static naos_param_t params[3] = {
+static naos_param_t params[5] = {
     {.name = "relay-1", .type = NAOS_BOOL, .default_b = false, .sync_b = &r1},
     {.name = "relay-2", .type = NAOS_BOOL, .default_b = false, .sync_b = &r2},
     {.name = "relay-3", .type = NAOS_BOOL, .default_b = false, .sync_b = &r3},
+    {.name = "watchdog", .type = NAOS_BOOL, .default_b = false, .sync_b = &watchdog},
+    {.name = "watchdog-timeout", .type = NAOS_LONG, .default_l = 60000, .sync_l = &watchdog_timeout},
 };
 
 static naos_config_t config = {.device_type = "tm-ps",
                                .firmware_version = "0.3.0",
                                .parameters = params,
-                               .num_parameters = 3,
+                               .num_parameters = 5,
                                .ping_callback = ping,
+                               .online_callback = online,
                                .update_callback = update,
                                .status_callback = status,
+                               .message_callback = message,
+                               .loop_callback = loop,
+                               .loop_interval = 100,
                                .password = "tm2018"};
 
+static void report() {
+  // hash all parameter values
+  uint32_t digest = 2166136261u;
+  for (size_t i = 0; i < config.num_parameters; i++) {
+    // format value
+    char value[16] = {0};
+    naos_param_t *p = &params[i];
+    switch (p->type) {
+      case NAOS_BOOL:
+        snprintf(value, sizeof(value), "%d", *p->sync_b);
+        break;
+      case NAOS_LONG:
+        snprintf(value, sizeof(value), "%d", (int)*p->sync_l);
+        break;
+      default:
+        break;
+    }
+
+    // add "name=value;" to digest
+    const char *parts[] = {p->name, "=", value, ";"};
+    for (int j = 0; j < 4; j++) {
+      for (const char *c = parts[j]; *c != 0; c++) {
+        digest ^= (uint8_t)*c;
+        digest *= 16777619u;
+      }
+    }
+  }
+
+  // publish retained report
+  char buf[96];
+  snprintf(buf, sizeof(buf), "type=%s version=%s params=%u digest=%08x", config.device_type, config.firmware_version,
+           (unsigned int)config.num_parameters, (unsigned int)digest);
+  naos_publish("config", buf, 0, true, NAOS_LOCAL);
+}
+
 void app_main() {
   // init led
   led_init();
@@ -63,5 +196,5 @@ void app_main() {
   naos_init(&config);
 
   // set relays
-  rls_set(r1, r2, r3);
+  relays();
 }
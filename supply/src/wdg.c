@@ -0,0 +1,168 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "wdg.h"
+
+#define WDG_LIGHTS 32
+#define WDG_BANKS 3
+#define WDG_ID 16
+
+// the minimum time between any two power cycles
+#define WDG_SPACING (1000 * 60 * 2)
+
+// the initial and maximum backoff before a bank is cycled again
+#define WDG_BACKOFF (1000 * 60 * 5)
+#define WDG_BACKOFF_MAX (1000 * 60 * 60)
+
+// the number of cycles per bank before its silent lights are forgotten until they return
+#define WDG_ATTEMPTS 5
+
+typedef struct {
+  char id[WDG_ID];
+  int bank;
+  uint32_t last;
+} wdg_light_t;
+
+typedef struct {
+  int attempts;
+  uint32_t backoff;
+  uint32_t last;
+} wdg_bank_t;
+
+static wdg_light_t wdg_lights[WDG_LIGHTS];
+static int wdg_count = 0;
+
+static wdg_bank_t wdg_banks[WDG_BANKS];
+static bool wdg_cycled = false;
+static uint32_t wdg_last = 0;
+
+static void wdg_remove(int i) {
+  // move last light into slot
+  wdg_lights[i] = wdg_lights[--wdg_count];
+}
+
+void wdg_seen(const char *id, int bank, uint32_t now) {
+  // check bank
+  if (bank < 0 || bank > WDG_BANKS) {
+    return;
+  }
+
+  // find light
+  int i = 0;
+  while (i < wdg_count && strncmp(wdg_lights[i].id, id, WDG_ID - 1) != 0) {
+    i++;
+  }
+
+  // remove light that is no longer powered by a bank
+  if (bank == 0) {
+    if (i < wdg_count) {
+      wdg_remove(i);
+    }
+    return;
+  }
+
+  // add light if space is available
+  if (i == wdg_count) {
+    if (wdg_count == WDG_LIGHTS) {
+      return;
+    }
+    strncpy(wdg_lights[i].id, id, WDG_ID - 1);
+    wdg_count++;
+  }
+
+  // update light
+  wdg_lights[i].bank = bank;
+  wdg_lights[i].last = now;
+}
+
+int wdg_check(uint32_t now, uint32_t timeout) {
+  // get age of the latest heartbeat
+  uint32_t latest = UINT32_MAX;
+  for (int i = 0; i < wdg_count; i++) {
+    if (now - wdg_lights[i].last < latest) {
+      latest = now - wdg_lights[i].last;
+    }
+  }
+
+  // count silent lights per bank, only lights that timed out before another light was heard are silent as the
+  // network or broker is more likely at fault otherwise
+  int silent[WDG_BANKS] = {0};
+  for (int i = 0; i < wdg_count; i++) {
+    uint32_t age = now - wdg_lights[i].last;
+    if (age > timeout && age - latest > timeout) {
+      silent[wdg_lights[i].bank - 1]++;
+    }
+  }
+
+  // reset banks whose lights are all alive again
+  for (int b = 0; b < WDG_BANKS; b++) {
+    if (silent[b] == 0) {
+      wdg_banks[b].attempts = 0;
+      wdg_banks[b].backoff = 0;
+    }
+  }
+
+  // respect spacing between cycles
+  if (wdg_cycled && now - wdg_last < WDG_SPACING) {
+    return 0;
+  }
+
+  // find first bank with silent lights that is due
+  for (int b = 0; b < WDG_BANKS; b++) {
+    wdg_bank_t *bank = &wdg_banks[b];
+    if (silent[b] == 0 || (bank->attempts > 0 && now - bank->last < bank->backoff)) {
+      continue;
+    }
+
+    // give up on the silent lights of a bank after the last attempt, they are added again once they return
+    if (bank->attempts >= WDG_ATTEMPTS) {
+      for (int i = wdg_count - 1; i >= 0; i--) {
+        uint32_t age = now - wdg_lights[i].last;
+        if (wdg_lights[i].bank == b + 1 && age > timeout && age - latest > timeout) {
+          wdg_remove(i);
+        }
+      }
+      *bank = (wdg_bank_t){0};
+      continue;
+    }
+
+    // record attempt and double backoff
+    bank->attempts++;
+    bank->last = now;
+    bank->backoff = bank->backoff == 0 ? WDG_BACKOFF : bank->backoff * 2;
+    if (bank->backoff > WDG_BACKOFF_MAX) {
+      bank->backoff = WDG_BACKOFF_MAX;
+    }
+    wdg_cycled = true;
+    wdg_last = now;
+
+    return b + 1;
+  }
+
+  return 0;
+}
+
+void wdg_forget(int bank) {
+  // check bank
+  if (bank < 1 || bank > WDG_BANKS) {
+    return;
+  }
+
+  // remove lights of bank
+  int n = 0;
+  for (int i = 0; i < wdg_count; i++) {
+    if (wdg_lights[i].bank != bank) {
+      wdg_lights[n++] = wdg_lights[i];
+    }
+  }
+  wdg_count = n;
+
+  // clear attempts
+  wdg_banks[bank - 1] = (wdg_bank_t){0};
+}
+
+void wdg_reset() {
+  // forget lights and attempts
+  wdg_count = 0;
+  memset(wdg_banks, 0, sizeof(wdg_banks));
+}
@@ -0,0 +1,38 @@
+#ifndef WDG_H
+#define WDG_H
+
+#include <stdint.h>
+
+/**
+ * Record a heartbeat of a light. A heartbeat with bank zero removes the light.
+ *
+ * @param id The light id.
+ * @param bank The relay bank (1-3) powering the light or zero.
+ * @param now The current time in milliseconds.
+ */
+void wdg_seen(const char *id, int bank, uint32_t now);
+
+/**
+ * Check for banks with lights that have been silent for longer than the timeout while other lights were heard after
+ * the timeout expired. A returned bank is recorded as cycled and will only be returned again after its backoff. The
+ * silent lights of a bank that has been cycled too often are forgotten until they send a heartbeat again.
+ *
+ * @param now The current time in milliseconds.
+ * @param timeout The heartbeat timeout in milliseconds.
+ * @return The bank (1-3) to power cycle or zero.
+ */
+int wdg_check(uint32_t now, uint32_t timeout);
+
+/**
+ * Forget the lights and attempts of a bank, e.g. because it has been switched off.
+ *
+ * @param bank The relay bank (1-3).
+ */
+void wdg_forget(int bank);
+
+/**
+ * Forget all lights and attempts.
+ */
+void wdg_reset();
+
+#endif  // WDG_H
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "bus.h"
+}
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct event {
+  uint32_t seq;
+  int64_t time;
+};
+
+// the topic has the capacity of the encoder topic
+BUS_TOPIC(topic, event, 32);
+
+int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+void throughput() {
+  // publish and read events on a single thread
+  const uint32_t count = 10000000;
+  bus_sub_t s;
+  bus_subscribe(&s, &topic);
+  auto start = clock_type::now();
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    auto *e = static_cast<event *>(bus_claim(&topic));
+    e->seq = i;
+    bus_commit(&topic);
+    sum += static_cast<const event *>(bus_next(&s))->seq;
+  }
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  printf("throughput events=%u ns/event=%.1f events/s=%.3g (checksum %llu)\n", count, seconds * 1e9 / count,
+         count / seconds, static_cast<unsigned long long>(sum % 1000));
+}
+
+void sustained(double seconds, int stall) {
+  // publish 10 events per ms from a sensor thread and drain them every ms like the naos loop, which stalls for the
+  // specified ms once per second (e.g. while publishing on a slow network)
+  bus_sub_t s;
+  bus_subscribe(&s, &topic);
+  std::atomic<bool> done{false};
+  auto ms = static_cast<uint32_t>(seconds * 1000);
+  std::thread publisher([&] {
+    auto next = clock_type::now();
+    for (uint32_t i = 0; i < ms * 10; i++) {
+      auto *e = static_cast<event *>(bus_claim(&topic));
+      e->seq = i;
+      e->time = now();
+      bus_commit(&topic);
+      if (i % 10 == 9) {
+        next += std::chrono::milliseconds(1);
+        std::this_thread::sleep_until(next);
+      }
+    }
+    done = true;
+  });
+
+  // drain events
+  uint64_t received = 0;
+  size_t backlog = 0;
+  std::vector<int64_t> latencies;
+  latencies.reserve(ms * 10);
+  auto second = clock_type::now();
+  for (;;) {
+    bool finished = done;
+    size_t pending = 0;
+    const void *p;
+    while ((p = bus_next(&s)) != nullptr) {
+      latencies.push_back(now() - static_cast<const event *>(p)->time);
+      received++;
+      pending++;
+    }
+    backlog = std::max(backlog, pending);
+    if (finished) {
+      break;
+    }
+    if (stall > 0 && clock_type::now() - second >= std::chrono::seconds(1)) {
+      second = clock_type::now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  publisher.join();
+
+  // report
+  std::sort(latencies.begin(), latencies.end());
+  auto pct = [&](double q) {
+    if (latencies.empty()) {
+      return 0.0;
+    }
+    return static_cast<double>(latencies[static_cast<size_t>(q * static_cast<double>(latencies.size() - 1))]) / 1e3;
+  };
+  printf("sustained rate=10000/s seconds=%.1f stall=%dms received=%llu dropped=%u backlog=%zu latency p50=%.0fus "
+         "p99=%.0fus max=%.0fus\n",
+         seconds, stall, static_cast<unsigned long long>(received), s.dropped, backlog, pct(0.5), pct(0.99), pct(1));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // read duration
+  double seconds = argc > 1 ? atof(argv[1]) : 5;
+
+  // run benchmarks
+  throughput();
+  sustained(seconds, 0);
+  sustained(seconds, 10);
+
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/lights.h"
+#include "client/mqtt.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct options {
+  client::options mqtt;
+  int lights = 1000;
+  int rounds = 20;
+};
+
+bool wait(const std::atomic<uint64_t> &counter, uint64_t target) {
+  // wait up to ten seconds for the counter
+  auto deadline = clock_type::now() + std::chrono::seconds(10);
+  while (counter < target) {
+    if (clock_type::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  return true;
+}
+
+void commands(const options &o, bool batched) {
+  // connect a fleet that counts received commands and a client
+  client::options fo = o.mqtt;
+  fo.id = "bench-fleet";
+  client::mqtt fleet(fo);
+  client::options co = o.mqtt;
+  co.id = "bench-client";
+  client::mqtt transport(co);
+  std::string error;
+  if (!fleet.connect(error) || !transport.connect(error)) {
+    fprintf(stderr, "client-bench: failed to connect: %s\n", error.c_str());
+    exit(1);
+  }
+  std::atomic<uint64_t> received{0};
+  fleet.receive([&](std::string_view, std::string_view) { received++; });
+  fleet.subscribe("lights/+/flash");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  client::lights lights(transport);
+
+  // flash all lights per round either as one fleet batch or as single sends
+  std::vector<int> ids;
+  for (int i = 1; i <= o.lights; i++) {
+    ids.push_back(i);
+  }
+  auto start = clock_type::now();
+  for (int r = 0; r < o.rounds; r++) {
+    auto cmd = client::command::flash({r, r, r, r}, 100);
+    if (batched) {
+      lights.send(ids, cmd);
+    } else {
+      for (int id : ids) {
+        lights.send(id, cmd);
+      }
+    }
+  }
+  auto total = static_cast<uint64_t>(o.lights) * static_cast<uint64_t>(o.rounds);
+  bool ok = wait(received, total);
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+
+  // report
+  printf("commands %s lights=%d rounds=%d received=%llu%s msgs/s=%.3g us/round=%.0f msgs/write=%.1f\n",
+         batched ? "batched" : "single", o.lights, o.rounds, static_cast<unsigned long long>(received.load()),
+         ok ? "" : " (timeout)", static_cast<double>(received) / seconds, seconds * 1e6 / o.rounds,
+         static_cast<double>(total) / static_cast<double>(transport.writes()));
+  transport.close();
+  fleet.close();
+}
+
+void telemetry(const options &o) {
+  // connect a fleet that publishes telemetry and a client that subscribes it
+  client::options fo = o.mqtt;
+  fo.id = "bench-fleet";
+  client::mqtt fleet(fo);
+  client::options co = o.mqtt;
+  co.id = "bench-client";
+  client::mqtt transport(co);
+  std::string error;
+  if (!fleet.connect(error) || !transport.connect(error)) {
+    fprintf(stderr, "client-bench: failed to connect: %s\n", error.c_str());
+    exit(1);
+  }
+  client::lights lights(transport);
+  std::atomic<uint64_t> received{0};
+  double sum = 0;
+  lights.on_position([&](int, double position) {
+    sum += position;
+    received++;
+  });
+  lights.on_health([&](int, const client::pairs &p) {
+    double heap = 0;
+    p.get("heap", heap);
+    sum += heap;
+    received++;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // publish a position and a health report per light and round
+  std::vector<client::message> batch;
+  for (int i = 1; i <= o.lights; i++) {
+    std::string prefix = "lights/" + std::to_string(i) + "/";
+    batch.push_back({prefix + "position", std::to_string(100 + i % 50) + ".25"});
+    batch.push_back({prefix + "health", "uptime=3600 heap=112 min-heap=96 stack=3400 queue=1 dropped=0 flash=3"});
+  }
+  auto start = clock_type::now();
+  for (int r = 0; r < o.rounds; r++) {
+    fleet.publish(batch);
+  }
+  auto total = static_cast<uint64_t>(batch.size()) * static_cast<uint64_t>(o.rounds);
+  bool ok = wait(received, total);
+  double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  printf("telemetry received=%llu%s msgs/s=%.3g (checksum %.0f)\n", static_cast<unsigned long long>(received.load()),
+         ok ? "" : " (timeout)", static_cast<double>(received) / seconds, sum);
+  transport.close();
+  fleet.close();
+
+  // measure the parse cost without the network
+  client::loopback t;
+  client::lights local(t);
+  uint64_t parsed = 0;
+  local.on_position([&](int, double) { parsed++; });
+  local.on_health([&](int, const client::pairs &p) {
+    double heap = 0;
+    parsed += p.get("heap", heap) ? 1 : 0;
+  });
+  const int repeat = 200;
+  start = clock_type::now();
+  for (int r = 0; r < repeat; r++) {
+    for (const auto &m : batch) {
+      t.inject(m.topic, m.payload);
+    }
+  }
+  seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+  printf("parse msgs=%llu ns/msg=%.0f\n", static_cast<unsigned long long>(parsed),
+         seconds * 1e9 / static_cast<double>(batch.size() * repeat));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // read flags
+  options o;
+  bool local = true;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string flag = argv[i];
+    if (flag == "--host") {
+      o.mqtt.host = argv[i + 1];
+      local = false;
+    } else if (flag == "--port") {
+      o.mqtt.port = atoi(argv[i + 1]);
+      local = false;
+    } else if (flag == "--lights") {
+      o.lights = atoi(argv[i + 1]);
+    } else if (flag == "--rounds") {
+      o.rounds = atoi(argv[i + 1]);
+    }
+  }
+
+  // start a local broker unless one is given
+  client::broker b;
+  if (local) {
+    std::string error;
+    if (!b.start(0, error)) {
+      fprintf(stderr, "client-bench: %s\n", error.c_str());
+      return 1;
+    }
+    o.mqtt.port = b.port();
+  }
+
+  // run benchmarks
+  commands(o, false);
+  commands(o, true);
+  telemetry(o);
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "reconcile/reconciler.h"
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+void converge(const reconcile::schema &s, int devices, double loss) {
+  // create a fleet where some devices drifted to random values
+  reconcile::fleet f(s, devices, loss, 1);
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> pick(1, devices);
+  for (int i = 0; i < devices / 20; i++) {
+    f.set(pick(rng), "pir-low", std::to_string(100 + pick(rng) % 100));
+  }
+
+  // change the height and range of all devices and enable automation on one half
+  reconcile::reconciler r(f, {s});
+  std::string error;
+  std::vector<int> half;
+  for (int i = 1; i <= devices / 2; i++) {
+    half.push_back(i);
+  }
+  r.want({}, "base-height", "110", error);
+  r.want({}, "approach-range", "45", error);
+  r.want(half, "automate", "1", error);
+
+  // step in simulated 100 ms until all devices converged
+  uint64_t now = 0;
+  auto begin = clock_type::now();
+  for (; now < 3600000; now += 100) {
+    f.step(now);
+    r.step(now);
+    if (now > 0 && r.converged()) {
+      break;
+    }
+  }
+  double seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+
+  // report the simulated convergence time and the messages per converged device
+  auto c = r.count();
+  int converged = c.devices[static_cast<int>(reconcile::status::CONVERGED)];
+  printf("converge devices=%d loss=%.0f%% converged=%d time=%.1fs msgs/device=%.2f reports=%llu resyncs=%llu "
+         "retries=%llu wall=%.1fms\n",
+         devices, loss * 100, converged, static_cast<double>(now) / 1000,
+         static_cast<double>(c.messages) / (converged > 0 ? converged : 1), static_cast<unsigned long long>(c.reports),
+         static_cast<unsigned long long>(c.resyncs), static_cast<unsigned long long>(c.retries), seconds * 1000);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // read number of devices
+  int devices = argc > 1 ? atoi(argv[1]) : 1000;
+
+  // load the light schema
+  reconcile::schema s;
+  std::string error;
+  if (!reconcile::load(RECONCILE_DIR "/tm-lo.schema", s, error)) {
+    fprintf(stderr, "reconcile-bench: %s\n", error.c_str());
+    return 1;
+  }
+
+  // converge without and with message loss
+  for (double loss : {0.0, 0.02, 0.05}) {
+    converge(s, devices, loss);
+  }
+
+  return 0;
+}
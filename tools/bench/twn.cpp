@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "mot.h"
+#include "twn.h"
+}
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // read number of lights
+  int lights = argc > 1 ? atoi(argv[1]) : 1000;
+
+  // prepare random plans in all phases of their profile
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> pos(50, 200);
+  std::uniform_real_distribution<double> vel(-MOT_MAX_VELOCITY, MOT_MAX_VELOCITY);
+  std::uniform_int_distribution<uint32_t> start(0, 20000);
+  std::vector<twn_plan_t> plans;
+  for (int i = 0; i < lights; i++) {
+    plans.push_back({start(rng), pos(rng), vel(rng), pos(rng), MOT_MAX_VELOCITY, MOT_MAX_ACCELERATION});
+  }
+
+  // predict all lights at every millisecond of 20 s like an observer rendering at 1 kHz
+  const uint32_t frames = 20000;
+  double sum = 0;
+  auto begin = clock_type::now();
+  for (uint32_t t = 0; t < frames; t++) {
+    for (auto &p : plans) {
+      sum += twn_predict(&p, 20000 + t);
+    }
+  }
+  double seconds = std::chrono::duration<double>(clock_type::now() - begin).count();
+  double calls = static_cast<double>(frames) * lights;
+
+  // report the cost per prediction and the core share of following all lights at 60 Hz
+  printf("predict lights=%d calls=%.3g ns/call=%.1f core@60Hz=%.4f%% (checksum %.0f)\n", lights, calls,
+         seconds * 1e9 / calls, seconds / calls * lights * 60 * 100, sum / calls);
+
+  return 0;
+}
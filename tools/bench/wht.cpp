@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "wht.h"
+}
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+led_color_t reference(led_color_t c, int r, int g, int b) {
+  // extract white in floating point for comparison
+  double w = 1023 - c.w;
+  if (r > 0) {
+    w = std::fmin(w, c.r / (r / 1023.0));
+  }
+  if (g > 0) {
+    w = std::fmin(w, c.g / (g / 1023.0));
+  }
+  if (b > 0) {
+    w = std::fmin(w, c.b / (b / 1023.0));
+  }
+  return led_color_t{static_cast<int>(std::lround(c.r - w * r / 1023.0)),
+                     static_cast<int>(std::lround(c.g - w * g / 1023.0)),
+                     static_cast<int>(std::lround(c.b - w * b / 1023.0)), static_cast<int>(std::lround(c.w + w))};
+}
+
+template <typename F>
+double measure(const std::vector<led_color_t> &colors, int rounds, F f, long &sum) {
+  // convert all colors with a warm white calibration
+  auto begin = clock_type::now();
+  for (int i = 0; i < rounds; i++) {
+    for (const auto &c : colors) {
+      led_color_t o = f(c, 1023, 850, 600);
+      sum += o.r + o.g + o.b + o.w;
+    }
+  }
+
+  return std::chrono::duration<double>(clock_type::now() - begin).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // read number of rounds
+  int rounds = argc > 1 ? atoi(argv[1]) : 100;
+
+  // prepare random colors
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> duty(0, 1023);
+  std::vector<led_color_t> colors;
+  for (int i = 0; i < 10000; i++) {
+    int r = duty(rng);
+    int g = duty(rng);
+    int b = duty(rng);
+    colors.push_back(led_color_t{r, g, b, 0});
+  }
+
+  // measure the fixed point extraction of the firmware and a floating point reference
+  long sum = 0;
+  double fixed = measure(colors, rounds, wht_extract, sum);
+  double floating = measure(colors, rounds, reference, sum);
+  double calls = static_cast<double>(colors.size()) * rounds;
+
+  // report the cost per fade update
+  printf("extract calls=%.3g fixed ns/update=%.2f float ns/update=%.2f (checksum %ld)\n", calls, fixed * 1e9 / calls,
+         floating * 1e9 / calls, sum);
+
+  return 0;
+}
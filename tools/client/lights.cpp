@@ -0,0 +1,280 @@
+#include "lights.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+namespace client {
+
+static command make(std::string topic, std::string payload) {
+  command c;
+  c.topic = std::move(topic);
+  c.payload = std::move(payload);
+  return c;
+}
+
+static std::string format(double value) {
+  // format without trailing zeros
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%g", value);
+  return buf;
+}
+
+static std::string format(color c, int time) {
+  return std::to_string(c.red) + " " + std::to_string(c.green) + " " + std::to_string(c.blue) + " " +
+         std::to_string(c.white) + " " + std::to_string(time);
+}
+
+command command::move(double position) { return make("move", format(position)); }
+
+command command::up() { return make("move", "up"); }
+
+command command::down() { return make("move", "down"); }
+
+command command::stop() { return make("stop", ""); }
+
+command command::fade(color c, int time) { return make("fade", format(c, time)); }
+
+command command::flash(color c, int time) { return make("flash", format(c, time)); }
+
+command command::calibrate() { return make("calibrate", ""); }
+
+command command::automate(bool on) { return make("automate", on ? "1" : "0"); }
+
+command command::set(const std::string &name, const std::string &value) { return make("naos/set/" + name, value); }
+
+command command::set(const std::string &name, double value) { return set(name, format(value)); }
+
+command command::set(const std::string &name, long value) { return set(name, std::to_string(value)); }
+
+command command::set(const std::string &name, bool value) { return set(name, std::string(value ? "1" : "0")); }
+
+lights::lights(transport &t, std::string prefix)
+    : transport_(t), prefix_(std::move(prefix)), subscriptions_(std::make_shared<std::vector<subscription>>()) {
+  // subscribe state topics
+  transport_.receive([this](std::string_view topic, std::string_view payload) { dispatch(topic, payload); });
+  transport_.subscribe(prefix_ + "/+/state");
+  transport_.subscribe(prefix_ + "/+/telemetry");
+
+  // run reaper
+  reaper_ = std::thread([this] { expire(); });
+}
+
+lights::~lights() {
+  // stop reaper
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  reaper_.join();
+
+  // detach handler
+  transport_.receive(nullptr);
+}
+
+std::future<void> lights::send(int id, const command &c) { return send(std::vector<int>{id}, c); }
+
+std::future<void> lights::send(const std::vector<int> &ids, const command &c) {
+  // prepare batch
+  std::vector<message> batch;
+  batch.reserve(ids.size());
+  for (int id : ids) {
+    batch.push_back({prefix_ + "/" + std::to_string(id) + "/" + c.topic, c.payload});
+  }
+
+  return transport_.publish(std::move(batch));
+}
+
+std::future<bool> lights::move(const std::vector<int> &ids, double position, std::chrono::milliseconds timeout) {
+  return await(ids, command::move(position), "MOVE", timeout);
+}
+
+std::future<bool> lights::calibrate(const std::vector<int> &ids, std::chrono::milliseconds timeout) {
+  return await(ids, command::calibrate(), "CALIBRATE", timeout);
+}
+
+std::future<bool> lights::await(const std::vector<int> &ids, const command &c, const std::string &state,
+                                std::chrono::milliseconds timeout) {
+  // register waiter before sending to not miss fast reports
+  auto w = std::make_unique<waiter>();
+  w->state = state;
+  for (int id : ids) {
+    w->lights[id] = false;
+  }
+  w->deadline = std::chrono::steady_clock::now() + timeout;
+  std::future<bool> done = w->done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiters_.push_back(std::move(w));
+  }
+  changed_.notify_all();
+
+  // send command
+  send(ids, c);
+
+  return done;
+}
+
+void lights::subscribe(const std::string &name, callback cb) {
+  // subscribe topic
+  transport_.subscribe(prefix_ + "/+/" + name);
+
+  // replace subscriptions
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto next = std::make_shared<std::vector<subscription>>(*std::atomic_load(&subscriptions_));
+  next->push_back({name, std::move(cb)});
+  std::atomic_store(&subscriptions_, std::shared_ptr<const std::vector<subscription>>(std::move(next)));
+}
+
+void lights::on_position(std::function<void(int, double)> cb) {
+  subscribe("position", [cb = std::move(cb)](const sample &s) {
+    double position;
+    if (number(s.payload, position)) {
+      cb(s.light, position);
+    }
+  });
+}
+
+void lights::on_state(std::function<void(int, std::string_view)> cb) {
+  subscribe("state", [cb = std::move(cb)](const sample &s) { cb(s.light, s.payload); });
+}
+
+void lights::on_plan(std::function<void(int, const plan &)> cb) {
+  subscribe("plan", [cb = std::move(cb)](const sample &s) {
+    plan p;
+    if (parse(s.payload, p)) {
+      cb(s.light, p);
+    }
+  });
+}
+
+void lights::on_health(std::function<void(int, const pairs &)> cb) {
+  subscribe("health", [cb = std::move(cb)](const sample &s) { cb(s.light, pairs(s.payload)); });
+}
+
+std::string lights::state(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = states_.find(id);
+  return it == states_.end() ? std::string() : it->second;
+}
+
+void lights::dispatch(std::string_view topic, std::string_view payload) {
+  // split topic
+  sample s;
+  if (!parse(prefix_, topic, payload, s)) {
+    return;
+  }
+
+  // track states, also from coalesced telemetry
+  if (s.name == "state") {
+    report(s.light, s.payload);
+  } else if (s.name == "telemetry") {
+    std::string_view state;
+    if (pairs(s.payload).get("state", state)) {
+      report(s.light, state);
+    }
+  }
+
+  // call subscriptions
+  auto subs = std::atomic_load(&subscriptions_);
+  for (const auto &sub : *subs) {
+    if (sub.name == s.name) {
+      sub.cb(s);
+    }
+  }
+}
+
+void lights::report(int light, std::string_view state) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // store state
+  states_[light] = std::string(state);
+
+  // advance waiters, a light is done once it left the awaited state after having entered it
+  for (auto it = waiters_.begin(); it != waiters_.end();) {
+    waiter &w = **it;
+    auto l = w.lights.find(light);
+    if (l != w.lights.end()) {
+      if (state == w.state) {
+        l->second = true;
+      } else if (l->second) {
+        w.lights.erase(l);
+      }
+    }
+    if (w.lights.empty()) {
+      w.done.set_value(true);
+      it = waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void lights::expire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    // fail expired waiters
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    for (auto it = waiters_.begin(); it != waiters_.end();) {
+      if ((*it)->deadline <= now) {
+        (*it)->done.set_value(false);
+        it = waiters_.erase(it);
+      } else {
+        next = std::min(next, (*it)->deadline);
+        ++it;
+      }
+    }
+
+    // wait for next deadline or change
+    if (next == std::chrono::steady_clock::time_point::max()) {
+      changed_.wait(lock);
+    } else {
+      changed_.wait_until(lock, next);
+    }
+  }
+
+  // fail remaining waiters
+  for (auto &w : waiters_) {
+    w->done.set_value(false);
+  }
+  waiters_.clear();
+}
+
+bool parse(const std::string &text, int count, std::vector<int> &ids) {
+  // handle all
+  ids.clear();
+  if (text == "all") {
+    for (int i = 1; i <= count; i++) {
+      ids.push_back(i);
+    }
+    return count > 0;
+  }
+
+  // parse items and ranges
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    int first = 0;
+    int last = 0;
+    char dash = 0;
+    char rest = 0;
+    int n = sscanf(item.c_str(), "%d%c%d%c", &first, &dash, &last, &rest);
+    if (n == 1) {
+      last = first;
+    } else if (n != 3 || dash != '-') {
+      return false;
+    }
+    if (first < 1 || last < first) {
+      return false;
+    }
+    for (int i = first; i <= last; i++) {
+      ids.push_back(i);
+    }
+  }
+
+  return !ids.empty();
+}
+
+}  // namespace client
@@ -0,0 +1,196 @@
+#ifndef CLIENT_LIGHTS_H
+#define CLIENT_LIGHTS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry.h"
+#include "transport.h"
+
+namespace client {
+
+/**
+ * An LED color with 10 bit channels.
+ */
+struct color {
+  int red = 0;
+  int green = 0;
+  int blue = 0;
+  int white = 0;
+};
+
+/**
+ * A typed light command with its topic below the light and its payload.
+ */
+struct command {
+  std::string topic;
+  std::string payload;
+
+  /**
+   * Move to a position in cm, up or down until stopped.
+   */
+  static command move(double position);
+  static command up();
+  static command down();
+
+  /**
+   * Stop moving and disable automate until the next "automate" or parameter change.
+   */
+  static command stop();
+
+  /**
+   * Fade or flash a color over a time in ms.
+   */
+  static command fade(color c, int time);
+  static command flash(color c, int time);
+
+  /**
+   * Calibrate the position.
+   */
+  static command calibrate();
+
+  /**
+   * Enable or disable automate without persisting it.
+   */
+  static command automate(bool on);
+
+  /**
+   * Set a parameter.
+   */
+  static command set(const std::string &name, const std::string &value);
+  static command set(const std::string &name, double value);
+  static command set(const std::string &name, long value);
+  static command set(const std::string &name, bool value);
+};
+
+/**
+ * Called with every matching telemetry sample.
+ */
+using callback = std::function<void(const sample &s)>;
+
+/**
+ * The client for a fleet of lights below a topic prefix ("<prefix>/<light>/..."). Commands return immediately with
+ * futures, fleet commands are formatted once and published as a single batch and telemetry is passed to callbacks
+ * without copying. Callbacks run on the thread of the transport and must not block.
+ */
+class lights {
+ public:
+  /**
+   * Create the client and subscribe the state topics of all lights.
+   *
+   * @param t The transport.
+   * @param prefix The topic prefix.
+   */
+  explicit lights(transport &t, std::string prefix = "lights");
+  ~lights();
+
+  lights(const lights &) = delete;
+  lights &operator=(const lights &) = delete;
+
+  /**
+   * Send a command to one or many lights.
+   *
+   * @param ids The lights.
+   * @param c The command.
+   * @return A future that is ready once the batch has been handed to the network.
+   */
+  std::future<void> send(int id, const command &c);
+  std::future<void> send(const std::vector<int> &ids, const command &c);
+
+  /**
+   * Move lights to a position and wait until all of them reported to have left MOVE.
+   *
+   * @param ids The lights.
+   * @param position The position in cm.
+   * @param timeout The time to wait.
+   * @return A future that is true if all lights finished or false on timeout.
+   */
+  std::future<bool> move(const std::vector<int> &ids, double position, std::chrono::milliseconds timeout);
+
+  /**
+   * Calibrate lights and wait until all of them reported to have left CALIBRATE.
+   *
+   * @param ids The lights.
+   * @param timeout The time to wait.
+   * @return A future that is true if all lights finished or false on timeout.
+   */
+  std::future<bool> calibrate(const std::vector<int> &ids, std::chrono::milliseconds timeout);
+
+  /**
+   * Subscribe a telemetry topic of all lights (e.g. "position", "health").
+   *
+   * @param name The topic name below the lights.
+   * @param cb The callback.
+   */
+  void subscribe(const std::string &name, callback cb);
+
+  /**
+   * Subscribe typed telemetry of all lights.
+   */
+  void on_position(std::function<void(int light, double position)> cb);
+  void on_state(std::function<void(int light, std::string_view state)> cb);
+  void on_plan(std::function<void(int light, const plan &p)> cb);
+  void on_health(std::function<void(int light, const pairs &p)> cb);
+
+  /**
+   * Get the last reported state of a light or an empty string.
+   *
+   * @param id The light.
+   */
+  std::string state(int id);
+
+ private:
+  struct subscription {
+    std::string name;
+    callback cb;
+  };
+
+  struct waiter {
+    std::string state;
+    std::map<int, bool> lights;
+    std::chrono::steady_clock::time_point deadline;
+    std::promise<bool> done;
+  };
+
+  std::future<bool> await(const std::vector<int> &ids, const command &c, const std::string &state,
+                          std::chrono::milliseconds timeout);
+  void dispatch(std::string_view topic, std::string_view payload);
+  void report(int light, std::string_view state);
+  void expire();
+
+  transport &transport_;
+  std::string prefix_;
+
+  // replaced on subscribe so that callbacks run without holding the mutex
+  std::shared_ptr<const std::vector<subscription>> subscriptions_;
+
+  // guarded by the mutex
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::map<int, std::string> states_;
+  std::vector<std::unique_ptr<waiter>> waiters_;
+  bool stopping_ = false;
+  std::thread reaper_;
+};
+
+/**
+ * Parse a list of lights like "1,3,5-8" or "all" (1 to count).
+ *
+ * @param text The list.
+ * @param count The number of lights for "all".
+ * @param ids The lights.
+ * @return Whether the list is valid.
+ */
+bool parse(const std::string &text, int count, std::vector<int> &ids);
+
+}  // namespace client
+
+#endif  // CLIENT_LIGHTS_H
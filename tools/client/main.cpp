@@ -0,0 +1,202 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/lights.h"
+#include "client/mqtt.h"
+
+namespace {
+
+struct options {
+  client::options mqtt;
+  std::string prefix = "lights";
+  int count = 0;
+  int timeout = 60000;
+  bool wait = false;
+  std::vector<std::string> args;
+};
+
+std::atomic<bool> interrupted{false};
+
+void usage() {
+  fprintf(stderr,
+          "usage: lights [--host H] [--port P] [--username U] [--password P] [--prefix P] [--count N] [--timeout MS]\n"
+          "              [--wait] COMMAND IDS [ARGS]\n"
+          "\n"
+          "commands:\n"
+          "  move IDS POSITION|up|down       move lights (--wait until they finished)\n"
+          "  stop IDS                        stop lights\n"
+          "  fade IDS R G B W MS             fade to a color\n"
+          "  flash IDS R G B W MS            flash a color\n"
+          "  calibrate IDS                   calibrate lights (--wait until they finished)\n"
+          "  automate IDS 0|1                disable or enable automate\n"
+          "  set IDS NAME VALUE              set a parameter\n"
+          "  watch IDS [TOPIC...]            print telemetry (default: state position)\n"
+          "\n"
+          "IDS is \"all\" (1 to --count) or a list like \"1,3,5-8\".\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags and arguments
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag.rfind("--", 0) != 0) {
+      o.args.push_back(flag);
+      continue;
+    }
+    if (flag == "--wait") {
+      o.wait = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--host") {
+      o.mqtt.host = value;
+    } else if (flag == "--port") {
+      o.mqtt.port = atoi(value);
+    } else if (flag == "--username") {
+      o.mqtt.username = value;
+    } else if (flag == "--password") {
+      o.mqtt.password = value;
+    } else if (flag == "--prefix") {
+      o.prefix = value;
+    } else if (flag == "--count") {
+      o.count = atoi(value);
+    } else if (flag == "--timeout") {
+      o.timeout = atoi(value);
+    } else {
+      return false;
+    }
+  }
+
+  return o.args.size() >= 2;
+}
+
+bool color(const std::vector<std::string> &args, client::color &c, int &time) {
+  // read four channels and time
+  if (args.size() != 7) {
+    return false;
+  }
+  c = {atoi(args[2].c_str()), atoi(args[3].c_str()), atoi(args[4].c_str()), atoi(args[5].c_str())};
+  time = atoi(args[6].c_str());
+
+  return true;
+}
+
+bool command(const std::vector<std::string> &args, client::command &c) {
+  // build typed command
+  const std::string &name = args[0];
+  client::color col;
+  int time = 0;
+  if (name == "move" && args.size() == 3) {
+    c = args[2] == "up" ? client::command::up()
+        : args[2] == "down" ? client::command::down()
+                            : client::command::move(atof(args[2].c_str()));
+  } else if (name == "stop" && args.size() == 2) {
+    c = client::command::stop();
+  } else if (name == "fade" && color(args, col, time)) {
+    c = client::command::fade(col, time);
+  } else if (name == "flash" && color(args, col, time)) {
+    c = client::command::flash(col, time);
+  } else if (name == "calibrate" && args.size() == 2) {
+    c = client::command::calibrate();
+  } else if (name == "automate" && args.size() == 3) {
+    c = client::command::automate(args[2] == "1");
+  } else if (name == "set" && args.size() == 4) {
+    c = client::command::set(args[2], args[3]);
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+  std::vector<int> ids;
+  if (!client::parse(o.args[1], o.count, ids)) {
+    fprintf(stderr, "lights: invalid lights %s (\"all\" requires --count)\n", o.args[1].c_str());
+    return 1;
+  }
+  client::command cmd;
+  bool watch = o.args[0] == "watch";
+  if (!watch && !command(o.args, cmd)) {
+    usage();
+    return 1;
+  }
+
+  // connect
+  client::mqtt transport(o.mqtt);
+  std::string error;
+  if (!transport.connect(error)) {
+    fprintf(stderr, "lights: failed to connect to %s:%d: %s\n", o.mqtt.host.c_str(), o.mqtt.port, error.c_str());
+    return 1;
+  }
+  client::lights fleet(transport, o.prefix);
+
+  // print telemetry until interrupted
+  if (watch) {
+    std::vector<std::string> topics(o.args.begin() + 2, o.args.end());
+    if (topics.empty()) {
+      topics = {"state", "position"};
+    }
+    std::vector<bool> selected;
+    for (int id : ids) {
+      if (static_cast<size_t>(id) >= selected.size()) {
+        selected.resize(static_cast<size_t>(id) + 1);
+      }
+      selected[static_cast<size_t>(id)] = true;
+    }
+    for (const auto &topic : topics) {
+      fleet.subscribe(topic, [&selected](const client::sample &s) {
+        if (s.light >= 0 && static_cast<size_t>(s.light) < selected.size() && selected[static_cast<size_t>(s.light)]) {
+          printf("%d %.*s %.*s\n", s.light, static_cast<int>(s.name.size()), s.name.data(),
+                 static_cast<int>(s.payload.size()), s.payload.data());
+          fflush(stdout);
+        }
+      });
+    }
+    signal(SIGINT, [](int) { interrupted = true; });
+    while (!interrupted && transport.connected()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    transport.close();
+    return 0;
+  }
+
+  // send and optionally wait for move and calibrate
+  bool ok = true;
+  auto timeout = std::chrono::milliseconds(o.timeout);
+  if (o.wait && cmd.topic == "move" && cmd.payload != "up" && cmd.payload != "down") {
+    ok = fleet.move(ids, atof(o.args[2].c_str()), timeout).get();
+  } else if (o.wait && cmd.topic == "calibrate") {
+    ok = fleet.calibrate(ids, timeout).get();
+  } else {
+    try {
+      fleet.send(ids, cmd).get();
+    } catch (const std::exception &e) {
+      ok = false;
+    }
+  }
+  transport.close();
+  if (!ok) {
+    fprintf(stderr, "lights: %s did not complete\n", o.args[0].c_str());
+    return 1;
+  }
+
+  return 0;
+}
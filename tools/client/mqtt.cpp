@@ -0,0 +1,619 @@
+#include "mqtt.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace client {
+
+namespace {
+
+// the time to wait for the broker to accept a connection in ms
+const int connect_timeout = 5000;
+
+// the receive chunk size
+const size_t chunk = 65536;
+
+void put16(std::string &out, size_t value) {
+  out += static_cast<char>(value >> 8 & 0xff);
+  out += static_cast<char>(value & 0xff);
+}
+
+void put_string(std::string &out, std::string_view str) {
+  put16(out, str.size());
+  out.append(str.data(), str.size());
+}
+
+void put_header(std::string &out, uint8_t first, size_t remaining) {
+  // write type and flags and the variable length
+  out += static_cast<char>(first);
+  do {
+    uint8_t byte = remaining % 128;
+    remaining /= 128;
+    if (remaining > 0) {
+      byte |= 128;
+    }
+    out += static_cast<char>(byte);
+  } while (remaining > 0);
+}
+
+size_t get16(std::string_view buf, size_t at) {
+  return static_cast<size_t>(static_cast<uint8_t>(buf[at])) << 8 | static_cast<uint8_t>(buf[at + 1]);
+}
+
+bool nonblocking(int fd) { return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) == 0; }
+
+void nodelay(int fd) {
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+void drain(int fd) {
+  char buf[64];
+  while (::read(fd, buf, sizeof(buf)) > 0) {
+  }
+}
+
+void notify(int fd) {
+  char c = 0;
+  if (::write(fd, &c, 1) < 0) {
+    // the pipe is full and the thread will wake anyway
+  }
+}
+
+bool split(std::string_view packet, size_t header, std::string_view &topic, std::string_view &payload) {
+  // read topic and skip the packet id of QoS 1 and 2
+  size_t at = header;
+  if (packet.size() < at + 2) {
+    return false;
+  }
+  size_t len = get16(packet, at);
+  at += 2;
+  if (packet.size() < at + len) {
+    return false;
+  }
+  topic = packet.substr(at, len);
+  at += len;
+  if ((static_cast<uint8_t>(packet[0]) >> 1 & 3) > 0) {
+    at += 2;
+  }
+  if (packet.size() < at) {
+    return false;
+  }
+  payload = packet.substr(at);
+
+  return true;
+}
+
+}  // namespace
+
+bool frame(std::string_view buf, uint8_t &type, size_t &header, size_t &length) {
+  // read type
+  if (buf.size() < 2) {
+    return false;
+  }
+  type = static_cast<uint8_t>(buf[0]) >> 4;
+
+  // read variable length of up to four bytes
+  size_t remaining = 0;
+  size_t multiplier = 1;
+  for (size_t i = 1; i < 5; i++) {
+    if (i >= buf.size()) {
+      return false;
+    }
+    auto byte = static_cast<uint8_t>(buf[i]);
+    remaining += (byte & 127) * multiplier;
+    multiplier *= 128;
+    if ((byte & 128) == 0) {
+      header = i + 1;
+      length = header + remaining;
+      return buf.size() >= length;
+    }
+  }
+
+  return false;
+}
+
+void encode(std::string &out, std::string_view topic, std::string_view payload) {
+  put_header(out, PUBLISH << 4, 2 + topic.size() + payload.size());
+  put_string(out, topic);
+  out.append(payload.data(), payload.size());
+}
+
+mqtt::mqtt(options o) : options_(std::move(o)) {}
+
+mqtt::~mqtt() { close(); }
+
+bool mqtt::connect(std::string &error) {
+  // resolve broker
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  int ret = getaddrinfo(options_.host.c_str(), std::to_string(options_.port).c_str(), &hints, &res);
+  if (ret != 0) {
+    error = gai_strerror(ret);
+    return false;
+  }
+
+  // connect to first reachable address
+  for (addrinfo *a = res; a != nullptr && socket_ < 0; a = a->ai_next) {
+    socket_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (socket_ >= 0 && ::connect(socket_, a->ai_addr, a->ai_addrlen) != 0) {
+      ::close(socket_);
+      socket_ = -1;
+    }
+  }
+  freeaddrinfo(res);
+  if (socket_ < 0) {
+    error = std::string("connect: ") + strerror(errno);
+    return false;
+  }
+  nodelay(socket_);
+
+  // send connect with clean session
+  uint8_t flags = 0x02;
+  std::string body;
+  put_string(body, "MQTT");
+  body += static_cast<char>(4);
+  if (!options_.username.empty()) {
+    flags |= 0x80;
+  }
+  if (!options_.password.empty()) {
+    flags |= 0x40;
+  }
+  body += static_cast<char>(flags);
+  put16(body, static_cast<size_t>(options_.keep_alive));
+  put_string(body, options_.id);
+  if (!options_.username.empty()) {
+    put_string(body, options_.username);
+  }
+  if (!options_.password.empty()) {
+    put_string(body, options_.password);
+  }
+  std::string packet;
+  put_header(packet, CONNECT << 4, body.size());
+  packet += body;
+  if (send(socket_, packet.data(), packet.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(packet.size())) {
+    error = "failed to send connect";
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  // wait for connack
+  std::string ack;
+  uint8_t type = 0;
+  size_t header = 0;
+  size_t length = 0;
+  while (!frame(ack, type, header, length)) {
+    pollfd p = {socket_, POLLIN, 0};
+    char buf[16];
+    ssize_t n = poll(&p, 1, connect_timeout) > 0 ? recv(socket_, buf, sizeof(buf), 0) : -1;
+    if (n <= 0) {
+      error = "no connack";
+      ::close(socket_);
+      socket_ = -1;
+      return false;
+    }
+    ack.append(buf, static_cast<size_t>(n));
+  }
+  if (type != CONNACK || length < 4 || ack[3] != 0) {
+    error = "connection refused";
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+
+  // keep bytes that followed the connack
+  in_ = ack.substr(length);
+
+  // start I/O thread
+  if (pipe(wake_) != 0 || !nonblocking(socket_) || !nonblocking(wake_[0]) || !nonblocking(wake_[1])) {
+    error = "failed to prepare socket";
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+  connected_ = true;
+  stopping_ = false;
+  thread_ = std::thread([this] { run(); });
+
+  return true;
+}
+
+void mqtt::close() {
+  // stop I/O thread after pending writes
+  if (thread_.joinable()) {
+    std::string bye;
+    put_header(bye, DISCONNECT << 4, 0);
+    queue(bye);
+    stopping_ = true;
+    notify(wake_[1]);
+    thread_.join();
+  }
+
+  // close descriptors
+  for (int *fd : {&socket_, &wake_[0], &wake_[1]}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+  fail();
+}
+
+std::future<void> mqtt::publish(std::vector<message> batch) {
+  // encode batch outside the lock
+  std::string bytes;
+  for (const auto &m : batch) {
+    encode(bytes, m.topic, m.payload);
+  }
+
+  // fail immediately if not connected
+  std::promise<void> done;
+  std::future<void> future = done.get_future();
+  if (!connected_) {
+    done.set_exception(std::make_exception_ptr(std::runtime_error("not connected")));
+    return future;
+  }
+
+  // queue bytes and remember the end of the batch
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake = out_.empty();
+    out_ += bytes;
+    queued_ += bytes.size();
+    pending_.emplace_back(queued_, std::move(done));
+  }
+  if (wake) {
+    notify(wake_[1]);
+  }
+
+  return future;
+}
+
+void mqtt::subscribe(const std::string &filter) {
+  // encode subscribe with QoS 0
+  std::string packet;
+  uint16_t id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = ++packet_id_ == 0 ? ++packet_id_ : packet_id_;
+  }
+  put_header(packet, SUBSCRIBE << 4 | 2, 2 + 2 + filter.size() + 1);
+  put16(packet, id);
+  put_string(packet, filter);
+  packet += static_cast<char>(0);
+  queue(packet);
+}
+
+void mqtt::receive(handler h) { std::atomic_store(&handler_, std::make_shared<const handler>(std::move(h))); }
+
+void mqtt::queue(const std::string &bytes) {
+  // append bytes and wake the thread if it may be idle
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake = out_.empty();
+    out_ += bytes;
+    queued_ += bytes.size();
+  }
+  if (wake && wake_[1] >= 0) {
+    notify(wake_[1]);
+  }
+}
+
+void mqtt::run() {
+  auto last = std::chrono::steady_clock::now();
+  for (;;) {
+    // take queued bytes once the previous write completed
+    if (offset_ == writing_.size()) {
+      writing_.clear();
+      offset_ = 0;
+      std::lock_guard<std::mutex> lock(mutex_);
+      writing_.swap(out_);
+    }
+
+    // stop once everything has been written
+    if (stopping_ && writing_.empty()) {
+      break;
+    }
+
+    // write right away
+    if (!writing_.empty()) {
+      if (!flush()) {
+        break;
+      }
+      last = std::chrono::steady_clock::now();
+    }
+
+    // wait for the socket or new bytes
+    pollfd fds[2] = {{socket_, static_cast<short>(POLLIN | (writing_.empty() ? 0 : POLLOUT)), 0},
+                     {wake_[0], POLLIN, 0}};
+    int n = poll(fds, 2, options_.keep_alive * 500);
+    if (n < 0 && errno != EINTR) {
+      break;
+    }
+
+    // ping when idle for half the keep alive
+    if (std::chrono::steady_clock::now() - last >= std::chrono::milliseconds(options_.keep_alive * 500)) {
+      std::string ping;
+      put_header(ping, PINGREQ << 4, 0);
+      queue(ping);
+      last = std::chrono::steady_clock::now();
+    }
+
+    // clear wake up and read
+    if (fds[1].revents != 0) {
+      drain(wake_[0]);
+    }
+    if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !read()) {
+      break;
+    }
+  }
+
+  // fail pending futures
+  fail();
+}
+
+bool mqtt::flush() {
+  // write as much as possible
+  ssize_t n = send(socket_, writing_.data() + offset_, writing_.size() - offset_, MSG_NOSIGNAL);
+  if (n < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  }
+  writes_++;
+  offset_ += static_cast<size_t>(n);
+  written_ += static_cast<uint64_t>(n);
+
+  // complete written batches
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!pending_.empty() && pending_.front().first <= written_) {
+    pending_.front().second.set_value();
+    pending_.pop_front();
+  }
+
+  return true;
+}
+
+bool mqtt::read() {
+  // receive available bytes
+  size_t old = in_.size();
+  in_.resize(old + chunk);
+  ssize_t n = recv(socket_, &in_[old], chunk, 0);
+  in_.resize(old + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+  if (n == 0) {
+    return false;
+  } else if (n < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+  }
+
+  // dispatch complete publishes as views into the buffer
+  std::shared_ptr<const handler> h = std::atomic_load(&handler_);
+  std::string_view buf = in_;
+  size_t at = 0;
+  uint8_t type = 0;
+  size_t header = 0;
+  size_t length = 0;
+  while (frame(buf.substr(at), type, header, length)) {
+    std::string_view topic;
+    std::string_view payload;
+    if (type == PUBLISH && h && *h && split(buf.substr(at, length), header, topic, payload)) {
+      (*h)(topic, payload);
+    }
+    at += length;
+  }
+  in_.erase(0, at);
+
+  return true;
+}
+
+void mqtt::fail() {
+  // fail pending futures
+  connected_ = false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &p : pending_) {
+    p.second.set_exception(std::make_exception_ptr(std::runtime_error("disconnected")));
+  }
+  pending_.clear();
+}
+
+broker::~broker() { stop(); }
+
+bool broker::start(int port, std::string &error) {
+  // listen on loopback
+  listener_ = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (listener_ < 0 || bind(listener_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      listen(listener_, 64) != 0 || getsockname(listener_, reinterpret_cast<sockaddr *>(&addr), &len) != 0 ||
+      !nonblocking(listener_) || pipe(wake_) != 0 || !nonblocking(wake_[0])) {
+    error = std::string("listen: ") + strerror(errno);
+    stop();
+    return false;
+  }
+  port_ = ntohs(addr.sin_port);
+
+  // start thread
+  stopping_ = false;
+  thread_ = std::thread([this] { run(); });
+
+  return true;
+}
+
+void broker::stop() {
+  // stop thread
+  if (thread_.joinable()) {
+    stopping_ = true;
+    notify(wake_[1]);
+    thread_.join();
+  }
+
+  // close descriptors
+  for (auto &c : connections_) {
+    ::close(c.fd);
+  }
+  connections_.clear();
+  for (int *fd : {&listener_, &wake_[0], &wake_[1]}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+void broker::run() {
+  std::vector<pollfd> fds;
+  while (!stopping_) {
+    // wait for the listener, the wake up and the connections
+    fds.clear();
+    fds.push_back({listener_, POLLIN, 0});
+    fds.push_back({wake_[0], POLLIN, 0});
+    for (const auto &c : connections_) {
+      fds.push_back({c.fd, static_cast<short>(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+      break;
+    }
+    if (fds[1].revents != 0) {
+      drain(wake_[0]);
+    }
+
+    // read and handle packets
+    for (size_t i = 0; i < connections_.size(); i++) {
+      connection &c = connections_[i];
+      if ((fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+        continue;
+      }
+      char buf[chunk];
+      ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        ::close(c.fd);
+        c.fd = -1;
+        continue;
+      }
+      if (n > 0) {
+        c.in.append(buf, static_cast<size_t>(n));
+      }
+      if (!handle(c)) {
+        ::close(c.fd);
+        c.fd = -1;
+      }
+    }
+
+    // write pending bytes
+    for (auto &c : connections_) {
+      if (c.fd < 0 || c.out.empty()) {
+        continue;
+      }
+      ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+      if (n > 0) {
+        c.out.erase(0, static_cast<size_t>(n));
+      } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        ::close(c.fd);
+        c.fd = -1;
+      }
+    }
+
+    // remove closed connections
+    for (size_t i = connections_.size(); i-- > 0;) {
+      if (connections_[i].fd < 0) {
+        connections_.erase(connections_.begin() + static_cast<std::ptrdiff_t>(i));
+      }
+    }
+
+    // accept new connections
+    if (fds[0].revents != 0) {
+      for (int fd = accept(listener_, nullptr, nullptr); fd >= 0; fd = accept(listener_, nullptr, nullptr)) {
+        nonblocking(fd);
+        nodelay(fd);
+        connections_.push_back({fd, "", "", {}});
+      }
+    }
+  }
+}
+
+bool broker::handle(connection &c) {
+  // handle complete packets
+  std::string_view buf = c.in;
+  size_t at = 0;
+  uint8_t type = 0;
+  size_t header = 0;
+  size_t length = 0;
+  bool open = true;
+  while (open && frame(buf.substr(at), type, header, length)) {
+    std::string_view packet = buf.substr(at, length);
+    at += length;
+    switch (type) {
+      case CONNECT:
+        // accept every client
+        put_header(c.out, CONNACK << 4, 2);
+        put16(c.out, 0);
+        break;
+      case SUBSCRIBE: {
+        // add filters and grant QoS 0
+        size_t id = get16(packet, header);
+        size_t count = 0;
+        for (size_t i = header + 2; i + 2 <= packet.size();) {
+          size_t len = get16(packet, i);
+          c.filters.emplace_back(packet.substr(i + 2, len));
+          i += 2 + len + 1;
+          count++;
+        }
+        put_header(c.out, SUBACK << 4, 2 + count);
+        put16(c.out, id);
+        c.out.append(count, 0);
+        break;
+      }
+      case PUBLISH: {
+        // forward packet to all matching subscriptions
+        std::string_view topic;
+        std::string_view payload;
+        if (!split(packet, header, topic, payload)) {
+          break;
+        }
+        for (auto &other : connections_) {
+          for (const auto &filter : other.filters) {
+            if (other.fd >= 0 && match(filter, topic)) {
+              encode(other.out, topic, payload);
+              forwarded_++;
+              break;
+            }
+          }
+        }
+        break;
+      }
+      case PINGREQ:
+        put_header(c.out, PINGRESP << 4, 0);
+        break;
+      case DISCONNECT:
+        open = false;
+        break;
+      default:
+        break;
+    }
+  }
+  c.in.erase(0, at);
+
+  return open;
+}
+
+}  // namespace client
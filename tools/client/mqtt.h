@@ -0,0 +1,191 @@
+#ifndef CLIENT_MQTT_H
+#define CLIENT_MQTT_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "transport.h"
+
+namespace client {
+
+/**
+ * The MQTT 3.1.1 packet types used by the transport and the broker.
+ */
+enum packet : uint8_t {
+  CONNECT = 1,
+  CONNACK = 2,
+  PUBLISH = 3,
+  SUBSCRIBE = 8,
+  SUBACK = 9,
+  PINGREQ = 12,
+  PINGRESP = 13,
+  DISCONNECT = 14,
+};
+
+/**
+ * Find the first complete packet in a buffer.
+ *
+ * @param buf The buffer.
+ * @param type The packet type.
+ * @param header The length of the fixed header.
+ * @param length The length of the packet including the fixed header.
+ * @return Whether a complete packet is available.
+ */
+bool frame(std::string_view buf, uint8_t &type, size_t &header, size_t &length);
+
+/**
+ * Append a QoS 0 publish packet to a buffer.
+ *
+ * @param out The buffer.
+ * @param topic The topic.
+ * @param payload The payload.
+ */
+void encode(std::string &out, std::string_view topic, std::string_view payload);
+
+/**
+ * The connection options of the MQTT transport.
+ */
+struct options {
+  std::string host = "127.0.0.1";
+  int port = 1883;
+  std::string id = "lights";
+  std::string username;
+  std::string password;
+
+  /**
+   * The keep alive in seconds.
+   */
+  int keep_alive = 30;
+};
+
+/**
+ * An MQTT 3.1.1 transport over TCP with QoS 0. A single I/O thread writes and reads the socket: messages published
+ * while a write is pending are coalesced into the next write and received publishes are passed to the handler as
+ * views into the receive buffer.
+ */
+class mqtt : public transport {
+ public:
+  explicit mqtt(options o);
+  ~mqtt() override;
+
+  /**
+   * Connect to the broker and start the I/O thread.
+   *
+   * @param error The error message.
+   * @return Whether the broker accepted the connection.
+   */
+  bool connect(std::string &error);
+
+  /**
+   * Send a disconnect and stop the I/O thread. Pending futures fail.
+   */
+  void close();
+
+  /**
+   * Whether the transport is connected.
+   */
+  bool connected() const { return connected_; }
+
+  std::future<void> publish(std::vector<message> batch) override;
+  void subscribe(const std::string &filter) override;
+  void receive(handler h) override;
+
+  /**
+   * The number of socket writes (to observe batching).
+   */
+  uint64_t writes() const { return writes_; }
+
+ private:
+  void queue(const std::string &bytes);
+  void run();
+  bool flush();
+  bool read();
+  void fail();
+
+  options options_;
+  int socket_ = -1;
+  int wake_[2] = {-1, -1};
+  std::thread thread_;
+  std::atomic<bool> connected_{false};
+  std::atomic<bool> stopping_{false};
+  std::atomic<uint64_t> writes_{0};
+
+  // guarded by the mutex
+  std::mutex mutex_;
+  std::string out_;
+  uint64_t queued_ = 0;
+  std::deque<std::pair<uint64_t, std::promise<void>>> pending_;
+  uint16_t packet_id_ = 0;
+
+  // swapped atomically so that the handler is called without holding the mutex
+  std::shared_ptr<const handler> handler_;
+
+  // owned by the I/O thread
+  std::string writing_;
+  size_t offset_ = 0;
+  uint64_t written_ = 0;
+  std::string in_;
+};
+
+/**
+ * A minimal local MQTT broker for QoS 0 that forwards publishes to matching subscriptions. It is used by the tests and
+ * the benchmark if no broker is given.
+ */
+class broker {
+ public:
+  broker() = default;
+  ~broker();
+
+  /**
+   * Listen on the loopback interface and start the broker thread.
+   *
+   * @param port The port or zero for any free port.
+   * @param error The error message.
+   * @return Whether the broker has been started.
+   */
+  bool start(int port, std::string &error);
+
+  /**
+   * Stop the broker thread and close all connections.
+   */
+  void stop();
+
+  /**
+   * The port the broker listens on.
+   */
+  int port() const { return port_; }
+
+  /**
+   * The number of forwarded publishes.
+   */
+  uint64_t forwarded() const { return forwarded_; }
+
+ private:
+  struct connection {
+    int fd;
+    std::string in;
+    std::string out;
+    std::vector<std::string> filters;
+  };
+
+  void run();
+  bool handle(connection &c);
+
+  int listener_ = -1;
+  int port_ = 0;
+  int wake_[2] = {-1, -1};
+  std::thread thread_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<uint64_t> forwarded_{0};
+  std::vector<connection> connections_;
+};
+
+}  // namespace client
+
+#endif  // CLIENT_MQTT_H
@@ -0,0 +1,81 @@
+#include "telemetry.h"
+
+#include <charconv>
+
+namespace client {
+
+bool parse(std::string_view prefix, std::string_view topic, std::string_view payload, sample &s) {
+  // check prefix
+  if (topic.size() <= prefix.size() || topic.compare(0, prefix.size(), prefix) != 0 || topic[prefix.size()] != '/') {
+    return false;
+  }
+  topic.remove_prefix(prefix.size() + 1);
+
+  // read light number
+  size_t slash = topic.find('/');
+  if (slash == std::string_view::npos) {
+    return false;
+  }
+  int light = 0;
+  auto r = std::from_chars(topic.data(), topic.data() + slash, light);
+  if (r.ec != std::errc() || r.ptr != topic.data() + slash) {
+    return false;
+  }
+
+  // set sample
+  s.light = light;
+  s.name = topic.substr(slash + 1);
+  s.payload = payload;
+
+  return true;
+}
+
+bool number(std::string_view text, double &value) {
+  // parse complete text
+  auto r = std::from_chars(text.data(), text.data() + text.size(), value);
+  return !text.empty() && r.ec == std::errc() && r.ptr == text.data() + text.size();
+}
+
+bool pairs::get(std::string_view key, std::string_view &value) const {
+  // find key
+  bool found = false;
+  each([&](std::string_view k, std::string_view v) {
+    if (!found && k == key) {
+      value = v;
+      found = true;
+    }
+  });
+
+  return found;
+}
+
+bool pairs::get(std::string_view key, double &value) const {
+  std::string_view text;
+  return get(key, text) && number(text, value);
+}
+
+bool parse(std::string_view payload, plan &p) {
+  // read six space separated fields
+  double *fields[] = {&p.position, &p.velocity, &p.target, &p.max_velocity, &p.max_acceleration};
+  const char *at = payload.data();
+  const char *end = payload.data() + payload.size();
+  auto r = std::from_chars(at, end, p.start);
+  if (r.ec != std::errc()) {
+    return false;
+  }
+  at = r.ptr;
+  for (double *f : fields) {
+    if (at == end || *at != ' ') {
+      return false;
+    }
+    r = std::from_chars(at + 1, end, *f);
+    if (r.ec != std::errc()) {
+      return false;
+    }
+    at = r.ptr;
+  }
+
+  return at == end;
+}
+
+}  // namespace client
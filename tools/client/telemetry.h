@@ -0,0 +1,117 @@
+#ifndef CLIENT_TELEMETRY_H
+#define CLIENT_TELEMETRY_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace client {
+
+/**
+ * A received telemetry message. The views point into the receive buffer of the transport and are only valid during
+ * the callback.
+ */
+struct sample {
+  /**
+   * The light number taken from the topic "<prefix>/<light>/<name>".
+   */
+  int light = 0;
+
+  /**
+   * The topic name below the light and the payload.
+   */
+  std::string_view name;
+  std::string_view payload;
+};
+
+/**
+ * Split a topic of the form "<prefix>/<light>/<name>" without copying.
+ *
+ * @param prefix The topic prefix.
+ * @param topic The topic.
+ * @param payload The payload.
+ * @param s The sample.
+ * @return Whether the topic belongs to a light.
+ */
+bool parse(std::string_view prefix, std::string_view topic, std::string_view payload, sample &s);
+
+/**
+ * Parse a complete number.
+ *
+ * @param text The text.
+ * @param value The value.
+ * @return Whether the text is a number.
+ */
+bool number(std::string_view text, double &value);
+
+/**
+ * The space separated "key=value" pairs of the health, summary, config and telemetry payloads.
+ */
+class pairs {
+ public:
+  explicit pairs(std::string_view text) : text_(text) {}
+
+  /**
+   * Find a value by key.
+   *
+   * @param key The key.
+   * @param value The value.
+   * @return Whether the key exists.
+   */
+  bool get(std::string_view key, std::string_view &value) const;
+
+  /**
+   * Find a numeric value by key.
+   *
+   * @param key The key.
+   * @param value The value.
+   * @return Whether the key exists and its value is a number.
+   */
+  bool get(std::string_view key, double &value) const;
+
+  /**
+   * Call a function with every pair.
+   *
+   * @param fn The function taking the key and the value.
+   */
+  template <typename F>
+  void each(F fn) const {
+    std::string_view rest = text_;
+    while (!rest.empty()) {
+      size_t end = rest.find(' ');
+      std::string_view pair = rest.substr(0, end);
+      size_t eq = pair.find('=');
+      if (eq != std::string_view::npos) {
+        fn(pair.substr(0, eq), pair.substr(eq + 1));
+      }
+      rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+    }
+  }
+
+ private:
+  std::string_view text_;
+};
+
+/**
+ * A motion plan as published on "plan".
+ */
+struct plan {
+  uint32_t start = 0;
+  double position = 0;
+  double velocity = 0;
+  double target = 0;
+  double max_velocity = 0;
+  double max_acceleration = 0;
+};
+
+/**
+ * Parse a plan payload.
+ *
+ * @param payload The payload.
+ * @param p The plan.
+ * @return Whether the payload is a plan.
+ */
+bool parse(std::string_view payload, plan &p);
+
+}  // namespace client
+
+#endif  // CLIENT_TELEMETRY_H
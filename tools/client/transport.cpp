@@ -0,0 +1,88 @@
+#include "transport.h"
+
+namespace client {
+
+bool match(std::string_view filter, std::string_view topic) {
+  // compare level by level
+  for (;;) {
+    // split first levels
+    size_t f = filter.find('/');
+    size_t t = topic.find('/');
+    std::string_view fl = filter.substr(0, f);
+    std::string_view tl = topic.substr(0, t);
+
+    // match rest or single level
+    if (fl == "#") {
+      return true;
+    }
+    if (fl != "+" && fl != tl) {
+      return false;
+    }
+
+    // check end of filter and topic
+    if (f == std::string_view::npos || t == std::string_view::npos) {
+      return f == t || (t == std::string_view::npos && filter.substr(f + 1) == "#");
+    }
+    filter.remove_prefix(f + 1);
+    topic.remove_prefix(t + 1);
+  }
+}
+
+std::future<void> loopback::publish(std::vector<message> batch) {
+  // record and deliver matching messages
+  for (auto &m : batch) {
+    bool matched = false;
+    handler h;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto &filter : filters_) {
+        matched = matched || match(filter, m.topic);
+      }
+      h = handler_;
+      published_.push_back(m);
+    }
+    if (matched && h) {
+      h(m.topic, m.payload);
+    }
+  }
+
+  // complete immediately
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+void loopback::subscribe(const std::string &filter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  filters_.push_back(filter);
+}
+
+void loopback::receive(handler h) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  handler_ = std::move(h);
+}
+
+void loopback::inject(std::string_view topic, std::string_view payload) {
+  // deliver if subscribed
+  handler h;
+  bool matched = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &filter : filters_) {
+      matched = matched || match(filter, topic);
+    }
+    h = handler_;
+  }
+  if (matched && h) {
+    h(topic, payload);
+  }
+}
+
+std::vector<message> loopback::take() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<message> out;
+  out.swap(published_);
+  return out;
+}
+
+}  // namespace client
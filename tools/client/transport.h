@@ -0,0 +1,97 @@
+#ifndef CLIENT_TRANSPORT_H
+#define CLIENT_TRANSPORT_H
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace client {
+
+/**
+ * A message to publish.
+ */
+struct message {
+  std::string topic;
+  std::string payload;
+};
+
+/**
+ * Called for every received message. The views are only valid during the call.
+ */
+using handler = std::function<void(std::string_view topic, std::string_view payload)>;
+
+/**
+ * The pluggable transport of the client.
+ */
+class transport {
+ public:
+  virtual ~transport() = default;
+
+  /**
+   * Queue messages to be published in order and return immediately.
+   *
+   * @param batch The messages.
+   * @return A future that is ready once all messages have been handed to the network.
+   */
+  virtual std::future<void> publish(std::vector<message> batch) = 0;
+
+  /**
+   * Subscribe a topic filter with the MQTT wildcards "+" and "#".
+   *
+   * @param filter The filter.
+   */
+  virtual void subscribe(const std::string &filter) = 0;
+
+  /**
+   * Set the handler for received messages. It is called from the thread of the transport.
+   *
+   * @param h The handler.
+   */
+  virtual void receive(handler h) = 0;
+};
+
+/**
+ * Check whether a topic matches a filter with the MQTT wildcards "+" and "#".
+ *
+ * @param filter The filter.
+ * @param topic The topic.
+ * @return Whether the topic matches.
+ */
+bool match(std::string_view filter, std::string_view topic);
+
+/**
+ * An in-process transport that delivers published messages synchronously to its own handler if they match a
+ * subscription. It is used by tests and by hosts that embed simulated lights.
+ */
+class loopback : public transport {
+ public:
+  std::future<void> publish(std::vector<message> batch) override;
+  void subscribe(const std::string &filter) override;
+  void receive(handler h) override;
+
+  /**
+   * Deliver a message as if it had been received from the network.
+   *
+   * @param topic The topic.
+   * @param payload The payload.
+   */
+  void inject(std::string_view topic, std::string_view payload);
+
+  /**
+   * Get and clear the published messages.
+   */
+  std::vector<message> take();
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> filters_;
+  std::vector<message> published_;
+  handler handler_;
+};
+
+}  // namespace client
+
+#endif  // CLIENT_TRANSPORT_H
@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "crowd/world.h"
+#include "sim/pool.h"
+
+namespace {
+
+struct options {
+  size_t agents = 200;
+  size_t lights = 24;
+  double spacing = 250;
+  double height = 100;
+  double seconds = 60;
+  unsigned threads = 0;
+  uint64_t seed = 1;
+  std::string out;
+  bool bench = false;
+};
+
+void usage() {
+  fprintf(stderr,
+          "usage: crowd [--agents N] [--lights N] [--spacing CM] [--height CM] [--seconds S] [--threads N] [--seed S]\n"
+          "             [--out FILE] [--bench]\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--bench") {
+      o.bench = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--agents") {
+      o.agents = strtoul(value, nullptr, 10);
+    } else if (flag == "--lights") {
+      o.lights = strtoul(value, nullptr, 10);
+    } else if (flag == "--spacing") {
+      o.spacing = atof(value);
+    } else if (flag == "--height") {
+      o.height = atof(value);
+    } else if (flag == "--seconds") {
+      o.seconds = atof(value);
+    } else if (flag == "--threads") {
+      o.threads = static_cast<unsigned>(atoi(value));
+    } else if (flag == "--seed") {
+      o.seed = strtoull(value, nullptr, 10);
+    } else if (flag == "--out") {
+      o.out = value;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+crowd::world create(const options &o) {
+  // arrange lights and populate floor
+  double width = 0, depth = 0;
+  auto lights = crowd::grid(o.lights, o.spacing, o.height, width, depth);
+  crowd::world w(crowd::params(), lights, width, depth, o.seed);
+  w.populate(o.agents);
+
+  return w;
+}
+
+int bench(const options &o) {
+  // use 10k agents under 1000 lights unless specified
+  options b = o;
+  if (b.agents == options().agents && b.lights == options().lights) {
+    b.agents = 10000;
+    b.lights = 1000;
+  }
+
+  // measure single and multi threaded throughput over one simulated minute
+  unsigned workers = sim::threads(o.threads);
+  for (unsigned n : {1u, workers}) {
+    crowd::world w = create(b);
+    auto steps = static_cast<size_t>(60 / crowd::params().dt);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t s = 0; s < steps; s++) {
+      w.step(n);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double agent_steps = static_cast<double>(steps * b.agents);
+    double samples = 60.0 * 10 * 2 * static_cast<double>(b.lights);
+    printf("threads=%u agents=%zu lights=%zu seconds=%.3f agent-steps/s=%.3g samples/s=%.3g speedup=%.1fx\n", n,
+           b.agents, b.lights, seconds, agent_steps / seconds, samples / seconds, 60 / seconds);
+    if (n == workers) {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // run benchmark
+  if (o.bench) {
+    return bench(o);
+  }
+
+  // open output
+  FILE *out = stdout;
+  if (!o.out.empty()) {
+    out = fopen(o.out.c_str(), "w");
+    if (out == nullptr) {
+      fprintf(stderr, "crowd: failed to open %s\n", o.out.c_str());
+      return 1;
+    }
+  }
+
+  // write samples of every light as they are taken
+  crowd::world w = create(o);
+  unsigned threads = sim::threads(o.threads);
+  fprintf(out, "time,light,pir,pulse\n");
+  while (static_cast<double>(w.time()) < o.seconds * 1000) {
+    w.step(threads);
+    for (size_t i = 0; i < w.lights().size(); i++) {
+      const crowd::light &l = w.lights()[i];
+      if (l.sampled == w.time()) {
+        fprintf(out, "%llu,%zu,%d,%u\n", static_cast<unsigned long long>(l.sampled), i, l.pir, l.pulse);
+      }
+    }
+  }
+
+  // close output
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  return 0;
+}
@@ -0,0 +1,375 @@
+#include "world.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "sim/pool.h"
+
+namespace crowd {
+
+namespace {
+
+// the firmware pir rest value, adc range and sensor interval in ms
+const int pir_rest = 590;
+const int pir_max = 1023;
+const uint64_t sensor_interval = 100;
+
+// the echo pulse width per cm as measured by dst.c
+const double us_per_cm = 58.7;
+
+// the distance from the light at which agents stand and the distance at which a goal is reached
+const double stand_distance = 45;
+const double arrival = 30;
+
+// the spacing of group members around the leader goal
+const double group_spacing = 60;
+
+// the height from which a hand rises when reaching and the radius of a head
+const double hand_rest = 40;
+const double head_radius = 10;
+
+// the maximum acceleration in cm/s^2 to keep overlapping agents stable
+const double max_force = 2000;
+
+// the number of pir sectors and the maximum agents considered per pir sample
+const int sectors = 8;
+const int max_seen = 64;
+
+// the number of agents moved per parallel task
+const size_t chunk = 256;
+
+}  // namespace
+
+uint64_t rng::next() {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+double rng::unit() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+double rng::normal() {
+  // use box-muller transform
+  double u = std::max(unit(), 1e-300);
+  return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * unit());
+}
+
+std::vector<light> grid(size_t count, double spacing, double height, double &width, double &depth) {
+  // calculate columns and rows
+  auto columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  size_t rows = columns > 0 ? (count + columns - 1) / columns : 0;
+  width = static_cast<double>(columns) * spacing;
+  depth = static_cast<double>(rows) * spacing;
+
+  // place lights in the center of their cells and alternate the sample phase
+  std::vector<light> lights(count);
+  for (size_t i = 0; i < count; i++) {
+    lights[i].x = (static_cast<double>(i % columns) + 0.5) * spacing;
+    lights[i].y = (static_cast<double>(i / columns) + 0.5) * spacing;
+    lights[i].height = height;
+    lights[i].phase = static_cast<uint32_t>(i % 2) * 50;
+    lights[i].random.state = i + 1;
+  }
+
+  return lights;
+}
+
+world::world(const params &p, std::vector<light> lights, double width, double depth, uint64_t seed)
+    : params_(p), lights_(std::move(lights)), width_(width), depth_(depth), random_{seed} {
+  // prepare spatial index
+  columns_ = std::max(1, static_cast<int>(std::ceil(width / p.cutoff)));
+  rows_ = std::max(1, static_cast<int>(std::ceil(depth / p.cutoff)));
+  starts_.resize(static_cast<size_t>(columns_ * rows_) + 1);
+
+  // seed light noise
+  for (auto &l : lights_) {
+    l.random.state ^= random_.next();
+  }
+}
+
+void world::populate(size_t n) {
+  // add groups until the requested number of agents is reached
+  size_t end = agents_.size() + n;
+  while (agents_.size() < end) {
+    size_t size = std::min(end - agents_.size(), 1 + static_cast<size_t>(random_.next() % params_.group_max));
+    double x = random_.unit() * width_;
+    double y = random_.unit() * depth_;
+    auto leader = static_cast<uint32_t>(agents_.size());
+    for (size_t i = 0; i < size; i++) {
+      agent a;
+      a.x = std::min(width_, std::max(0.0, x + (random_.unit() - 0.5) * group_spacing * 2));
+      a.y = std::min(depth_, std::max(0.0, y + (random_.unit() - 0.5) * group_spacing * 2));
+      a.speed = std::max(30.0, params_.walk_speed + random_.normal() * params_.walk_spread);
+      a.head = params_.head_min + random_.unit() * (params_.head_max - params_.head_min);
+      a.reach = params_.hand_min + random_.unit() * (params_.hand_max - params_.hand_min);
+      a.random.state = random_.next();
+      a.leader = leader;
+      agents_.push_back(a);
+    }
+    pick(agents_[leader]);
+  }
+}
+
+void world::add(const agent &a) {
+  // add agent leading itself
+  agents_.push_back(a);
+  agents_.back().leader = static_cast<uint32_t>(agents_.size() - 1);
+}
+
+void world::pick(agent &a) {
+  // walk to a light or a random point
+  if (!lights_.empty() && a.random.unit() < params_.attraction) {
+    a.target = static_cast<int>(a.random.next() % lights_.size());
+    double angle = a.random.unit() * 2 * M_PI;
+    a.gx = lights_[static_cast<size_t>(a.target)].x + std::cos(angle) * stand_distance;
+    a.gy = lights_[static_cast<size_t>(a.target)].y + std::sin(angle) * stand_distance;
+  } else {
+    a.target = -1;
+    a.gx = a.random.unit() * width_;
+    a.gy = a.random.unit() * depth_;
+  }
+  a.activity = walking;
+  a.hand = -1;
+}
+
+void world::decide(size_t i) {
+  // get agent and time
+  agent &a = agents_[i];
+  double now = static_cast<double>(time_) / 1000;
+
+  // follow the leader goal at a stable offset
+  bool leads = a.leader == i;
+  if (!leads) {
+    const agent &l = agents_[a.leader];
+    double angle = static_cast<double>(i % 8) * M_PI / 4;
+    a.gx = l.gx + std::cos(angle) * group_spacing;
+    a.gy = l.gy + std::sin(angle) * group_spacing;
+    a.target = l.target;
+    if (l.activity == walking && a.activity != walking) {
+      a.activity = walking;
+      a.hand = -1;
+    }
+  }
+
+  // handle arrival
+  if (a.activity == walking && std::hypot(a.gx - a.x, a.gy - a.y) < arrival) {
+    if (a.target >= 0) {
+      bool reach = a.random.unit() < params_.reach;
+      a.activity = reach ? reaching : standing;
+      a.hand = reach ? hand_rest : -1;
+      a.until = now + params_.stay_min + a.random.unit() * (params_.stay_max - params_.stay_min);
+    } else if (leads) {
+      pick(a);
+    } else {
+      a.activity = standing;
+    }
+    return;
+  }
+
+  // handle departure
+  if (leads && a.activity != walking && now >= a.until) {
+    pick(a);
+  }
+}
+
+void world::index() {
+  // count agents per cell
+  std::fill(starts_.begin(), starts_.end(), 0);
+  auto cell = [&](const agent &a) {
+    int cx = std::min(columns_ - 1, std::max(0, static_cast<int>(a.x / params_.cutoff)));
+    int cy = std::min(rows_ - 1, std::max(0, static_cast<int>(a.y / params_.cutoff)));
+    return static_cast<size_t>(cy * columns_ + cx);
+  };
+  for (const auto &a : agents_) {
+    starts_[cell(a) + 1]++;
+  }
+
+  // accumulate starts and sort agents into cells
+  for (size_t c = 1; c < starts_.size(); c++) {
+    starts_[c] += starts_[c - 1];
+  }
+  cells_.resize(agents_.size());
+  std::vector<uint32_t> fill(starts_.begin(), starts_.end() - 1);
+  for (size_t i = 0; i < agents_.size(); i++) {
+    cells_[fill[cell(agents_[i])]++] = static_cast<uint32_t>(i);
+  }
+}
+
+template <typename F>
+void world::nearby(double x, double y, double r, F fn) const {
+  // visit agents of all cells overlapping the square around the point
+  int x0 = std::max(0, static_cast<int>((x - r) / params_.cutoff));
+  int x1 = std::min(columns_ - 1, static_cast<int>((x + r) / params_.cutoff));
+  int y0 = std::max(0, static_cast<int>((y - r) / params_.cutoff));
+  int y1 = std::min(rows_ - 1, static_cast<int>((y + r) / params_.cutoff));
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      auto c = static_cast<size_t>(cy * columns_ + cx);
+      for (uint32_t k = starts_[c]; k < starts_[c + 1]; k++) {
+        fn(cells_[k]);
+      }
+    }
+  }
+}
+
+void world::move(size_t i, agent &out) const {
+  // copy agent
+  const agent &a = agents_[i];
+  out = a;
+
+  // accelerate towards the desired velocity
+  double dvx = 0, dvy = 0;
+  double dx = a.gx - a.x, dy = a.gy - a.y;
+  double dist = std::hypot(dx, dy);
+  if (a.activity == walking && dist > 0) {
+    double speed = std::min(a.speed, dist / params_.relax);
+    dvx = dx / dist * speed;
+    dvy = dy / dist * speed;
+  }
+  double fx = (dvx - a.vx) / params_.relax;
+  double fy = (dvy - a.vy) / params_.relax;
+
+  // repel from neighbors
+  nearby(a.x, a.y, params_.cutoff, [&](uint32_t j) {
+    if (j == i) {
+      return;
+    }
+    const agent &b = agents_[j];
+    double nx = a.x - b.x, ny = a.y - b.y;
+    double d2 = nx * nx + ny * ny;
+    if (d2 >= params_.cutoff * params_.cutoff || d2 <= 0) {
+      return;
+    }
+    double d = std::sqrt(d2);
+    double f = params_.repulsion * std::exp((2 * params_.radius - d) / params_.range);
+    fx += nx / d * f;
+    fy += ny / d * f;
+  });
+
+  // limit force and integrate
+  double f = std::hypot(fx, fy);
+  if (f > max_force) {
+    fx *= max_force / f;
+    fy *= max_force / f;
+  }
+  out.vx += fx * params_.dt;
+  out.vy += fy * params_.dt;
+  double v = std::hypot(out.vx, out.vy);
+  double limit = a.speed * 1.3;
+  if (v > limit) {
+    out.vx *= limit / v;
+    out.vy *= limit / v;
+  }
+  out.x = std::min(width_, std::max(0.0, a.x + out.vx * params_.dt));
+  out.y = std::min(depth_, std::max(0.0, a.y + out.vy * params_.dt));
+
+  // raise reaching hand
+  if (a.activity == reaching) {
+    out.hand = std::min(a.reach, a.hand + params_.hand_speed * params_.dt);
+  }
+}
+
+void world::sense(size_t i) {
+  // get light
+  light &l = lights_[i];
+  l.sampled = time_;
+
+  // collect agents in the pir field of view
+  double radius = params_.pir_spread * l.height;
+  double beam = std::tan(params_.sonar_angle * M_PI / 180);
+  double nearest[sectors];
+  std::fill(nearest, nearest + sectors, radius);
+  struct seen {
+    int sector;
+    double distance, magnitude;
+  } seen[max_seen];
+  int count = 0;
+  double echo = l.height;
+  nearby(l.x, l.y, radius, [&](uint32_t j) {
+    const agent &a = agents_[j];
+    double dx = a.x - l.x, dy = a.y - l.y;
+    double d = std::hypot(dx, dy);
+
+    // the nearest object below the light within the beam returns the first echo and occludes the others
+    if (a.head < l.height && d < (l.height - a.head) * beam + head_radius) {
+      echo = std::min(echo, l.height - a.head);
+    }
+    if (a.hand >= 0 && a.hand < l.height && a.target == static_cast<int>(i)) {
+      echo = std::min(echo, l.height - a.hand);
+    }
+
+    // record pir contribution
+    if (d >= radius || count >= max_seen) {
+      return;
+    }
+    double magnitude = params_.pir_standing;
+    if (a.activity == reaching) {
+      magnitude = params_.pir_reaching;
+    } else if (a.activity == walking) {
+      double v = std::hypot(a.vx, a.vy);
+      magnitude = std::max(params_.pir_standing, params_.pir_walking * std::min(1.0, v / a.speed));
+    }
+    magnitude *= 1 - (d / radius) * (d / radius);
+    int sector = static_cast<int>((std::atan2(dy, dx) + M_PI) / (2 * M_PI) * sectors) % sectors;
+    seen[count++] = {sector, d, magnitude};
+    nearest[sector] = std::min(nearest[sector], d);
+  });
+
+  // sum pir magnitudes and attenuate agents behind nearer agents of the same sector
+  double total = 0;
+  for (int k = 0; k < count; k++) {
+    total += seen[k].distance > nearest[seen[k].sector] ? seen[k].magnitude * params_.pir_occlusion : seen[k].magnitude;
+  }
+
+  // produce adc value swinging around the rest value
+  double sign = l.random.unit() < 0.5 ? -1 : 1;
+  double r = pir_rest + sign * total + l.random.normal() * params_.pir_noise;
+  l.pir = std::min(pir_max, std::max(0, static_cast<int>(std::lround(r))));
+
+  // produce echo pulse width
+  double distance = echo + l.random.normal() * params_.sonar_noise;
+  if (l.random.unit() < params_.sonar_dropout || distance <= 0) {
+    l.pulse = 0;
+  } else {
+    l.pulse = static_cast<uint32_t>(distance * us_per_cm);
+  }
+}
+
+void world::step(unsigned threads) {
+  // advance time
+  time_ += static_cast<uint64_t>(std::lround(params_.dt * 1000));
+
+  // make decisions serially so that followers see their leaders
+  for (size_t i = 0; i < agents_.size(); i++) {
+    decide(i);
+  }
+
+  // index agents and move them in parallel
+  index();
+  next_.resize(agents_.size());
+  size_t tasks = (agents_.size() + chunk - 1) / chunk;
+  sim::parallel_for(tasks, threads, [&](size_t t) {
+    for (size_t i = t * chunk; i < std::min(agents_.size(), (t + 1) * chunk); i++) {
+      move(i, next_[i]);
+    }
+  });
+  agents_.swap(next_);
+
+  // sample sensors at their rate
+  index();
+  std::vector<uint32_t> due;
+  for (size_t i = 0; i < lights_.size(); i++) {
+    if ((time_ + lights_[i].phase) % sensor_interval == 0) {
+      due.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  tasks = (due.size() + chunk - 1) / chunk;
+  sim::parallel_for(tasks, threads, [&](size_t t) {
+    for (size_t k = t * chunk; k < std::min(due.size(), (t + 1) * chunk); k++) {
+      sense(due[k]);
+    }
+  });
+}
+
+}  // namespace crowd
@@ -0,0 +1,283 @@
+#ifndef CROWD_WORLD_H
+#define CROWD_WORLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crowd {
+
+/**
+ * A small random generator that is cheap to keep per agent and light.
+ */
+struct rng {
+  uint64_t state;
+
+  /**
+   * Get the next 64 bit value (splitmix64).
+   */
+  uint64_t next();
+
+  /**
+   * Get a uniform value in [0, 1).
+   */
+  double unit();
+
+  /**
+   * Get a standard normal value.
+   */
+  double normal();
+};
+
+/**
+ * The model parameters. Distances are in cm and times in seconds unless noted.
+ */
+struct params {
+  /**
+   * The agent time step.
+   */
+  double dt = 0.05;
+
+  /**
+   * The desired walking speed and its spread.
+   */
+  double walk_speed = 130;
+  double walk_spread = 20;
+
+  /**
+   * The body radius and the social force model (relaxation time, repulsion strength, repulsion range and cutoff).
+   */
+  double radius = 25;
+  double relax = 0.5;
+  double repulsion = 2500;
+  double range = 8;
+  double cutoff = 100;
+
+  /**
+   * The probability that a goal is a light instead of a random point.
+   */
+  double attraction = 0.7;
+
+  /**
+   * The range of time an agent stays under a light.
+   */
+  double stay_min = 10;
+  double stay_max = 60;
+
+  /**
+   * The probability that an agent reaches for a light, the range of hand heights and the hand speed.
+   */
+  double reach = 0.6;
+  double hand_min = 60;
+  double hand_max = 130;
+  double hand_speed = 20;
+
+  /**
+   * The range of head heights.
+   */
+  double head_min = 110;
+  double head_max = 195;
+
+  /**
+   * The maximum group size.
+   */
+  int group_max = 4;
+
+  /**
+   * The PIR field of view (as radius per cm of light height), the magnitudes of a walking, standing and reaching
+   * agent, the noise and the factor of agents occluded by a nearer agent in the same sector.
+   */
+  double pir_spread = 1.2;
+  double pir_walking = 320;
+  double pir_standing = 140;
+  double pir_reaching = 260;
+  double pir_noise = 12;
+  double pir_occlusion = 0.3;
+
+  /**
+   * The sonar beam half angle in degrees, the noise and the probability of a missing echo.
+   */
+  double sonar_angle = 15;
+  double sonar_noise = 1;
+  double sonar_dropout = 0.01;
+};
+
+/**
+ * A light with its latest sensor samples.
+ */
+struct light {
+  /**
+   * The position on the floor and the height above the floor.
+   */
+  double x = 0;
+  double y = 0;
+  double height = 100;
+
+  /**
+   * The sample phase in ms.
+   */
+  uint32_t phase = 0;
+
+  /**
+   * The latest raw PIR ADC value (0 to 1023, resting at 590) and echo pulse width in us (zero if no echo was
+   * received), as read by pir.c and dst.c.
+   */
+  int pir = 590;
+  uint32_t pulse = 0;
+
+  /**
+   * The time of the latest sample in ms.
+   */
+  uint64_t sampled = 0;
+
+  /**
+   * The noise generator.
+   */
+  rng random{0};
+};
+
+/**
+ * The activity of an agent.
+ */
+enum mode { walking, standing, reaching };
+
+/**
+ * A visitor.
+ */
+struct agent {
+  double x = 0;
+  double y = 0;
+  double vx = 0;
+  double vy = 0;
+
+  /**
+   * The current goal and the desired speed.
+   */
+  double gx = 0;
+  double gy = 0;
+  double speed = 130;
+
+  /**
+   * The head height, the current hand height (negative if not reaching) and the target hand height.
+   */
+  double head = 170;
+  double hand = -1;
+  double reach = 100;
+
+  /**
+   * The activity and the time it ends in seconds.
+   */
+  mode activity = walking;
+  double until = 0;
+
+  /**
+   * The index of the light that is the goal or -1 if the goal is a random point.
+   */
+  int target = -1;
+
+  /**
+   * The index of the group leader (the agent itself if it leads).
+   */
+  uint32_t leader = 0;
+
+  /**
+   * The decision generator.
+   */
+  rng random{0};
+};
+
+/**
+ * Arrange lights in a grid of roughly square shape.
+ *
+ * @param count The number of lights.
+ * @param spacing The spacing in cm.
+ * @param height The height in cm.
+ * @param width The resulting floor width.
+ * @param depth The resulting floor depth.
+ * @return The lights.
+ */
+std::vector<light> grid(size_t count, double spacing, double height, double &width, double &depth);
+
+/**
+ * A crowd of waypoint agents with social forces on the installation floor. Agents walk to lights or random points,
+ * stand and reach for lights and move in groups. Lights sample their PIR and sonar every 100 ms like the firmware.
+ * Agent decisions are made serially and forces and sensors are computed in parallel, so results do not depend on
+ * the number of threads.
+ */
+class world {
+ public:
+  /**
+   * Create an empty floor.
+   *
+   * @param p The parameters.
+   * @param lights The lights.
+   * @param width The floor width.
+   * @param depth The floor depth.
+   * @param seed The seed.
+   */
+  world(const params &p, std::vector<light> lights, double width, double depth, uint64_t seed);
+
+  /**
+   * Add random agents in groups at random positions.
+   *
+   * @param n The number of agents.
+   */
+  void populate(size_t n);
+
+  /**
+   * Add an agent. Its leader is set to itself.
+   *
+   * @param a The agent.
+   */
+  void add(const agent &a);
+
+  /**
+   * Advance the world by one time step.
+   *
+   * @param threads The number of threads.
+   */
+  void step(unsigned threads);
+
+  /**
+   * Get the simulated time in ms.
+   */
+  uint64_t time() const { return time_; }
+
+  /**
+   * Get the lights. Heights may be changed between steps, e.g. by a light simulation.
+   */
+  std::vector<light> &lights() { return lights_; }
+
+  /**
+   * Get the agents.
+   */
+  const std::vector<agent> &agents() const { return agents_; }
+
+ private:
+  void pick(agent &a);
+  void decide(size_t i);
+  void index();
+  void move(size_t i, agent &out) const;
+  void sense(size_t i);
+  template <typename F>
+  void nearby(double x, double y, double r, F fn) const;
+
+  params params_;
+  std::vector<light> lights_;
+  double width_;
+  double depth_;
+  rng random_;
+  std::vector<agent> agents_;
+  std::vector<agent> next_;
+  uint64_t time_ = 0;
+
+  // the spatial index of agents
+  int columns_ = 1;
+  int rows_ = 1;
+  std::vector<uint32_t> starts_;
+  std::vector<uint32_t> cells_;
+};
+
+}  // namespace crowd
+
+#endif  // CROWD_WORLD_H
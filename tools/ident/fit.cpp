@@ -0,0 +1,368 @@
+#include "fit.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ident {
+
+namespace {
+
+// the encoder steps per spool rotation
+const int encoder_resolution = 20;
+
+// the ticks a light coasts after the motor has been stopped and the ticks per window
+const uint32_t coast = 100;
+const size_t window = 10;
+
+// the number of fitted motor parameters (up gain, up offset, down gain, down offset, inertia)
+const int num_params = 5;
+
+// the limits of the levenberg-marquardt search
+const int max_iterations = 100;
+const double tolerance = 1e-9;
+
+struct tick_t {
+  int16_t duty;
+  int16_t encoder;
+};
+
+struct period {
+  uint32_t start, end;
+  std::vector<tick_t> ticks;
+};
+
+std::vector<period> expand(const std::vector<row> &rows) {
+  // find periods from the first driven tick until the light has coasted after the last driven tick
+  std::vector<period> periods;
+  int duty = 0;
+  for (const auto &r : rows) {
+    uint32_t k = r.time / tick;
+    if (r.duty != 0 && duty == 0) {
+      if (!periods.empty() && k <= periods.back().end) {
+        periods.back().end = UINT32_MAX;
+      } else {
+        periods.push_back({k, UINT32_MAX, {}});
+      }
+    } else if (r.duty == 0 && duty != 0) {
+      periods.back().end = k + coast;
+    }
+    duty = r.duty;
+  }
+  if (!periods.empty() && periods.back().end == UINT32_MAX) {
+    periods.back().end = rows.back().time / tick + 1;
+  }
+
+  // fill ticks with the duty of the latest row and the encoder steps of the rows
+  size_t next = 0;
+  duty = 0;
+  for (auto &p : periods) {
+    p.ticks.resize(p.end - p.start);
+    for (uint32_t k = p.start; k < p.end; k++) {
+      int16_t steps = 0;
+      while (next < rows.size() && rows[next].time / tick <= k) {
+        if (rows[next].time / tick == k) {
+          steps = static_cast<int16_t>(steps + rows[next].encoder);
+        }
+        duty = rows[next].duty;
+        next++;
+      }
+      p.ticks[k - p.start] = {static_cast<int16_t>(duty), steps};
+    }
+  }
+
+  return periods;
+}
+
+inline double speed(const double *theta, int duty) {
+  // invert the motor model (10 bit duty = gain * speed + offset)
+  double d = std::abs(duty) / 4.0;
+  if (duty > 0 && d > theta[1]) {
+    return (d - theta[1]) / theta[0];
+  } else if (duty < 0 && d > theta[3]) {
+    return -(d - theta[3]) / theta[2];
+  }
+  return 0;
+}
+
+double pass(const std::vector<period> &periods, double step, const double *theta, bool jacobian,
+            double jtj[num_params][num_params], double jtr[num_params], size_t &windows) {
+  // prepare base and perturbed parameter sets
+  int sets = jacobian ? num_params + 1 : 1;
+  double params[num_params + 1][num_params];
+  double h[num_params];
+  double decay[num_params + 1];
+  for (int j = 0; j < sets; j++) {
+    std::copy(theta, theta + num_params, params[j]);
+    if (j > 0) {
+      h[j - 1] = 1e-4 * std::max(1.0, std::abs(theta[j - 1]));
+      params[j][j - 1] += h[j - 1];
+    }
+    decay[j] = 1 - std::exp(-static_cast<double>(tick) / params[j][4]);
+  }
+  if (jacobian) {
+    for (int a = 0; a < num_params; a++) {
+      jtr[a] = 0;
+      std::fill(jtj[a], jtj[a] + num_params, 0.0);
+    }
+  }
+
+  // simulate all periods starting at rest, the steps of a tick are driven by the duty of the previous tick
+  double cost = 0;
+  windows = 0;
+  for (const auto &p : periods) {
+    double v[num_params + 1] = {0};
+    double disp[num_params + 1] = {0};
+    int steps = 0;
+    int duty = 0;
+
+    // compare the displacement since the start of the period at the end of every window and accumulate the sums
+    // needed to remove the unknown encoder phase at the start of the period (the mean residual of the period)
+    double n = 0, sr = 0, srr = 0;
+    double sj[num_params] = {0}, sjr[num_params] = {0}, sjj[num_params][num_params] = {{0}};
+    for (size_t w = 0; w + window <= p.ticks.size(); w += window) {
+      for (size_t k = w; k < w + window; k++) {
+        for (int j = 0; j < sets; j++) {
+          // integrate the first order lag exactly over the tick
+          double s = speed(params[j], duty);
+          disp[j] += (s * tick + (v[j] - s) * params[j][4] * decay[j]) / 1000;
+          v[j] += (s - v[j]) * decay[j];
+        }
+        steps += p.ticks[k].encoder;
+        duty = p.ticks[k].duty;
+      }
+
+      // accumulate residual and jacobian sums
+      double r = disp[0] - steps * step;
+      n++;
+      sr += r;
+      srr += r * r;
+      if (jacobian) {
+        double jr[num_params];
+        for (int a = 0; a < num_params; a++) {
+          jr[a] = (disp[a + 1] - disp[0]) / h[a];
+        }
+        for (int a = 0; a < num_params; a++) {
+          sj[a] += jr[a];
+          sjr[a] += jr[a] * r;
+          for (int b = 0; b < num_params; b++) {
+            sjj[a][b] += jr[a] * jr[b];
+          }
+        }
+      }
+    }
+    if (n == 0) {
+      continue;
+    }
+
+    // add centered residuals and normal equations
+    cost += srr - sr * sr / n;
+    windows += static_cast<size_t>(n);
+    if (jacobian) {
+      for (int a = 0; a < num_params; a++) {
+        jtr[a] += sjr[a] - sj[a] * sr / n;
+        for (int b = 0; b < num_params; b++) {
+          jtj[a][b] += sjj[a][b] - sj[a] * sj[b] / n;
+        }
+      }
+    }
+  }
+
+  return cost;
+}
+
+bool solve(double a[num_params][num_params], double b[num_params], double x[num_params]) {
+  // eliminate with partial pivoting
+  for (int c = 0; c < num_params; c++) {
+    int pivot = c;
+    for (int r = c + 1; r < num_params; r++) {
+      if (std::abs(a[r][c]) > std::abs(a[pivot][c])) {
+        pivot = r;
+      }
+    }
+    if (std::abs(a[pivot][c]) < 1e-300) {
+      return false;
+    }
+    std::swap(a[c], a[pivot]);
+    std::swap(b[c], b[pivot]);
+    for (int r = c + 1; r < num_params; r++) {
+      double f = a[r][c] / a[c][c];
+      for (int k = c; k < num_params; k++) {
+        a[r][k] -= f * a[c][k];
+      }
+      b[r] -= f * b[c];
+    }
+  }
+
+  // substitute backwards
+  for (int r = num_params - 1; r >= 0; r--) {
+    double s = b[r];
+    for (int k = r + 1; k < num_params; k++) {
+      s -= a[r][k] * x[k];
+    }
+    x[r] = s / a[r][r];
+  }
+
+  return true;
+}
+
+void clamp(double *theta) {
+  // keep parameters physical
+  theta[0] = std::max(1.0, theta[0]);
+  theta[1] = std::max(0.0, std::min(1023.0, theta[1]));
+  theta[2] = std::max(1.0, theta[2]);
+  theta[3] = std::max(0.0, std::min(1023.0, theta[3]));
+  theta[4] = std::max(1.0, std::min(2000.0, theta[4]));
+}
+
+void fit_sonar(const std::vector<row> &rows, result &res) {
+  // collect readings against cumulative encoder steps
+  std::vector<std::pair<double, double>> points;
+  double steps = 0;
+  for (const auto &r : rows) {
+    steps += r.encoder;
+    if (r.sonar >= 0) {
+      points.emplace_back(steps, r.sonar);
+    }
+  }
+  if (points.size() < 10) {
+    return;
+  }
+
+  // regress readings on steps and drop outliers (e.g. hands below the light) twice
+  std::vector<bool> inlier(points.size(), true);
+  double slope = res.plant.winding_length / encoder_resolution;
+  double rms = 0;
+  size_t count = 0;
+  for (int round = 0; round < 3; round++) {
+    // accumulate sums
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+      if (inlier[i]) {
+        n++;
+        sx += points[i].first;
+        sy += points[i].second;
+        sxx += points[i].first * points[i].first;
+        sxy += points[i].first * points[i].second;
+      }
+    }
+
+    // keep the initial slope if the light did not move
+    double var = sxx - sx * sx / n;
+    if (var > 1) {
+      slope = (sxy - sx * sy / n) / var;
+    }
+    double offset = (sy - slope * sx) / n;
+
+    // calculate residuals and their median absolute deviation
+    std::vector<double> res_abs(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+      res_abs[i] = std::abs(points[i].second - offset - slope * points[i].first);
+    }
+    std::vector<double> sorted;
+    for (size_t i = 0; i < points.size(); i++) {
+      if (inlier[i]) {
+        sorted.push_back(res_abs[i]);
+      }
+    }
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<long>(sorted.size() / 2), sorted.end());
+    double sigma = std::max(0.1, 1.4826 * sorted[sorted.size() / 2]);
+
+    // update inliers and rms
+    double sum = 0;
+    count = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+      inlier[i] = res_abs[i] < 3 * sigma;
+      if (inlier[i]) {
+        sum += res_abs[i] * res_abs[i];
+        count++;
+      }
+    }
+    rms = std::sqrt(sum / static_cast<double>(std::max<size_t>(1, count)));
+  }
+
+  // remove the encoder quantization from the noise (uniform over one step)
+  res.plant.winding_length = slope * encoder_resolution;
+  res.plant.sonar_noise = std::sqrt(std::max(0.0, rms * rms - slope * slope / 12));
+  res.readings = count;
+}
+
+}  // namespace
+
+result fit(const std::vector<row> &rows, const sim::plant &initial) {
+  // prepare result
+  result res;
+  res.plant = initial;
+  if (rows.empty()) {
+    return res;
+  }
+
+  // fit winding length and sonar noise
+  fit_sonar(rows, res);
+  res.radius = res.plant.winding_length / (2 * M_PI);
+  double step = res.plant.winding_length / encoder_resolution;
+
+  // fit motor using levenberg-marquardt
+  std::vector<period> periods = expand(rows);
+  double theta[num_params] = {initial.up_gain, initial.up_offset, initial.down_gain, initial.down_offset,
+                              initial.inertia};
+  double jtj[num_params][num_params];
+  double jtr[num_params];
+  double cost = pass(periods, step, theta, true, jtj, jtr, res.windows);
+  double lambda = 1e-3;
+  while (res.windows > 0 && res.iterations < max_iterations) {
+    res.iterations++;
+
+    // solve damped normal equations
+    double a[num_params][num_params];
+    double b[num_params];
+    for (int i = 0; i < num_params; i++) {
+      for (int j = 0; j < num_params; j++) {
+        a[i][j] = jtj[i][j] + (i == j ? lambda * std::max(jtj[i][i], 1e-12) : 0);
+      }
+      b[i] = -jtr[i];
+    }
+    double delta[num_params];
+    if (!solve(a, b, delta)) {
+      break;
+    }
+
+    // evaluate candidate
+    double candidate[num_params];
+    for (int i = 0; i < num_params; i++) {
+      candidate[i] = theta[i] + delta[i];
+    }
+    clamp(candidate);
+    size_t windows = 0;
+    double next = pass(periods, step, candidate, false, jtj, jtr, windows);
+
+    // accept improvements and relax damping or increase damping
+    if (next < cost) {
+      bool done = (cost - next) < tolerance * cost;
+      std::copy(candidate, candidate + num_params, theta);
+      cost = pass(periods, step, theta, true, jtj, jtr, res.windows);
+      lambda = std::max(1e-12, lambda / 10);
+      if (done) {
+        break;
+      }
+    } else {
+      lambda *= 10;
+      if (lambda > 1e12) {
+        break;
+      }
+    }
+  }
+
+  // store motor parameters
+  if (res.windows > 0) {
+    res.plant.up_gain = theta[0];
+    res.plant.up_offset = theta[1];
+    res.plant.down_gain = theta[2];
+    res.plant.down_offset = theta[3];
+    res.plant.inertia = theta[4];
+    res.rms = std::sqrt(cost / static_cast<double>(res.windows));
+  }
+
+  return res;
+}
+
+}  // namespace ident
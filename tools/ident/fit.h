@@ -0,0 +1,57 @@
+#ifndef IDENT_FIT_H
+#define IDENT_FIT_H
+
+#include <cstddef>
+#include <vector>
+
+#include "sim/plant.h"
+#include "trace.h"
+
+namespace ident {
+
+/**
+ * The result of a fit.
+ */
+struct result {
+  /**
+   * The fitted plant. Values that cannot be identified from a trace (e.g. pir-noise or the motor parameters of a
+   * light that never moved) keep their initial values.
+   */
+  sim::plant plant;
+
+  /**
+   * The spool radius in cm derived from the winding length.
+   */
+  double radius = 0;
+
+  /**
+   * The RMS of the motor residuals in cm per 100 ms window.
+   */
+  double rms = 0;
+
+  /**
+   * The number of motor windows and sonar readings used.
+   */
+  size_t windows = 0;
+  size_t readings = 0;
+
+  /**
+   * The number of Levenberg-Marquardt iterations.
+   */
+  int iterations = 0;
+};
+
+/**
+ * Fit a plant to a trace. The winding length and sonar noise are fitted by a robust linear regression of sonar
+ * readings against encoder steps. The motor gains, dead band offsets and winch inertia are then fitted by
+ * Levenberg-Marquardt on the displacement per 100 ms window while the motor is driven and coasting.
+ *
+ * @param rows The trace.
+ * @param initial The initial plant.
+ * @return The result.
+ */
+result fit(const std::vector<row> &rows, const sim::plant &initial);
+
+}  // namespace ident
+
+#endif  // IDENT_FIT_H
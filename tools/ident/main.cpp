@@ -0,0 +1,211 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ident/fit.h"
+#include "sim/pool.h"
+
+namespace {
+
+struct options {
+  std::vector<std::string> traces;
+  std::string out = ".";
+  std::string synth;
+  size_t lights = 24;
+  double hours = 1;
+  unsigned threads = 0;
+  uint64_t seed = 1;
+  bool bench = false;
+};
+
+void usage() {
+  fprintf(stderr,
+          "usage: ident [--out DIR] [--threads N] TRACE...\n"
+          "       ident --synth DIR [--lights N] [--hours H] [--seed S] [--threads N]\n"
+          "       ident --bench [--lights N] [--hours H] [--threads N]\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags and traces
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--bench") {
+      o.bench = true;
+      o.hours = 24;
+      continue;
+    }
+    if (flag.rfind("--", 0) != 0) {
+      o.traces.push_back(flag);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--out") {
+      o.out = value;
+    } else if (flag == "--synth") {
+      o.synth = value;
+    } else if (flag == "--lights") {
+      o.lights = strtoul(value, nullptr, 10);
+    } else if (flag == "--hours") {
+      o.hours = atof(value);
+    } else if (flag == "--threads") {
+      o.threads = static_cast<unsigned>(atoi(value));
+    } else if (flag == "--seed") {
+      o.seed = strtoull(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+
+  return o.bench || !o.synth.empty() || !o.traces.empty();
+}
+
+std::string name(const std::string &path) {
+  // strip directory and extension
+  size_t slash = path.find_last_of('/');
+  std::string base = slash == std::string::npos ? path : path.substr(slash + 1);
+  return base.substr(0, base.find_last_of('.'));
+}
+
+sim::plant perturb(uint64_t seed) {
+  // vary the plant around the firmware model
+  std::mt19937_64 random(seed);
+  std::uniform_real_distribution<double> unit(0, 1);
+  sim::plant p;
+  p.up_gain *= 0.8 + 0.4 * unit(random);
+  p.up_offset *= 0.8 + 0.4 * unit(random);
+  p.down_gain *= 0.8 + 0.4 * unit(random);
+  p.down_offset *= 0.8 + 0.4 * unit(random);
+  p.inertia = 30 + 120 * unit(random);
+  p.winding_length = 6.5 + 2 * unit(random);
+  p.sonar_noise = 0.5 + 1.5 * unit(random);
+  return p;
+}
+
+std::vector<std::vector<ident::row>> synthesize(const options &o, std::vector<sim::plant> &plants) {
+  // record traces of randomized lights in parallel
+  std::vector<std::vector<ident::row>> traces(o.lights);
+  plants.resize(o.lights);
+  auto duration = static_cast<uint64_t>(o.hours * 3600000);
+  sim::parallel_for(o.lights, sim::threads(o.threads), [&](size_t i) {
+    plants[i] = perturb(o.seed * 1000 + i);
+    traces[i] = ident::record(sim::config(), plants[i], sim::behavior(), o.seed * 1000 + i, duration);
+  });
+
+  return traces;
+}
+
+void print(const std::string &label, const ident::result &r) {
+  printf("%s: up=%.2f/%.1f down=%.2f/%.1f inertia=%.1fms radius=%.3fcm sonar-noise=%.2fcm rms=%.3fcm windows=%zu "
+         "readings=%zu iterations=%d\n",
+         label.c_str(), r.plant.up_gain, r.plant.up_offset, r.plant.down_gain, r.plant.down_offset, r.plant.inertia,
+         r.radius, r.plant.sonar_noise, r.rms, r.windows, r.readings, r.iterations);
+}
+
+int bench(const options &o) {
+  // synthesize data
+  auto start = std::chrono::steady_clock::now();
+  std::vector<sim::plant> plants;
+  auto traces = synthesize(o, plants);
+  double generated = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  size_t rows = 0;
+  for (const auto &t : traces) {
+    rows += t.size();
+  }
+  printf("synthesized lights=%zu hours=%.1f rows=%zu seconds=%.2f\n", o.lights, o.hours, rows, generated);
+
+  // fit all lights single and multi threaded
+  unsigned workers = sim::threads(o.threads);
+  std::vector<ident::result> results(o.lights);
+  for (unsigned n : {1u, workers}) {
+    start = std::chrono::steady_clock::now();
+    sim::parallel_for(o.lights, n, [&](size_t i) { results[i] = ident::fit(traces[i], sim::plant()); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("threads=%u seconds=%.2f rows/s=%.3g\n", n, seconds, static_cast<double>(rows) / seconds);
+    if (n == workers) {
+      break;
+    }
+  }
+
+  // report the mean relative errors against the true plants
+  double errors[7] = {0};
+  for (size_t i = 0; i < o.lights; i++) {
+    const sim::plant &t = plants[i];
+    const sim::plant &f = results[i].plant;
+    errors[0] += std::abs(f.up_gain / t.up_gain - 1);
+    errors[1] += std::abs(f.up_offset / t.up_offset - 1);
+    errors[2] += std::abs(f.down_gain / t.down_gain - 1);
+    errors[3] += std::abs(f.down_offset / t.down_offset - 1);
+    errors[4] += std::abs(f.inertia / t.inertia - 1);
+    errors[5] += std::abs(f.winding_length / t.winding_length - 1);
+    errors[6] += std::abs(f.sonar_noise / t.sonar_noise - 1);
+  }
+  double n = static_cast<double>(o.lights);
+  printf("errors up-gain=%.2f%% up-offset=%.2f%% down-gain=%.2f%% down-offset=%.2f%% inertia=%.2f%% "
+         "winding-length=%.2f%% sonar-noise=%.2f%%\n",
+         errors[0] / n * 100, errors[1] / n * 100, errors[2] / n * 100, errors[3] / n * 100, errors[4] / n * 100,
+         errors[5] / n * 100, errors[6] / n * 100);
+
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // run benchmark
+  if (o.bench) {
+    return bench(o);
+  }
+
+  // synthesize traces with their true models
+  if (!o.synth.empty()) {
+    std::vector<sim::plant> plants;
+    auto traces = synthesize(o, plants);
+    for (size_t i = 0; i < o.lights; i++) {
+      std::string base = o.synth + "/light" + std::to_string(i + 1);
+      if (!ident::write(base + ".csv", traces[i]) || !sim::save(base + ".true", plants[i])) {
+        fprintf(stderr, "ident: failed to write %s\n", base.c_str());
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  // fit traces in parallel and write a model file per light
+  std::vector<ident::result> results(o.traces.size());
+  std::vector<char> ok(o.traces.size());
+  sim::parallel_for(o.traces.size(), sim::threads(o.threads), [&](size_t i) {
+    std::vector<ident::row> rows;
+    if (!ident::read(o.traces[i], rows)) {
+      return;
+    }
+    results[i] = ident::fit(rows, sim::plant());
+    ok[i] = sim::save(o.out + "/" + name(o.traces[i]) + ".model", results[i].plant);
+  });
+
+  // report results
+  int status = 0;
+  for (size_t i = 0; i < o.traces.size(); i++) {
+    if (!ok[i]) {
+      fprintf(stderr, "ident: failed to process %s\n", o.traces[i].c_str());
+      status = 1;
+      continue;
+    }
+    print(name(o.traces[i]), results[i]);
+  }
+
+  return status;
+}
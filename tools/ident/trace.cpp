@@ -0,0 +1,115 @@
+#include "trace.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace ident {
+
+namespace {
+
+// the firmware sonar range
+const double sonar_min = 1;
+const double sonar_max = 300;
+
+// the encoder steps per spool rotation
+const int encoder_resolution = 20;
+
+}  // namespace
+
+bool read(const std::string &path, std::vector<row> &rows) {
+  // open file
+  FILE *f = fopen(path.c_str(), "r");
+  if (f == nullptr) {
+    return false;
+  }
+
+  // read lines and skip header
+  char line[128];
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    // parse columns
+    char *p = line;
+    char *end = nullptr;
+    row r{};
+    r.time = static_cast<uint32_t>(strtoul(p, &end, 10));
+    if (end == p || *end != ',') {
+      continue;
+    }
+    p = end + 1;
+    r.duty = static_cast<int16_t>(strtol(p, &end, 10));
+    if (*end != ',') {
+      continue;
+    }
+    p = end + 1;
+    r.encoder = static_cast<int16_t>(strtol(p, &end, 10));
+    if (*end != ',') {
+      continue;
+    }
+    p = end + 1;
+    r.sonar = strtof(p, &end);
+    if (end == p) {
+      r.sonar = -1;
+    }
+    rows.push_back(r);
+  }
+
+  // close file
+  fclose(f);
+
+  return true;
+}
+
+bool write(const std::string &path, const std::vector<row> &rows) {
+  // open file
+  FILE *f = fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    return false;
+  }
+
+  // write rows
+  fprintf(f, "time,duty,encoder,sonar\n");
+  for (const auto &r : rows) {
+    if (r.sonar >= 0) {
+      fprintf(f, "%u,%d,%d,%.1f\n", r.time, r.duty, r.encoder, r.sonar);
+    } else {
+      fprintf(f, "%u,%d,%d,\n", r.time, r.duty, r.encoder);
+    }
+  }
+
+  return fclose(f) == 0;
+}
+
+std::vector<row> record(const sim::config &c, const sim::plant &p, const sim::behavior &b, uint64_t seed,
+                        uint64_t duration) {
+  // prepare light and scenario
+  sim::light l(c, p, seed * 0x9e3779b97f4a7c15ull + 1);
+  sim::scenario s(b, seed);
+
+  // run simulation and record a row per tick if something changed
+  std::vector<row> rows;
+  double step = p.winding_length / encoder_resolution;
+  double last = l.position();
+  int duty = 0;
+  for (uint64_t t = 1; t <= duration; t++) {
+    // step light
+    l.step(s.step());
+    if (t % tick != 0) {
+      continue;
+    }
+
+    // read encoder, duty and sonar
+    auto steps = static_cast<int>(std::lround((l.position() - last) / step));
+    last += steps * step;
+    bool sampled = t % sim::sensor_interval == 0 && l.reading() >= sonar_min && l.reading() <= sonar_max;
+    if (steps == 0 && l.duty() == duty && !sampled) {
+      continue;
+    }
+    duty = l.duty();
+    rows.push_back({static_cast<uint32_t>(t), static_cast<int16_t>(duty), static_cast<int16_t>(steps),
+                    sampled ? static_cast<float>(l.reading()) : -1.0f});
+  }
+
+  return rows;
+}
+
+}  // namespace ident
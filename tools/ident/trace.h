@@ -0,0 +1,76 @@
+#ifndef IDENT_TRACE_H
+#define IDENT_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sim/visitor.h"
+
+namespace ident {
+
+/**
+ * The interval of the trace grid in ms.
+ */
+const uint32_t tick = 10;
+
+/**
+ * A trace row. Rows are on a 10 ms grid and are only present if something changed: ticks without a row keep the
+ * previous duty, have no encoder steps and no sonar reading.
+ */
+struct row {
+  /**
+   * The time in ms.
+   */
+  uint32_t time;
+
+  /**
+   * The signed 12 bit duty as set by mot_set at the end of the tick (positive when moving up).
+   */
+  int16_t duty;
+
+  /**
+   * The encoder steps during the tick (20 per spool rotation).
+   */
+  int16_t encoder;
+
+  /**
+   * The raw sonar distance in cm or a negative value if there was no reading.
+   */
+  float sonar;
+};
+
+/**
+ * Read a trace from a CSV file with a "time,duty,encoder,sonar" header. An empty sonar column means no reading.
+ *
+ * @param path The path.
+ * @param rows The rows.
+ * @return Whether the file could be read.
+ */
+bool read(const std::string &path, std::vector<row> &rows);
+
+/**
+ * Write a trace to a CSV file.
+ *
+ * @param path The path.
+ * @param rows The rows.
+ * @return Whether the file could be written.
+ */
+bool write(const std::string &path, const std::vector<row> &rows);
+
+/**
+ * Record a trace of a simulated light against a visitor scenario.
+ *
+ * @param c The firmware configuration.
+ * @param p The plant.
+ * @param b The visitor behavior.
+ * @param seed The seed.
+ * @param duration The duration in ms.
+ * @return The rows.
+ */
+std::vector<row> record(const sim::config &c, const sim::plant &p, const sim::behavior &b, uint64_t seed,
+                        uint64_t duration);
+
+}  // namespace ident
+
+#endif  // IDENT_TRACE_H
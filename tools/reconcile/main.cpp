@@ -0,0 +1,186 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/lights.h"
+#include "client/mqtt.h"
+#include "reconcile/reconciler.h"
+
+namespace {
+
+struct options {
+  client::options mqtt;
+  reconcile::options reconcile;
+  std::vector<std::string> schemas;
+  std::string desired;
+  bool once = false;
+};
+
+std::atomic<bool> interrupted{false};
+
+void usage() {
+  fprintf(stderr,
+          "usage: reconcile [--host H] [--port P] [--username U] [--password P] [--prefix P] --schema FILE...\n"
+          "                 [--concurrency N] [--timeout MS] [--backoff MS] [--once] DESIRED\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags and the desired state file
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag.rfind("--", 0) != 0) {
+      o.desired = flag;
+      continue;
+    }
+    if (flag == "--once") {
+      o.once = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--host") {
+      o.mqtt.host = value;
+    } else if (flag == "--port") {
+      o.mqtt.port = atoi(value);
+    } else if (flag == "--username") {
+      o.mqtt.username = value;
+    } else if (flag == "--password") {
+      o.mqtt.password = value;
+    } else if (flag == "--prefix") {
+      o.reconcile.prefix = value;
+    } else if (flag == "--schema") {
+      o.schemas.emplace_back(value);
+    } else if (flag == "--concurrency") {
+      o.reconcile.concurrency = atoi(value);
+    } else if (flag == "--timeout") {
+      o.reconcile.timeout = strtoull(value, nullptr, 10);
+    } else if (flag == "--backoff") {
+      o.reconcile.backoff = strtoull(value, nullptr, 10);
+    } else {
+      return false;
+    }
+  }
+
+  return !o.schemas.empty() && !o.desired.empty();
+}
+
+bool desire(reconcile::reconciler &r, const std::string &path, std::string &error) {
+  // read file
+  std::ifstream in(path);
+  if (!in) {
+    error = "failed to read " + path;
+    return false;
+  }
+
+  // read "<ids> <name>=<value>..." lines
+  std::string line;
+  int number = 0;
+  while (std::getline(in, line)) {
+    number++;
+    std::stringstream ls(line);
+    std::string list;
+    if (!(ls >> list) || list[0] == '#') {
+      continue;
+    }
+    std::vector<int> ids;
+    if (list != "all" && !client::parse(list, 0, ids)) {
+      error = "line " + std::to_string(number) + ": invalid devices " + list;
+      return false;
+    }
+    std::string pair;
+    while (ls >> pair) {
+      size_t eq = pair.find('=');
+      if (eq == std::string::npos || !r.want(ids, pair.substr(0, eq), pair.substr(eq + 1), error)) {
+        error = "line " + std::to_string(number) + ": " + (eq == std::string::npos ? "invalid pair " + pair : error);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+std::string format(const reconcile::counters &c) {
+  // format devices per status and messages
+  std::string s;
+  for (int i = 0; i < 6; i++) {
+    s += std::string(i > 0 ? " " : "") + reconcile::name(static_cast<reconcile::status>(i)) + "=" +
+         std::to_string(c.devices[i]);
+  }
+  s += " messages=" + std::to_string(c.messages) + " resyncs=" + std::to_string(c.resyncs) +
+       " retries=" + std::to_string(c.retries);
+
+  return s;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // load schemas
+  std::vector<reconcile::schema> schemas;
+  for (const auto &path : o.schemas) {
+    reconcile::schema s;
+    std::string error;
+    if (!reconcile::load(path, s, error)) {
+      fprintf(stderr, "reconcile: invalid schema %s: %s\n", path.c_str(), error.c_str());
+      return 1;
+    }
+    schemas.push_back(s);
+  }
+
+  // connect
+  client::mqtt transport(o.mqtt);
+  std::string error;
+  if (!transport.connect(error)) {
+    fprintf(stderr, "reconcile: failed to connect to %s:%d: %s\n", o.mqtt.host.c_str(), o.mqtt.port, error.c_str());
+    return 1;
+  }
+
+  // load desired state
+  reconcile::reconciler r(transport, schemas, o.reconcile);
+  if (!desire(r, o.desired, error)) {
+    fprintf(stderr, "reconcile: invalid desired state: %s\n", error.c_str());
+    return 1;
+  }
+
+  // reconcile every 100 ms and print changes until interrupted or converged
+  signal(SIGINT, [](int) { interrupted = true; });
+  auto start = std::chrono::steady_clock::now();
+  std::string last;
+  while (!interrupted && transport.connected()) {
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    r.step(static_cast<uint64_t>(now.count()));
+    reconcile::counters c = r.count();
+    std::string line = format(c);
+    if (line != last) {
+      printf("%.1fs %s\n", static_cast<double>(now.count()) / 1000, line.c_str());
+      fflush(stdout);
+      last = line;
+    }
+
+    // stop once converged after the retained reports arrived
+    if (o.once && now > std::chrono::seconds(1) && c.reports > 0 && r.converged()) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  transport.close();
+
+  return 0;
+}
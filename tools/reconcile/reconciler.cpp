@@ -0,0 +1,334 @@
+#include "reconciler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "client/telemetry.h"
+
+namespace reconcile {
+
+const char *name(status s) {
+  static const char *names[] = {"unknown", "converged", "pending", "backoff", "outdated", "foreign"};
+  return names[static_cast<int>(s)];
+}
+
+reconciler::reconciler(client::transport &t, std::vector<schema> schemas, options o)
+    : transport_(t), schemas_(std::move(schemas)), options_(std::move(o)) {
+  // subscribe config reports
+  transport_.receive([this](std::string_view topic, std::string_view payload) { receive(topic, payload); });
+  transport_.subscribe(options_.prefix + "/+/config");
+}
+
+reconciler::~reconciler() {
+  // detach handler
+  transport_.receive(nullptr);
+}
+
+bool reconciler::want(const std::vector<int> &ids, const std::string &name, const std::string &value,
+                      std::string &error) {
+  // validate against the first schema with the parameter
+  bool found = false;
+  for (const auto &s : schemas_) {
+    int i = s.index(name);
+    std::string normalized;
+    if (i >= 0 && !found) {
+      found = true;
+      if (!normalize(s.params[static_cast<size_t>(i)], value, normalized)) {
+        error = "invalid value \"" + value + "\" for " + name;
+        return false;
+      }
+    }
+  }
+  if (!found) {
+    error = "unknown parameter " + name;
+    return false;
+  }
+
+  // add desire and mark devices
+  desire d;
+  d.ids = ids;
+  std::sort(d.ids.begin(), d.ids.end());
+  d.name = name;
+  d.value = value;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &e : devices_) {
+    if (d.ids.empty() || std::binary_search(d.ids.begin(), d.ids.end(), e.first)) {
+      e.second.dirty = true;
+    }
+  }
+  desires_.push_back(std::move(d));
+
+  return true;
+}
+
+void reconciler::receive(std::string_view topic, std::string_view payload) {
+  // check topic
+  client::sample s;
+  if (!client::parse(options_.prefix, topic, payload, s) || s.name != "config") {
+    return;
+  }
+
+  // read report
+  client::pairs p(s.payload);
+  std::string_view type;
+  std::string_view version;
+  std::string_view digest;
+  if (!p.get("type", type) || !p.get("digest", digest)) {
+    return;
+  }
+  p.get("version", version);
+
+  // store report
+  std::lock_guard<std::mutex> lock(mutex_);
+  device &d = devices_[s.light];
+  if (d.type != type) {
+    d.type = std::string(type);
+    d.s = nullptr;
+    for (const auto &sc : schemas_) {
+      if (sc.type == d.type) {
+        d.s = &sc;
+      }
+    }
+    d.dirty = true;
+    d.confirmed.clear();
+    d.base.clear();
+  }
+  d.version = std::string(version);
+  d.reported = static_cast<uint32_t>(strtoul(std::string(digest).c_str(), nullptr, 16));
+  d.report = true;
+  counters_.reports++;
+}
+
+void reconciler::step(uint64_t now) {
+  // evaluate devices and collect diffs
+  std::vector<client::message> batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &e : devices_) {
+      evaluate(e.first, e.second, now, batch);
+    }
+  }
+
+  // publish all diffs as one batch
+  if (!batch.empty()) {
+    transport_.publish(std::move(batch));
+  }
+}
+
+void reconciler::evaluate(int id, device &d, uint64_t now, std::vector<client::message> &batch) {
+  // leave devices without schema or with another firmware alone
+  status next = d.st;
+  if (d.s == nullptr) {
+    next = status::FOREIGN;
+  } else if (!d.s->version.empty() && d.version != d.s->version) {
+    next = status::OUTDATED;
+  }
+  if (next == status::FOREIGN || next == status::OUTDATED) {
+    if (d.st == status::PENDING) {
+      pending_--;
+    }
+    d.st = next;
+    return;
+  }
+
+  // compute desired values from defaults and desires in order
+  if (d.dirty) {
+    d.desired = defaults(*d.s);
+    for (const auto &w : desires_) {
+      int i = d.s->index(w.name);
+      if (i >= 0 && (w.ids.empty() || std::binary_search(w.ids.begin(), w.ids.end(), id))) {
+        std::string value;
+        if (normalize(d.s->params[static_cast<size_t>(i)], w.value, value)) {
+          d.desired[static_cast<size_t>(i)] = value;
+        }
+      }
+    }
+    d.digest = digest(*d.s, d.desired);
+    d.dirty = false;
+  }
+
+  // confirm matching reports
+  if (d.reported == d.digest) {
+    if (d.st == status::PENDING) {
+      pending_--;
+    }
+    d.st = status::CONVERGED;
+    d.confirmed = d.desired;
+    d.base.clear();
+    d.attempts = 0;
+    return;
+  }
+
+  // fail pushes that were answered with another digest or not answered in time
+  if (d.st == status::PENDING) {
+    if (!d.report && now < d.deadline) {
+      return;
+    }
+    pending_--;
+    counters_.retries++;
+    d.attempts++;
+    int shift = std::min(d.attempts - 1, 30);
+    d.st = status::BACKOFF;
+    d.deadline = now + std::min(options_.backoff << shift, options_.max_backoff);
+    return;
+  }
+
+  // wait for backoff and a free slot
+  if ((d.st == status::BACKOFF && now < d.deadline) || pending_ >= options_.concurrency) {
+    return;
+  }
+
+  push(id, d, now, batch);
+}
+
+void reconciler::push(int id, device &d, uint64_t now, std::vector<client::message> &batch) {
+  // find the values the device reported: the confirmed values, the defaults after a reset or the base of a partially
+  // applied diff that is sent again once, otherwise all parameters are pushed
+  std::vector<std::string> values;
+  if (!d.confirmed.empty() && digest(*d.s, d.confirmed) == d.reported) {
+    values = d.confirmed;
+  } else if (digest(*d.s, defaults(*d.s)) == d.reported) {
+    values = defaults(*d.s);
+  } else if (!d.base.empty() && d.attempts == 1) {
+    values = d.base;
+  } else {
+    counters_.resyncs++;
+  }
+
+  // add differing parameters
+  std::string prefix = options_.prefix + "/" + std::to_string(id) + "/naos/set/";
+  for (size_t i = 0; i < d.desired.size(); i++) {
+    if (values.empty() || values[i] != d.desired[i]) {
+      batch.push_back({prefix + d.s->params[i].name, d.desired[i]});
+      counters_.messages++;
+    }
+  }
+
+  // await report
+  d.base = std::move(values);
+  d.st = status::PENDING;
+  d.report = false;
+  d.deadline = now + options_.timeout;
+  pending_++;
+  counters_.pushes++;
+}
+
+status reconciler::get(int id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = devices_.find(id);
+  return it == devices_.end() ? status::UNKNOWN : it->second.st;
+}
+
+counters reconciler::count() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  counters c = counters_;
+  for (const auto &e : devices_) {
+    c.devices[static_cast<int>(e.second.st)]++;
+  }
+
+  return c;
+}
+
+bool reconciler::converged() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &e : devices_) {
+    status s = e.second.st;
+    if (s == status::UNKNOWN || s == status::PENDING || s == status::BACKOFF) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+fleet::fleet(const schema &s, int count, double loss, uint64_t seed, std::string prefix)
+    : schema_(s), prefix_(std::move(prefix)), loss_(loss), random_(seed) {
+  // create devices that report at the first step like a retained report
+  devices_.resize(static_cast<size_t>(count));
+  for (auto &d : devices_) {
+    d.values = defaults(s);
+    d.version = s.version;
+    d.due = true;
+    d.retained = true;
+  }
+}
+
+std::future<void> fleet::publish(std::vector<client::message> batch) {
+  // apply parameter updates
+  std::string set = "naos/set/";
+  for (const auto &m : batch) {
+    client::sample s;
+    if (lost() || !client::parse(prefix_, m.topic, m.payload, s) || s.light < 1 ||
+        static_cast<size_t>(s.light) > devices_.size() || s.name.compare(0, set.size(), set) != 0) {
+      continue;
+    }
+    int i = schema_.index(std::string(s.name.substr(set.size())));
+    device &d = devices_[static_cast<size_t>(s.light - 1)];
+    std::string value;
+    if (i >= 0 && normalize(schema_.params[static_cast<size_t>(i)], m.payload, value)) {
+      d.values[static_cast<size_t>(i)] = value;
+    }
+    updates_++;
+
+    // report 500 ms after the last update
+    d.due = true;
+    d.at = now_ + 500;
+  }
+
+  // complete immediately
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+void fleet::subscribe(const std::string &filter) { filters_.push_back(filter); }
+
+void fleet::receive(client::handler h) { handler_ = std::move(h); }
+
+void fleet::set(int id, const std::string &name, const std::string &value) {
+  // change value and report
+  device &d = devices_[static_cast<size_t>(id - 1)];
+  d.values[static_cast<size_t>(schema_.index(name))] = value;
+  d.due = true;
+  d.at = now_;
+}
+
+void fleet::version(int id, const std::string &v) {
+  // change version and report
+  device &d = devices_[static_cast<size_t>(id - 1)];
+  d.version = v;
+  d.due = true;
+  d.at = now_;
+}
+
+void fleet::step(uint64_t now) {
+  // publish due reports
+  now_ = now;
+  char payload[128];
+  for (size_t i = 0; i < devices_.size(); i++) {
+    device &d = devices_[i];
+    if (!d.due || d.at > now) {
+      continue;
+    }
+    d.due = false;
+    if (!d.retained && lost()) {
+      continue;
+    }
+    d.retained = false;
+    std::string topic = prefix_ + "/" + std::to_string(i + 1) + "/config";
+    snprintf(payload, sizeof(payload), "type=%s version=%s params=%zu digest=%08x", schema_.type.c_str(),
+             d.version.c_str(), schema_.params.size(), static_cast<unsigned int>(digest(schema_, d.values)));
+    bool matched = false;
+    for (const auto &f : filters_) {
+      matched = matched || client::match(f, topic);
+    }
+    if (matched && handler_) {
+      handler_(topic, payload);
+    }
+  }
+}
+
+bool fleet::lost() { return loss_ > 0 && std::uniform_real_distribution<double>(0, 1)(random_) < loss_; }
+
+}  // namespace reconcile
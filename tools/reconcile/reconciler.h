@@ -0,0 +1,293 @@
+#ifndef RECONCILE_RECONCILER_H
+#define RECONCILE_RECONCILER_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "client/transport.h"
+#include "schema.h"
+
+namespace reconcile {
+
+/**
+ * The reconciler options.
+ */
+struct options {
+  /**
+   * The topic prefix of the devices.
+   */
+  std::string prefix = "lights";
+
+  /**
+   * The maximum number of devices with a pushed diff that has not been confirmed.
+   */
+  int concurrency = 32;
+
+  /**
+   * The time in ms to wait for the config report after a push. Devices report 500 ms after the last update.
+   */
+  uint64_t timeout = 5000;
+
+  /**
+   * The first retry delay in ms that doubles with every failed attempt up to the maximum.
+   */
+  uint64_t backoff = 1000;
+  uint64_t max_backoff = 60000;
+};
+
+/**
+ * The reconciliation status of a device.
+ */
+enum class status {
+  /**
+   * The device has not reported its configuration or its diff has not been pushed yet.
+   */
+  UNKNOWN,
+
+  /**
+   * The reported digest matches the desired configuration.
+   */
+  CONVERGED,
+
+  /**
+   * A diff has been pushed and the report is pending.
+   */
+  PENDING,
+
+  /**
+   * A push failed and is retried after the backoff.
+   */
+  BACKOFF,
+
+  /**
+   * The device runs another firmware version than the schema expects. Its parameters are left alone.
+   */
+  OUTDATED,
+
+  /**
+   * The device reported a type without schema.
+   */
+  FOREIGN,
+};
+
+/**
+ * Get the name of a status.
+ */
+const char *name(status s);
+
+/**
+ * The counters of a reconciler.
+ */
+struct counters {
+  /**
+   * The number of devices per status.
+   */
+  int devices[6] = {0};
+
+  /**
+   * The published parameter updates, the received reports and the pushed diffs of which were complete resyncs.
+   */
+  uint64_t messages = 0;
+  uint64_t reports = 0;
+  uint64_t pushes = 0;
+  uint64_t resyncs = 0;
+
+  /**
+   * The failed pushes.
+   */
+  uint64_t retries = 0;
+};
+
+/**
+ * Reconciles the parameters of a fleet with a desired configuration. Devices report their type, firmware version and a
+ * digest over all parameter values on the retained "config" topic. The reconciler computes the desired values per
+ * device from the schema defaults and the desired values of the device and its groups, and pushes the parameters that
+ * differ from the last confirmed values (or the defaults after a reset) as one batch of "naos/set" messages. If the
+ * reported digest matches neither, all parameters are pushed. At most a bounded number of devices are updated at once
+ * and failed pushes are retried with exponential backoff.
+ *
+ * The reconciler is driven by calls to step() and is safe to use from the transport thread.
+ */
+class reconciler {
+ public:
+  /**
+   * Create the reconciler and subscribe the config reports.
+   *
+   * @param t The transport.
+   * @param schemas The schemas of the known device types.
+   * @param o The options.
+   */
+  reconciler(client::transport &t, std::vector<schema> schemas, options o = options());
+  ~reconciler();
+
+  reconciler(const reconciler &) = delete;
+  reconciler &operator=(const reconciler &) = delete;
+
+  /**
+   * Set the desired value of a parameter for a group of devices. Later calls override earlier calls for the same
+   * devices and parameter.
+   *
+   * @param ids The devices or an empty list for all devices.
+   * @param name The parameter.
+   * @param value The value.
+   * @param error The error message.
+   * @return Whether the parameter exists in a schema and the value is valid for it.
+   */
+  bool want(const std::vector<int> &ids, const std::string &name, const std::string &value, std::string &error);
+
+  /**
+   * Handle a received message. Called by the transport handler and may be used to feed reports directly.
+   *
+   * @param topic The topic.
+   * @param payload The payload.
+   */
+  void receive(std::string_view topic, std::string_view payload);
+
+  /**
+   * Check timeouts and push diffs.
+   *
+   * @param now The time in ms.
+   */
+  void step(uint64_t now);
+
+  /**
+   * Get the status of a device.
+   *
+   * @param id The device.
+   */
+  status get(int id);
+
+  /**
+   * Get the counters.
+   */
+  counters count();
+
+  /**
+   * Whether all reported devices with a schema and the expected firmware converged.
+   */
+  bool converged();
+
+ private:
+  struct desire {
+    std::vector<int> ids;
+    std::string name;
+    std::string value;
+  };
+
+  struct device {
+    const schema *s = nullptr;
+    std::string type;
+    std::string version;
+    uint32_t reported = 0;
+    bool report = false;
+    status st = status::UNKNOWN;
+
+    // the desired values and digest, recomputed when dirty
+    bool dirty = true;
+    std::vector<std::string> desired;
+    uint32_t digest = 0;
+
+    // the last confirmed values and the base of the pending diff
+    std::vector<std::string> confirmed;
+    std::vector<std::string> base;
+    uint64_t deadline = 0;
+    int attempts = 0;
+  };
+
+  void evaluate(int id, device &d, uint64_t now, std::vector<client::message> &batch);
+  void push(int id, device &d, uint64_t now, std::vector<client::message> &batch);
+
+  client::transport &transport_;
+  std::vector<schema> schemas_;
+  options options_;
+
+  // guarded by the mutex
+  std::mutex mutex_;
+  std::vector<desire> desires_;
+  std::map<int, device> devices_;
+  int pending_ = 0;
+  counters counters_;
+};
+
+/**
+ * A simulated fleet of devices that apply "naos/set" messages and publish a config report 500 ms after the last
+ * update like the firmware. Messages in both directions may be lost except for the retained reports delivered at the
+ * first step. It is used by the tests and the benchmark.
+ */
+class fleet : public client::transport {
+ public:
+  /**
+   * Create devices 1 to count with default values.
+   *
+   * @param s The schema.
+   * @param count The number of devices.
+   * @param loss The probability that a message is lost.
+   * @param seed The random seed.
+   * @param prefix The topic prefix.
+   */
+  fleet(const schema &s, int count, double loss = 0, uint64_t seed = 1, std::string prefix = "lights");
+
+  std::future<void> publish(std::vector<client::message> batch) override;
+  void subscribe(const std::string &filter) override;
+  void receive(client::handler h) override;
+
+  /**
+   * Set a value directly on a device (e.g. to emulate a reset or manual change) and report it at the next step.
+   *
+   * @param id The device.
+   * @param name The parameter.
+   * @param value The normalized value.
+   */
+  void set(int id, const std::string &name, const std::string &value);
+
+  /**
+   * Set the firmware version of a device.
+   */
+  void version(int id, const std::string &v);
+
+  /**
+   * Publish due reports.
+   *
+   * @param now The time in ms.
+   */
+  void step(uint64_t now);
+
+  /**
+   * Get the values of a device.
+   */
+  const std::vector<std::string> &values(int id) const { return devices_[static_cast<size_t>(id - 1)].values; }
+
+  /**
+   * The number of received updates.
+   */
+  uint64_t updates() const { return updates_; }
+
+ private:
+  struct device {
+    std::vector<std::string> values;
+    std::string version;
+    bool due = false;
+    bool retained = false;
+    uint64_t at = 0;
+  };
+
+  bool lost();
+
+  const schema &schema_;
+  std::string prefix_;
+  double loss_;
+  std::mt19937_64 random_;
+  uint64_t now_ = 0;
+  uint64_t updates_ = 0;
+  std::vector<device> devices_;
+  std::vector<std::string> filters_;
+  client::handler handler_;
+};
+
+}  // namespace reconcile
+
+#endif  // RECONCILE_RECONCILER_H
@@ -0,0 +1,161 @@
+#include "schema.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace reconcile {
+
+int schema::index(const std::string &name) const {
+  for (size_t i = 0; i < params.size(); i++) {
+    if (params[i].name == name) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return -1;
+}
+
+bool parse(const std::string &text, schema &s, std::string &error) {
+  // read lines
+  s = schema();
+  std::stringstream in(text);
+  std::string line;
+  int number = 0;
+  while (std::getline(in, line)) {
+    number++;
+
+    // skip empty lines and comments
+    std::stringstream ls(line);
+    std::string key;
+    if (!(ls >> key) || key[0] == '#') {
+      continue;
+    }
+
+    // read type and version
+    if (key == "type" || key == "version") {
+      std::string value;
+      ls >> value;
+      (key == "type" ? s.type : s.version) = value;
+      continue;
+    }
+
+    // read parameter, string defaults may be empty
+    param p;
+    p.name = key;
+    std::string type;
+    std::string value;
+    ls >> type;
+    ls >> value;
+    if (type == "bool") {
+      p.type = kind::BOOL;
+    } else if (type == "long") {
+      p.type = kind::LONG;
+    } else if (type == "double") {
+      p.type = kind::DOUBLE;
+    } else if (type == "string") {
+      p.type = kind::STRING;
+    } else {
+      error = "line " + std::to_string(number) + ": invalid type \"" + type + "\"";
+      return false;
+    }
+    if (!normalize(p, value, p.value)) {
+      error = "line " + std::to_string(number) + ": invalid default \"" + value + "\"";
+      return false;
+    }
+    s.params.push_back(p);
+  }
+
+  // check type
+  if (s.type.empty()) {
+    error = "missing type";
+    return false;
+  }
+
+  return true;
+}
+
+bool load(const std::string &path, schema &s, std::string &error) {
+  // read file
+  std::ifstream in(path);
+  if (!in) {
+    error = "failed to read " + path;
+    return false;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+
+  return parse(ss.str(), s, error);
+}
+
+bool normalize(const param &p, const std::string &value, std::string &out) {
+  // format like the firmware
+  char buf[32];
+  char *end = nullptr;
+  switch (p.type) {
+    case kind::BOOL:
+      if (value == "1" || value == "true") {
+        out = "1";
+      } else if (value == "0" || value == "false") {
+        out = "0";
+      } else {
+        return false;
+      }
+      return true;
+    case kind::LONG: {
+      long l = strtol(value.c_str(), &end, 10);
+      if (value.empty() || *end != 0) {
+        return false;
+      }
+      out = std::to_string(static_cast<int>(l));
+      return true;
+    }
+    case kind::DOUBLE: {
+      double d = strtod(value.c_str(), &end);
+      if (value.empty() || *end != 0 || !std::isfinite(d)) {
+        return false;
+      }
+      snprintf(buf, sizeof(buf), "%.6g", d);
+      out = buf;
+      return true;
+    }
+    case kind::STRING:
+      out = value.substr(0, 31);
+      return true;
+  }
+
+  return false;
+}
+
+std::vector<std::string> defaults(const schema &s) {
+  std::vector<std::string> values;
+  values.reserve(s.params.size());
+  for (const auto &p : s.params) {
+    values.push_back(p.value);
+  }
+
+  return values;
+}
+
+uint32_t digest(const schema &s, const std::vector<std::string> &values) {
+  // hash "name=value;" of all parameters
+  uint32_t h = 2166136261u;
+  auto add = [&h](const std::string &str) {
+    for (char c : str) {
+      h ^= static_cast<uint8_t>(c);
+      h *= 16777619u;
+    }
+  };
+  for (size_t i = 0; i < s.params.size(); i++) {
+    add(s.params[i].name);
+    add("=");
+    add(values[i]);
+    add(";");
+  }
+
+  return h;
+}
+
+}  // namespace reconcile
@@ -0,0 +1,104 @@
+#ifndef RECONCILE_SCHEMA_H
+#define RECONCILE_SCHEMA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reconcile {
+
+/**
+ * The naos parameter types.
+ */
+enum class kind { BOOL, LONG, DOUBLE, STRING };
+
+/**
+ * A parameter with its default value formatted like the firmware.
+ */
+struct param {
+  std::string name;
+  kind type = kind::STRING;
+  std::string value;
+};
+
+/**
+ * The parameters of a device type in the order of the firmware parameter table.
+ */
+struct schema {
+  /**
+   * The device type (e.g. "tm-lo").
+   */
+  std::string type;
+
+  /**
+   * The expected firmware version or empty to accept all versions.
+   */
+  std::string version;
+
+  /**
+   * The parameters.
+   */
+  std::vector<param> params;
+
+  /**
+   * Find a parameter.
+   *
+   * @param name The name.
+   * @return The index or -1.
+   */
+  int index(const std::string &name) const;
+};
+
+/**
+ * Parse a schema with a "type <type>" line, an optional "version <version>" line and a "<name> <bool|long|double|
+ * string> <default>" line per parameter. Empty lines and lines starting with "#" are ignored.
+ *
+ * @param text The text.
+ * @param s The schema.
+ * @param error The error message.
+ * @return Whether the schema is valid.
+ */
+bool parse(const std::string &text, schema &s, std::string &error);
+
+/**
+ * Load a schema from a file.
+ *
+ * @param path The path.
+ * @param s The schema.
+ * @param error The error message.
+ * @return Whether the schema has been loaded.
+ */
+bool load(const std::string &path, schema &s, std::string &error);
+
+/**
+ * Format a value like the firmware formats the parameter for the digest: booleans as "0" or "1", integers as
+ * decimals, doubles with "%.6g" and strings cut to 31 bytes.
+ *
+ * @param p The parameter.
+ * @param value The value.
+ * @param out The formatted value.
+ * @return Whether the value is valid for the parameter type.
+ */
+bool normalize(const param &p, const std::string &value, std::string &out);
+
+/**
+ * Get the default values of a schema.
+ *
+ * @param s The schema.
+ * @return The values in parameter order.
+ */
+std::vector<std::string> defaults(const schema &s);
+
+/**
+ * Calculate the configuration digest of the firmware "config" report: the FNV-1a hash of "name=value;" for all
+ * parameters in order.
+ *
+ * @param s The schema.
+ * @param values The normalized values in parameter order.
+ * @return The digest.
+ */
+uint32_t digest(const schema &s, const std::vector<std::string> &values);
+
+}  // namespace reconcile
+
+#endif  // RECONCILE_SCHEMA_H
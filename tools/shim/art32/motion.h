@@ -0,0 +1,33 @@
+#ifndef A32_MOTION_H
+#define A32_MOTION_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Host stand-in for the art32 trapezoidal motion profile: accelerate towards the target and decelerate once the
+// remaining distance is within the stopping distance.
+
+typedef struct {
+  double max_velocity;
+  double max_acceleration;
+  double position;
+  double velocity;
+} a32_motion_t;
+
+static inline void a32_motion_update(a32_motion_t *m, double target, uint32_t time) {
+  // accelerate or decelerate for the interval
+  double remaining = target - m->position;
+  double stopping = m->velocity * m->velocity / (2 * m->max_acceleration);
+  double step = m->max_acceleration * time;
+  if (m->velocity * remaining > 0 && fabs(remaining) <= stopping) {
+    m->velocity -= copysign(step, m->velocity);
+  } else {
+    m->velocity += copysign(step, remaining);
+  }
+
+  // limit velocity and advance position
+  m->velocity = fmax(-m->max_velocity, fmin(m->max_velocity, m->velocity));
+  m->position += m->velocity * time;
+}
+
+#endif  // A32_MOTION_H
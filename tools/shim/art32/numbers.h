@@ -0,0 +1,26 @@
+#ifndef A32_NUMBERS_H
+#define A32_NUMBERS_H
+
+// Host stand-ins for the art32 number helpers used by the firmware modules that are compiled into the tools. They
+// follow the semantics of the art32 library that the firmware links on the device.
+
+static inline int a32_constrain_i(int num, int min, int max) {
+  return num < min ? min : (num > max ? max : num);
+}
+
+static inline double a32_constrain_d(double num, double min, double max) {
+  return num < min ? min : (num > max ? max : num);
+}
+
+static inline int a32_map_i(int num, int in_min, int in_max, int out_min, int out_max) {
+  return (num - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+static inline int a32_safe_map_i(int num, int in_min, int in_max, int out_min, int out_max) {
+  if (in_min == in_max) {
+    return out_min;
+  }
+  return a32_map_i(a32_constrain_i(num, in_min, in_max), in_min, in_max, out_min, out_max);
+}
+
+#endif  // A32_NUMBERS_H
@@ -0,0 +1,44 @@
+#ifndef A32_SMOOTH_H
+#define A32_SMOOTH_H
+
+#include <stdlib.h>
+
+// Host stand-in for the art32 moving average over the last values.
+
+typedef struct {
+  size_t num;
+  size_t index;
+  size_t count;
+  double *values;
+} a32_smooth_t;
+
+static inline a32_smooth_t *a32_smooth_new(size_t num) {
+  a32_smooth_t *s = calloc(1, sizeof(a32_smooth_t));
+  s->num = num;
+  s->values = calloc(num, sizeof(double));
+  return s;
+}
+
+static inline double a32_smooth_update(a32_smooth_t *s, double value) {
+  // store value
+  s->values[s->index] = value;
+  s->index = (s->index + 1) % s->num;
+  if (s->count < s->num) {
+    s->count++;
+  }
+
+  // average stored values
+  double total = 0;
+  for (size_t i = 0; i < s->count; i++) {
+    total += s->values[i];
+  }
+
+  return total / (double)s->count;
+}
+
+static inline void a32_smooth_free(a32_smooth_t *s) {
+  free(s->values);
+  free(s);
+}
+
+#endif  // A32_SMOOTH_H
@@ -0,0 +1,21 @@
+#ifndef DRIVER_ADC_H
+#define DRIVER_ADC_H
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+// Host stand-ins for the ESP-IDF ADC driver. Raw values are provided by the host.
+
+typedef enum { ADC1_CHANNEL_6 = 6 } adc1_channel_t;
+
+typedef enum { ADC_WIDTH_10Bit = 1 } adc_bits_width_t;
+
+typedef enum { ADC_ATTEN_11db = 3 } adc_atten_t;
+
+esp_err_t adc1_config_width(adc_bits_width_t width);
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+
+int adc1_get_raw(adc1_channel_t channel);
+
+#endif  // DRIVER_ADC_H
@@ -0,0 +1,66 @@
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Host stand-ins for the ESP-IDF GPIO driver. Input levels are driven by the host which also raises the interrupts.
+
+typedef enum {
+  GPIO_NUM_13 = 13,
+  GPIO_NUM_14 = 14,
+  GPIO_NUM_16 = 16,
+  GPIO_NUM_17 = 17,
+  GPIO_NUM_21 = 21,
+  GPIO_NUM_22 = 22,
+  GPIO_NUM_23 = 23,
+  GPIO_NUM_25 = 25,
+  GPIO_NUM_26 = 26,
+  GPIO_NUM_27 = 27,
+  GPIO_NUM_32 = 32,
+  GPIO_NUM_33 = 33,
+  GPIO_NUM_MAX = 40,
+} gpio_num_t;
+
+#define GPIO_SEL_13 (1ULL << 13)
+#define GPIO_SEL_14 (1ULL << 14)
+#define GPIO_SEL_16 (1ULL << 16)
+#define GPIO_SEL_22 (1ULL << 22)
+#define GPIO_SEL_23 (1ULL << 23)
+#define GPIO_SEL_25 (1ULL << 25)
+
+typedef enum { GPIO_MODE_INPUT, GPIO_MODE_OUTPUT } gpio_mode_t;
+
+typedef enum { GPIO_PULLUP_DISABLE, GPIO_PULLUP_ENABLE } gpio_pullup_t;
+
+typedef enum { GPIO_PULLDOWN_DISABLE, GPIO_PULLDOWN_ENABLE } gpio_pulldown_t;
+
+typedef enum {
+  GPIO_INTR_DISABLE,
+  GPIO_INTR_POSEDGE,
+  GPIO_INTR_NEGEDGE,
+  GPIO_INTR_ANYEDGE,
+} gpio_int_type_t;
+
+typedef struct {
+  uint64_t pin_bit_mask;
+  gpio_mode_t mode;
+  gpio_pullup_t pull_up_en;
+  gpio_pulldown_t pull_down_en;
+  gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void *arg);
+
+esp_err_t gpio_config(const gpio_config_t *config);
+
+esp_err_t gpio_set_level(gpio_num_t num, uint32_t level);
+
+int gpio_get_level(gpio_num_t num);
+
+esp_err_t gpio_install_isr_service(int flags);
+
+esp_err_t gpio_isr_handler_add(gpio_num_t num, gpio_isr_t handler, void *arg);
+
+#endif  // DRIVER_GPIO_H
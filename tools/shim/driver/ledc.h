@@ -0,0 +1,53 @@
+#ifndef DRIVER_LEDC_H
+#define DRIVER_LEDC_H
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+// Host stand-ins for the ESP-IDF LED PWM driver. Fades complete immediately with their target duty.
+
+typedef enum { LEDC_HIGH_SPEED_MODE } ledc_mode_t;
+
+typedef enum { LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3, LEDC_CHANNEL_4, LEDC_CHANNEL_MAX } ledc_channel_t;
+
+typedef enum { LEDC_TIMER_0, LEDC_TIMER_1 } ledc_timer_t;
+
+typedef enum { LEDC_TIMER_10_BIT = 10, LEDC_TIMER_12_BIT = 12 } ledc_timer_bit_t;
+
+typedef enum { LEDC_INTR_DISABLE, LEDC_INTR_FADE_END } ledc_intr_type_t;
+
+typedef enum { LEDC_FADE_NO_WAIT, LEDC_FADE_WAIT_DONE } ledc_fade_mode_t;
+
+typedef struct {
+  ledc_mode_t speed_mode;
+  ledc_timer_bit_t duty_resolution;
+  ledc_timer_t timer_num;
+  uint32_t freq_hz;
+} ledc_timer_config_t;
+
+typedef struct {
+  int gpio_num;
+  ledc_mode_t speed_mode;
+  ledc_channel_t channel;
+  ledc_intr_type_t intr_type;
+  ledc_timer_t timer_sel;
+  uint32_t duty;
+} ledc_channel_config_t;
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *config);
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *config);
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty);
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel);
+
+esp_err_t ledc_fade_func_install(int flags);
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty, int time);
+
+esp_err_t ledc_fade_start(ledc_mode_t mode, ledc_channel_t channel, ledc_fade_mode_t wait);
+
+#endif  // DRIVER_LEDC_H
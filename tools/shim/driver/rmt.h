@@ -0,0 +1,52 @@
+#ifndef DRIVER_RMT_H
+#define DRIVER_RMT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+// Host stand-ins for the ESP-IDF RMT driver. Written items are reported to the host as trigger pulses.
+
+typedef enum { RMT_CHANNEL_0 } rmt_channel_t;
+
+typedef enum { RMT_MODE_TX, RMT_MODE_RX } rmt_mode_t;
+
+typedef enum { RMT_IDLE_LEVEL_LOW, RMT_IDLE_LEVEL_HIGH } rmt_idle_level_t;
+
+typedef enum { RMT_CARRIER_LEVEL_LOW, RMT_CARRIER_LEVEL_HIGH } rmt_carrier_level_t;
+
+typedef struct {
+  uint32_t duration0 : 15;
+  uint32_t level0 : 1;
+  uint32_t duration1 : 15;
+  uint32_t level1 : 1;
+} rmt_item32_t;
+
+typedef struct {
+  bool loop_en;
+  uint32_t carrier_freq_hz;
+  uint8_t carrier_duty_percent;
+  rmt_carrier_level_t carrier_level;
+  bool carrier_en;
+  rmt_idle_level_t idle_level;
+  bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct {
+  rmt_mode_t rmt_mode;
+  rmt_channel_t channel;
+  uint8_t clk_div;
+  gpio_num_t gpio_num;
+  uint8_t mem_block_num;
+  rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+esp_err_t rmt_config(const rmt_config_t *config);
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int flags);
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t *items, int num, bool wait);
+
+#endif  // DRIVER_RMT_H
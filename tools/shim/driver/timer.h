@@ -0,0 +1,39 @@
+#ifndef DRIVER_TIMER_H
+#define DRIVER_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Host stand-ins for the ESP-IDF general purpose timers. Counters run on the simulated clock (1 count = 1us at a
+// divider of 80).
+
+typedef enum { TIMER_GROUP_0 } timer_group_t;
+
+typedef enum { TIMER_0 } timer_idx_t;
+
+typedef enum { TIMER_INTR_LEVEL } timer_intr_mode_t;
+
+typedef enum { TIMER_COUNT_DOWN, TIMER_COUNT_UP } timer_count_dir_t;
+
+typedef struct {
+  bool alarm_en;
+  bool counter_en;
+  timer_intr_mode_t intr_type;
+  timer_count_dir_t counter_dir;
+  bool auto_reload;
+  uint32_t divider;
+} timer_config_t;
+
+esp_err_t timer_init(timer_group_t group, timer_idx_t num, const timer_config_t *config);
+
+esp_err_t timer_start(timer_group_t group, timer_idx_t num);
+
+esp_err_t timer_pause(timer_group_t group, timer_idx_t num);
+
+esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t num, uint64_t value);
+
+esp_err_t timer_get_counter_value(timer_group_t group, timer_idx_t num, uint64_t *value);
+
+#endif  // DRIVER_TIMER_H
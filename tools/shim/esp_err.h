@@ -0,0 +1,24 @@
+#ifndef ESP_ERR_H
+#define ESP_ERR_H
+
+// Host stand-ins for the ESP-IDF error handling. Failed checks abort like on the device.
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+
+const char *esp_err_to_name(esp_err_t code);
+
+void esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *expression);
+
+#define ESP_ERROR_CHECK(x)                                    \
+  do {                                                        \
+    esp_err_t _rc = (x);                                      \
+    if (_rc != ESP_OK) {                                      \
+      esp_error_check_failed(_rc, __FILE__, __LINE__, #x);    \
+    }                                                         \
+  } while (0)
+
+#endif  // ESP_ERR_H
@@ -0,0 +1,32 @@
+#ifndef ESP_NOW_H
+#define ESP_NOW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_wifi.h"
+
+// Host stand-ins for the ESP-NOW driver. Sent packets are counted and received packets are injected by the host.
+
+typedef struct {
+  uint8_t peer_addr[6];
+  uint8_t lmk[16];
+  uint8_t channel;
+  wifi_interface_t ifidx;
+  bool encrypt;
+  void *priv;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t *mac, const uint8_t *data, int len);
+
+esp_err_t esp_now_init();
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb);
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer);
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len);
+
+#endif  // ESP_NOW_H
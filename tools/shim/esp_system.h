@@ -0,0 +1,14 @@
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include <stdint.h>
+
+// Host stand-ins for the ESP-IDF system functions. The heap sizes account the allocations of the firmware modules.
+
+uint32_t esp_get_free_heap_size();
+
+uint32_t esp_get_minimum_free_heap_size();
+
+uint32_t esp_random();
+
+#endif  // ESP_SYSTEM_H
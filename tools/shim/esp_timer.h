@@ -0,0 +1,10 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+// Host stand-in for the ESP-IDF high resolution timer that returns the simulated time in us.
+
+int64_t esp_timer_get_time();
+
+#endif  // ESP_TIMER_H
@@ -0,0 +1,14 @@
+#ifndef ESP_WIFI_H
+#define ESP_WIFI_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Host stand-in for the ESP-IDF wifi driver.
+
+typedef enum { ESP_IF_WIFI_STA = 0, ESP_IF_WIFI_AP } wifi_interface_t;
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+#endif  // ESP_WIFI_H
@@ -0,0 +1,36 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+// Host stand-ins for FreeRTOS. Tasks run as coroutines that the host resumes when they are notified or their wait
+// expires, so critical sections do not need to lock.
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+
+#define portMAX_DELAY ((TickType_t)0xffffffff)
+#define portTICK_PERIOD_MS 1
+
+typedef struct {
+  int locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED \
+  { 0 }
+
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define vTaskEnterCritical(mux) ((void)(mux))
+#define vTaskExitCritical(mux) ((void)(mux))
+
+#include "freertos/task.h"
+
+#endif  // FREERTOS_H
@@ -0,0 +1,21 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct dev_task *TaskHandle_t;
+
+typedef void (*TaskFunction_t)(void *arg);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+#endif  // FREERTOS_TASK_H
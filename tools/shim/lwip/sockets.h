@@ -0,0 +1,12 @@
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+// The lwip socket API matches the host BSD sockets.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif  // LWIP_SOCKETS_H
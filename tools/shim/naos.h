@@ -0,0 +1,65 @@
+#ifndef NAOS_H
+#define NAOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-ins for the naos framework. The host drives the callbacks, owns the parameters and captures publishes.
+
+typedef enum { NAOS_LOCAL, NAOS_GLOBAL } naos_scope_t;
+
+typedef enum { NAOS_STRING, NAOS_BOOL, NAOS_LONG, NAOS_DOUBLE } naos_type_t;
+
+typedef enum { NAOS_DISCONNECTED, NAOS_CONNECTED, NAOS_NETWORKED } naos_status_t;
+
+typedef struct {
+  const char *name;
+  naos_type_t type;
+  const char *default_s;
+  bool default_b;
+  int32_t default_l;
+  double default_d;
+  char **sync_s;
+  bool *sync_b;
+  int32_t *sync_l;
+  double *sync_d;
+} naos_param_t;
+
+typedef struct {
+  const char *device_type;
+  const char *firmware_version;
+  naos_param_t *parameters;
+  size_t num_parameters;
+  void (*ping_callback)();
+  void (*online_callback)();
+  void (*offline_callback)();
+  void (*update_callback)(const char *param, const char *value);
+  void (*message_callback)(const char *topic, uint8_t *payload, size_t len, naos_scope_t scope);
+  void (*loop_callback)();
+  int loop_interval;
+  void (*status_callback)(naos_status_t status);
+  const char *password;
+} naos_config_t;
+
+void naos_init(naos_config_t *config);
+
+void naos_log(const char *fmt, ...);
+
+bool naos_subscribe(const char *topic, int qos, naos_scope_t scope);
+
+bool naos_publish(const char *topic, const char *payload, int qos, bool retained, naos_scope_t scope);
+
+bool naos_publish_r(const char *topic, void *payload, size_t len, int qos, bool retained, naos_scope_t scope);
+
+bool naos_publish_b(const char *topic, bool payload, int qos, bool retained, naos_scope_t scope);
+
+bool naos_publish_l(const char *topic, int32_t payload, int qos, bool retained, naos_scope_t scope);
+
+bool naos_publish_d(const char *topic, double payload, int qos, bool retained, naos_scope_t scope);
+
+uint32_t naos_millis();
+
+void naos_set(const char *param, const char *value);
+
+#endif  // NAOS_H
@@ -0,0 +1,23 @@
+#ifndef NVS_H
+#define NVS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Host stand-ins for the NVS storage that keep blobs in memory and count commits as flash writes.
+
+typedef uint32_t nvs_handle;
+
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode mode, nvs_handle *handle);
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char *key, void *value, size_t *length);
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char *key, const void *value, size_t length);
+
+esp_err_t nvs_commit(nvs_handle handle);
+
+#endif  // NVS_H
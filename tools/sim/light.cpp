@@ -0,0 +1,277 @@
+#include "light.h"
+
+#include <cmath>
+#include <cstdio>
+
+extern "C" {
+#include "mot.h"
+}
+
+namespace sim {
+
+namespace {
+
+// the firmware sensor ranges
+const double sonar_min = 1;
+const double sonar_max = 300;
+const int pir_rest = 590;
+
+// the encoder steps per spool rotation
+const int encoder_resolution = 20;
+
+// the interval in ms at which the firmware creep accumulator decides to pulse
+const int creep_tick = 10;
+
+struct field {
+  const char *name;
+  double config::*d;
+  int config::*i;
+};
+
+const field fields[] = {
+    {"approach-range", &config::approach_range, nullptr},
+    {"approach-target", &config::approach_target, nullptr},
+    {"idle-height", &config::idle_height, nullptr},
+    {"base-height", &config::base_height, nullptr},
+    {"rise-height", &config::rise_height, nullptr},
+    {"pir-low", nullptr, &config::pir_low},
+    {"pir-high", nullptr, &config::pir_high},
+    {"pir-interval", nullptr, &config::pir_interval},
+    {"target-deadband", &config::target_deadband, nullptr},
+    {"target-hysteresis", &config::target_hysteresis, nullptr},
+    {"target-rate", &config::target_rate, nullptr},
+    {"target-dwell", nullptr, &config::target_dwell},
+    {"creep-speed", &config::creep_speed, nullptr},
+    {"mot-up-gain", &config::mot_up_gain, nullptr},
+    {"mot-up-offset", &config::mot_up_offset, nullptr},
+    {"mot-down-gain", &config::mot_down_gain, nullptr},
+    {"mot-down-offset", &config::mot_down_offset, nullptr},
+};
+
+}  // namespace
+
+bool set(config &c, const std::string &name, double value) {
+  // find field
+  for (const auto &f : fields) {
+    if (name == f.name) {
+      if (f.d != nullptr) {
+        c.*f.d = value;
+      } else {
+        c.*f.i = static_cast<int>(std::lround(value));
+      }
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool get(const config &c, const std::string &name, double &value) {
+  // find field
+  for (const auto &f : fields) {
+    if (name == f.name) {
+      value = f.d != nullptr ? c.*f.d : c.*f.i;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string profile(const config &c, const std::vector<std::string> &names) {
+  // format pairs in the given order
+  std::string out;
+  for (const auto &name : names) {
+    for (const auto &f : fields) {
+      if (name != f.name) {
+        continue;
+      }
+      char pair[64];
+      if (f.d != nullptr) {
+        snprintf(pair, sizeof(pair), "%s=%.1f", f.name, c.*f.d);
+      } else {
+        snprintf(pair, sizeof(pair), "%s=%d", f.name, c.*f.i);
+      }
+      if (!out.empty()) {
+        out += ' ';
+      }
+      out += pair;
+    }
+  }
+
+  return out;
+}
+
+light::light(const config &c, const plant &p, uint64_t seed)
+    : config_(c), plant_(p), random_(seed), height_(c.idle_height), position_(c.idle_height) {
+  // align encoder so that the calibrated position matches the true height
+  encoder_origin_ = height_;
+
+  // start with a settled floor reading
+  distance_ = height_;
+  reading_ = height_;
+  for (double &d : smooth_) {
+    d = height_;
+  }
+  smooth_count_ = 10;
+
+  // configure target filter
+  filter_.deadband = c.target_deadband;
+  filter_.hysteresis = c.target_hysteresis;
+  filter_.rate = c.target_rate;
+  filter_.dwell = static_cast<uint32_t>(c.target_dwell);
+}
+
+void light::step(const stimulus &s) {
+  // advance time
+  stats_.time++;
+
+  // move winch towards the speed of the current duty (first order lag)
+  double duty = std::abs(duty_) / 4.0;
+  double speed = 0;
+  if (duty_ > 0 && duty > plant_.up_offset) {
+    speed = (duty - plant_.up_offset) / plant_.up_gain;
+  } else if (duty_ < 0 && duty > plant_.down_offset) {
+    speed = -(duty - plant_.down_offset) / plant_.down_gain;
+  }
+  velocity_ += (speed - velocity_) * (1 - std::exp(-1.0 / plant_.inertia));
+  double delta = velocity_ / 1000;
+  height_ += delta;
+  stats_.travel += std::abs(delta);
+
+  // read encoder
+  double step = plant_.winding_length / encoder_resolution;
+  position_ = encoder_origin_ + std::floor((height_ - encoder_origin_) / step) * step;
+
+  // read sonar and pir at their firmware rate
+  if (stats_.time % sensor_interval == 0) {
+    sense(s);
+  }
+
+  // track motion time
+  if (motion_) {
+    stats_.motion++;
+  }
+
+  // feed automation
+  feed();
+}
+
+void light::sense(const stimulus &s) {
+  // measure distance to the highest object below or the floor
+  double reading = s.object >= 0 && s.object < height_ ? height_ - s.object : height_;
+  reading += normal_(random_) * plant_.sonar_noise;
+  reading_ = reading;
+
+  // smooth readings within range over the last ten readings
+  if (reading >= sonar_min && reading <= sonar_max) {
+    smooth_[smooth_index_] = reading;
+    smooth_index_ = (smooth_index_ + 1) % 10;
+    if (smooth_count_ < 10) {
+      smooth_count_++;
+    }
+    double sum = 0;
+    for (int i = 0; i < smooth_count_; i++) {
+      sum += smooth_[i];
+    }
+    distance_ = sum / smooth_count_;
+  }
+
+  // sample pir like the firmware (distance from the rest value of the adc)
+  int r = pir_rest + static_cast<int>(std::lround(s.activity + normal_(random_) * plant_.pir_noise));
+  int m = std::abs(pir_rest - std::max(0, std::min(1023, r)));
+
+  // update motion using the dynamic threshold
+  aut_config_t c = {config_.approach_range, config_.approach_target, config_.idle_height, config_.base_height,
+                    config_.rise_height,    config_.pir_low,         config_.pir_high};
+  if (m > aut_threshold(c, position_)) {
+    motion_last_ = static_cast<int64_t>(stats_.time);
+  }
+  motion_ = motion_last_ > static_cast<int64_t>(stats_.time) - config_.pir_interval;
+}
+
+void light::feed() {
+  // calculate and condition target
+  aut_config_t c = {config_.approach_range, config_.approach_target, config_.idle_height, config_.base_height,
+                    config_.rise_height,    config_.pir_low,         config_.pir_high};
+  double target = aut_target(c, position_, distance_, motion_);
+  target = aut_filter(&filter_, target, static_cast<uint32_t>(stats_.time));
+
+  // approach target
+  approach(target);
+}
+
+bool light::approach(double target) {
+  // update trapezoidal motion profile from the measured position for the next ms
+  double remaining = target - position_;
+  double stopping = profile_velocity_ * profile_velocity_ / (2 * MOT_MAX_ACCELERATION);
+  bool towards = profile_velocity_ * remaining > 0;
+  if (towards && std::abs(remaining) <= stopping) {
+    profile_velocity_ -= std::copysign(MOT_MAX_ACCELERATION, profile_velocity_);
+  } else {
+    profile_velocity_ += std::copysign(MOT_MAX_ACCELERATION, remaining);
+  }
+  profile_velocity_ = std::max(-MOT_MAX_VELOCITY, std::min(MOT_MAX_VELOCITY, profile_velocity_));
+
+  // stop if target has been reached (within 0.2cm and velocity < 2cm/s)
+  if (position_ < target + 0.2 && position_ > target - 0.2 && profile_velocity_ < 0.002) {
+    drive(0);
+    profile_velocity_ = 0;
+    creep_ = 0;
+    creep_on_ = false;
+    return true;
+  }
+
+  // move depending on profile velocity
+  double speed = std::min(12.0, std::abs(profile_velocity_) * 1000 * 0.8);
+  if (profile_velocity_ > 0) {
+    drive(raw(config_.mot_up_gain, config_.mot_up_offset, speed));
+  } else {
+    drive(-raw(config_.mot_down_gain, config_.mot_down_offset, speed));
+  }
+
+  return false;
+}
+
+int light::raw(double gain, double offset, double speed) {
+  // dither between stop and creep speed to reach average speeds below the dead band
+  if (speed < config_.creep_speed) {
+    // step accumulator once per tick independently of the update rate
+    if (stats_.time - creep_at_ >= static_cast<uint64_t>(creep_tick)) {
+      creep_at_ = stats_.time;
+      creep_ += speed / config_.creep_speed;
+      creep_on_ = creep_ >= 1;
+      if (creep_on_) {
+        creep_ -= 1;
+      }
+    }
+
+    // pause until the next pulse
+    if (!creep_on_) {
+      return 0;
+    }
+    speed = config_.creep_speed;
+  }
+
+  // calculate raw speed
+  return static_cast<int>(std::floor((gain * speed + offset) * 4));
+}
+
+void light::drive(int duty) {
+  // cap duty
+  duty = std::max(-4095, std::min(4095, duty));
+
+  // count direction reversals
+  if (duty != 0) {
+    int direction = duty > 0 ? 1 : -1;
+    if (direction_ != 0 && direction != direction_) {
+      stats_.reversals++;
+    }
+    direction_ = direction;
+  }
+
+  // set duty
+  duty_ = duty;
+}
+
+}  // namespace sim
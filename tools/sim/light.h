@@ -0,0 +1,215 @@
+#ifndef SIM_LIGHT_H
+#define SIM_LIGHT_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "plant.h"
+
+extern "C" {
+#include "aut.h"
+}
+
+namespace sim {
+
+/**
+ * The firmware parameters used by the simulation with the firmware defaults.
+ */
+struct config {
+  double approach_range = 40;
+  double approach_target = 20;
+  double idle_height = 50;
+  double base_height = 100;
+  double rise_height = 150;
+  int pir_low = 200;
+  int pir_high = 400;
+  int pir_interval = 2000;
+  double target_deadband = 1;
+  double target_hysteresis = 4;
+  double target_rate = 10;
+  int target_dwell = 1000;
+  double creep_speed = 1;
+
+  /**
+   * The firmware motor model (mot-* parameters).
+   */
+  double mot_up_gain = 69.88908;
+  double mot_up_offset = 142.488;
+  double mot_down_gain = 59.54553;
+  double mot_down_offset = 65.3359;
+};
+
+/**
+ * Set a configuration value by its firmware parameter name (e.g. "approach-range").
+ *
+ * @param c The configuration.
+ * @param name The name.
+ * @param value The value.
+ * @return Whether the name is known.
+ */
+bool set(config &c, const std::string &name, double value);
+
+/**
+ * Get a configuration value by its firmware parameter name.
+ *
+ * @param c The configuration.
+ * @param name The name.
+ * @param value The value.
+ * @return Whether the name is known.
+ */
+bool get(const config &c, const std::string &name, double &value);
+
+/**
+ * Format the named values as a profile payload ("name=value ...") for the firmware profile command.
+ *
+ * @param c The configuration.
+ * @param names The parameter names.
+ * @return The payload.
+ */
+std::string profile(const config &c, const std::vector<std::string> &names);
+
+/**
+ * The interval in ms at which the firmware samples the sonar and PIR.
+ */
+const int sensor_interval = 100;
+
+/**
+ * The sensor stimulus of a light for one millisecond.
+ */
+struct stimulus {
+  /**
+   * The height in cm of the highest object below the light or a negative value if there is none.
+   */
+  double object = -1;
+
+  /**
+   * The PIR magnitude caused by visitors.
+   */
+  double activity = 0;
+};
+
+/**
+ * The accumulated statistics of a light.
+ */
+struct stats {
+  /**
+   * The simulated time in ms.
+   */
+  uint64_t time = 0;
+
+  /**
+   * The number of motor direction reversals.
+   */
+  uint32_t reversals = 0;
+
+  /**
+   * The travelled cable length in cm.
+   */
+  double travel = 0;
+
+  /**
+   * The time with detected motion in ms.
+   */
+  uint64_t motion = 0;
+};
+
+/**
+ * A light in AUTOMATE mode. The light runs the firmware automation (aut.c) together with models of the motion
+ * profile, the motor driver with creeping, the encoder, the smoothed sonar and the PIR threshold logic at their
+ * firmware rates against a plant model.
+ */
+class light {
+ public:
+  /**
+   * Create a calibrated light resting at idle height.
+   *
+   * @param c The firmware configuration.
+   * @param p The plant.
+   * @param seed The seed of the sensor noise.
+   */
+  light(const config &c, const plant &p, uint64_t seed);
+
+  /**
+   * Advance the light by one millisecond.
+   *
+   * @param s The stimulus.
+   */
+  void step(const stimulus &s);
+
+  /**
+   * Get the true height of the light in cm.
+   */
+  double height() const { return height_; }
+
+  /**
+   * Get the position measured by the encoder in cm.
+   */
+  double position() const { return position_; }
+
+  /**
+   * Get the smoothed sonar distance in cm.
+   */
+  double distance() const { return distance_; }
+
+  /**
+   * Get the latest raw sonar reading in cm before the range check and smoothing.
+   */
+  double reading() const { return reading_; }
+
+  /**
+   * Get whether motion is detected.
+   */
+  bool motion() const { return motion_; }
+
+  /**
+   * Get the 12 bit motor duty (negative when moving down).
+   */
+  int duty() const { return duty_; }
+
+  /**
+   * Get the accumulated statistics.
+   */
+  const stats &statistics() const { return stats_; }
+
+ private:
+  void sense(const stimulus &s);
+  void feed();
+  bool approach(double target);
+  int raw(double gain, double offset, double speed);
+  void drive(int duty);
+
+  config config_;
+  plant plant_;
+  aut_filter_t filter_{};
+  std::mt19937_64 random_;
+  std::normal_distribution<double> normal_{0, 1};
+
+  // plant state
+  double height_;
+  double velocity_ = 0;
+
+  // firmware state
+  double position_;
+  double encoder_origin_;
+  double distance_;
+  double reading_;
+  double smooth_[10];
+  int smooth_count_ = 0;
+  int smooth_index_ = 0;
+  bool motion_ = false;
+  int64_t motion_last_ = -1000000;
+  double profile_velocity_ = 0;
+  double creep_ = 0;
+  bool creep_on_ = false;
+  uint64_t creep_at_ = 0;
+  int duty_ = 0;
+  int direction_ = 0;
+
+  stats stats_;
+};
+
+}  // namespace sim
+
+#endif  // SIM_LIGHT_H
@@ -0,0 +1,93 @@
+#include "plant.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace sim {
+
+namespace {
+
+struct field {
+  const char *name;
+  double plant::*value;
+};
+
+const field fields[] = {
+    {"mot-up-gain", &plant::up_gain},
+    {"mot-up-offset", &plant::up_offset},
+    {"mot-down-gain", &plant::down_gain},
+    {"mot-down-offset", &plant::down_offset},
+    {"inertia", &plant::inertia},
+    {"winding-length", &plant::winding_length},
+    {"sonar-noise", &plant::sonar_noise},
+    {"pir-noise", &plant::pir_noise},
+};
+
+}  // namespace
+
+bool set(plant &p, const std::string &name, double value) {
+  // find field
+  for (const auto &f : fields) {
+    if (name == f.name) {
+      p.*f.value = value;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::string format(const plant &p) {
+  // write one line per field
+  std::string out;
+  for (const auto &f : fields) {
+    char line[64];
+    snprintf(line, sizeof(line), "%s=%.6g\n", f.name, p.*f.value);
+    out += line;
+  }
+
+  return out;
+}
+
+bool load(const std::string &path, plant &p) {
+  // open file
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+
+  // read lines
+  std::string line;
+  while (std::getline(in, line)) {
+    // skip comments and blank lines
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    // split pair
+    auto eq = line.find('=');
+    if (eq == std::string::npos) {
+      continue;
+    }
+
+    // parse and set value
+    char *end = nullptr;
+    double value = strtod(line.c_str() + eq + 1, &end);
+    if (end != line.c_str() + eq + 1) {
+      set(p, line.substr(0, eq), value);
+    }
+  }
+
+  return true;
+}
+
+bool save(const std::string &path, const plant &p) {
+  // write file
+  std::ofstream out(path);
+  out << format(p);
+
+  return static_cast<bool>(out);
+}
+
+}  // namespace sim
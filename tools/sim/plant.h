@@ -0,0 +1,76 @@
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <string>
+
+namespace sim {
+
+/**
+ * The physical model of a light: winch, motor and sensors. The motor uses the same form as the firmware model
+ * (10 bit duty = gain * speed + offset) so fitted values can be compared with the mot-* parameters directly.
+ */
+struct plant {
+  /**
+   * The motor gain in duty per cm/s and dead band offset in duty when moving up and down.
+   */
+  double up_gain = 69.88908;
+  double up_offset = 142.488;
+  double down_gain = 59.54553;
+  double down_offset = 65.3359;
+
+  /**
+   * The time constant of the winch in ms.
+   */
+  double inertia = 60;
+
+  /**
+   * The cable length wound per spool rotation in cm.
+   */
+  double winding_length = 7.5;
+
+  /**
+   * The standard deviation of raw sonar readings in cm and raw PIR samples.
+   */
+  double sonar_noise = 1.0;
+  double pir_noise = 12.0;
+};
+
+/**
+ * Set a plant value by its model file name (e.g. "mot-up-gain").
+ *
+ * @param p The plant.
+ * @param name The name.
+ * @param value The value.
+ * @return Whether the name is known.
+ */
+bool set(plant &p, const std::string &name, double value);
+
+/**
+ * Format a plant as a model file with one "name=value" line per value.
+ *
+ * @param p The plant.
+ * @return The model file contents.
+ */
+std::string format(const plant &p);
+
+/**
+ * Load a model file. Unknown names, comments ("#") and blank lines are ignored.
+ *
+ * @param path The path.
+ * @param p The plant to update.
+ * @return Whether the file could be read.
+ */
+bool load(const std::string &path, plant &p);
+
+/**
+ * Save a model file.
+ *
+ * @param path The path.
+ * @param p The plant.
+ * @return Whether the file could be written.
+ */
+bool save(const std::string &path, const plant &p);
+
+}  // namespace sim
+
+#endif  // SIM_PLANT_H
@@ -0,0 +1,57 @@
+#ifndef SIM_POOL_H
+#define SIM_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Get the number of threads to use if none has been requested.
+ *
+ * @param requested The requested number or zero.
+ * @return The number of threads.
+ */
+inline unsigned threads(unsigned requested) {
+  return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Call a function for each index in [0, n) on the specified number of threads. Indices are handed out dynamically
+ * so uneven work is balanced.
+ *
+ * @param n The number of indices.
+ * @param workers The number of threads.
+ * @param fn The function.
+ */
+template <typename F>
+void parallel_for(size_t n, unsigned workers, F fn) {
+  // run inline for a single thread
+  if (workers <= 1 || n <= 1) {
+    for (size_t i = 0; i < n; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  // run workers
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> pool;
+  for (unsigned w = 0; w < std::min<size_t>(workers, n); w++) {
+    pool.emplace_back([&] {
+      for (size_t i = next++; i < n; i = next++) {
+        fn(i);
+      }
+    });
+  }
+  for (auto &t : pool) {
+    t.join();
+  }
+}
+
+}  // namespace sim
+
+#endif  // SIM_POOL_H
@@ -0,0 +1,123 @@
+#include "visitor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sim {
+
+namespace {
+
+// the time a visitor walks when arriving and leaving in ms
+const uint64_t walk_time = 2000;
+
+// the sway period of a reaching hand in ms
+const double sway_period = 4000;
+
+// the height in cm from which a hand rises when reaching and its speed in cm/ms
+const double hand_rest = 40;
+const double hand_speed = 0.02;
+
+}  // namespace
+
+scenario::scenario(const behavior &b, uint64_t seed) : behavior_(b), random_(seed) {
+  // schedule first arrival
+  std::exponential_distribution<double> gap(b.arrivals / 60000);
+  next_ = static_cast<uint64_t>(gap(random_));
+}
+
+stimulus scenario::step() {
+  // advance time
+  time_++;
+
+  // add arriving visitor and schedule next arrival
+  if (time_ >= next_) {
+    std::uniform_real_distribution<double> unit(0, 1);
+    visitor v{};
+    v.arrive = time_;
+    v.leave = time_ + behavior_.stay_min +
+              static_cast<uint64_t>(unit(random_) * static_cast<double>(behavior_.stay_max - behavior_.stay_min));
+    if (unit(random_) < behavior_.reach && v.leave - v.arrive > 3 * walk_time) {
+      uint64_t span = v.leave - v.arrive - 3 * walk_time;
+      v.reach_start = v.arrive + walk_time + static_cast<uint64_t>(unit(random_) * static_cast<double>(span) / 2);
+      v.reach_end = v.reach_start + walk_time +
+                    static_cast<uint64_t>(unit(random_) * static_cast<double>(v.leave - walk_time - v.reach_start));
+      v.reach_end = std::min(v.reach_end, v.leave - walk_time);
+      v.hand = behavior_.hand_min + unit(random_) * (behavior_.hand_max - behavior_.hand_min);
+      v.sway = unit(random_) * 8;
+    }
+    visitors_.push_back(v);
+
+    // schedule next arrival
+    std::exponential_distribution<double> gap(behavior_.arrivals / 60000);
+    next_ = time_ + 1 + static_cast<uint64_t>(gap(random_));
+  }
+
+  // remove left visitors
+  visitors_.erase(std::remove_if(visitors_.begin(), visitors_.end(), [&](const visitor &v) { return v.leave <= time_; }),
+                  visitors_.end());
+
+  // combine visitors
+  stimulus s;
+  hand_ = -1;
+  for (const auto &v : visitors_) {
+    bool walking = time_ < v.arrive + walk_time || time_ + walk_time > v.leave;
+    bool reaching = time_ >= v.reach_start && time_ < v.reach_end;
+
+    // moving arms and walking cause the larger pir magnitude
+    s.activity = std::max(s.activity, walking || reaching ? behavior_.walking : behavior_.standing);
+
+    // the highest reaching hand is the nearest object below the light, it rises from the rest height and then sways
+    if (reaching) {
+      double elapsed = static_cast<double>(time_ - v.reach_start);
+      double height = std::min(v.hand, hand_rest + elapsed * hand_speed);
+      hand_ = std::max(hand_, height + v.sway * std::sin(2 * M_PI * elapsed / sway_period));
+    }
+  }
+  s.object = hand_;
+
+  return s;
+}
+
+score simulate(const config &c, const plant &p, const behavior &b, uint64_t seed, uint64_t duration) {
+  // prepare light and scenario
+  light l(c, p, seed * 0x9e3779b97f4a7c15ull + 1);
+  scenario s(b, seed);
+
+  // run simulation
+  score r;
+  uint64_t reaching = 0;
+  uint64_t close = 0;
+  uint64_t contact = 0;
+  bool active = false;
+  for (uint64_t t = 1; t <= duration; t++) {
+    // step scenario and light
+    l.step(s.step());
+
+    // track reaches
+    double hand = s.hand();
+    if (hand >= 0) {
+      reaching++;
+      if (l.height() < hand + clearance) {
+        close++;
+      }
+      if (l.height() < hand + margin) {
+        contact++;
+      }
+      active = true;
+    } else if (active) {
+      active = false;
+      r.reaches++;
+    }
+  }
+
+  // calculate score
+  double minutes = static_cast<double>(duration) / 60000;
+  r.response = r.reaches > 0 ? static_cast<double>(close) / r.reaches : 0;
+  r.contact = reaching > 0 ? static_cast<double>(contact) / static_cast<double>(reaching) : 0;
+  r.reversals = l.statistics().reversals / minutes;
+  r.travel = l.statistics().travel / minutes;
+
+  return r;
+}
+
+}  // namespace sim
@@ -0,0 +1,136 @@
+#ifndef SIM_VISITOR_H
+#define SIM_VISITOR_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "light.h"
+
+namespace sim {
+
+/**
+ * The behavior of visitors around a single light.
+ */
+struct behavior {
+  /**
+   * The mean number of visitors arriving per minute.
+   */
+  double arrivals = 1.5;
+
+  /**
+   * The range of time a visitor stays in ms.
+   */
+  uint32_t stay_min = 10000;
+  uint32_t stay_max = 60000;
+
+  /**
+   * The probability that a visitor reaches under the light.
+   */
+  double reach = 0.6;
+
+  /**
+   * The range of hand heights in cm when reaching.
+   */
+  double hand_min = 60;
+  double hand_max = 130;
+
+  /**
+   * The PIR magnitude of a walking and of a standing visitor.
+   */
+  double walking = 320;
+  double standing = 140;
+};
+
+/**
+ * A random sequence of visitors around a light that produces the sensor stimulus for each millisecond.
+ */
+class scenario {
+ public:
+  /**
+   * Create a scenario.
+   *
+   * @param b The behavior.
+   * @param seed The seed.
+   */
+  scenario(const behavior &b, uint64_t seed);
+
+  /**
+   * Get the stimulus for the next millisecond.
+   *
+   * @return The stimulus.
+   */
+  stimulus step();
+
+  /**
+   * Get the height of the highest reaching hand or a negative value if no visitor reaches.
+   */
+  double hand() const { return hand_; }
+
+ private:
+  struct visitor {
+    uint64_t arrive, leave;
+    uint64_t reach_start, reach_end;
+    double hand, sway;
+  };
+
+  behavior behavior_;
+  std::mt19937_64 random_;
+  std::vector<visitor> visitors_;
+  uint64_t time_ = 0;
+  uint64_t next_ = 0;
+  double hand_ = -1;
+};
+
+/**
+ * The performance of a configuration against visitors.
+ */
+struct score {
+  /**
+   * The mean time in ms per reach that the light was closer to the hand than the clearance.
+   */
+  double response = 0;
+
+  /**
+   * The fraction of reaching time the light was below the hand plus the safety margin.
+   */
+  double contact = 0;
+
+  /**
+   * The motor reversals per minute.
+   */
+  double reversals = 0;
+
+  /**
+   * The travel in cm per minute.
+   */
+  double travel = 0;
+
+  /**
+   * The number of reaches.
+   */
+  uint32_t reaches = 0;
+};
+
+/**
+ * The clearance in cm a light should keep above a reaching hand and the margin below which it counts as contact.
+ * The values are fixed so that a tuner cannot improve the score by changing approach-target.
+ */
+const double clearance = 10;
+const double margin = 3;
+
+/**
+ * Simulate a light against a scenario.
+ *
+ * @param c The configuration.
+ * @param p The plant.
+ * @param b The visitor behavior.
+ * @param seed The seed of the scenario and sensor noise.
+ * @param duration The simulated duration in ms.
+ * @return The score.
+ */
+score simulate(const config &c, const plant &p, const behavior &b, uint64_t seed, uint64_t duration);
+
+}  // namespace sim
+
+#endif  // SIM_VISITOR_H
@@ -0,0 +1,730 @@
+#include "device.h"
+
+#include <setjmp.h>
+#include <ucontext.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <driver/adc.h>
+#include <driver/rmt.h>
+#include <driver/timer.h>
+#include <esp_now.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/queue.h>
+#include <nvs.h>
+
+void app_main();
+}
+
+// the tasks created by the firmware
+struct dev_task {
+  ucontext_t context;
+  jmp_buf jump;
+  bool started;
+  std::vector<uint8_t> stack;
+  TaskFunction_t fn;
+  void *arg;
+  bool notified;
+  uint64_t deadline;
+};
+
+// the queues created by the firmware
+struct dev_queue {
+  size_t size;
+  size_t length;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+namespace soak {
+
+namespace device {
+
+namespace {
+
+// the heap available to the firmware at boot on the device
+const size_t heap_size = 200000;
+
+// the painted stack pattern and the size of host stack frames relative to the device
+const uint8_t stack_paint = 0xa5;
+const size_t stack_scale = 4;
+
+// the emulated chip
+struct chip {
+  hooks h;
+  uint64_t time = 0;
+  uint64_t random = 0;
+
+  // gpio
+  int levels[GPIO_NUM_MAX] = {};
+  gpio_int_type_t interrupts[GPIO_NUM_MAX] = {};
+  gpio_isr_t handlers[GPIO_NUM_MAX] = {};
+  void *args[GPIO_NUM_MAX] = {};
+
+  // ledc, adc and timer
+  uint32_t duties[LEDC_CHANNEL_MAX] = {};
+  uint32_t fades[LEDC_CHANNEL_MAX] = {};
+  uint64_t counter = 0;
+  uint64_t started = 0;
+  bool counting = false;
+
+  // tasks and queues
+  std::vector<std::unique_ptr<dev_task>> tasks;
+  dev_task *current = nullptr;
+  uint64_t wake = UINT64_MAX;
+  jmp_buf host;
+  std::vector<std::unique_ptr<dev_queue>> queues;
+  int queue_peak = 0;
+
+  // heap
+  heap allocations;
+
+  // nvs and esp-now
+  std::map<std::string, std::vector<uint8_t>> nvs;
+  uint64_t flash = 0;
+  esp_now_recv_cb_t receiver = nullptr;
+  uint64_t sent = 0;
+
+  // naos
+  naos_config_t *config = nullptr;
+};
+
+chip c;
+
+uint32_t next_random() {
+  // xorshift64
+  c.random ^= c.random << 13;
+  c.random ^= c.random >> 7;
+  c.random ^= c.random << 17;
+  return static_cast<uint32_t>(c.random >> 32);
+}
+
+void enter(uint32_t lo, uint32_t hi) {
+  // run task function, tasks never return
+  dev_task *t = reinterpret_cast<dev_task *>(static_cast<uintptr_t>(lo) | static_cast<uintptr_t>(hi) << 32);
+  t->fn(t->arg);
+  abort();
+}
+
+naos_param_t *find(const char *name) {
+  // find parameter
+  for (size_t i = 0; c.config != nullptr && i < c.config->num_parameters; i++) {
+    if (strcmp(c.config->parameters[i].name, name) == 0) {
+      return &c.config->parameters[i];
+    }
+  }
+
+  return nullptr;
+}
+
+void assign(naos_param_t *p, const char *value) {
+  // synchronize value
+  switch (p->type) {
+    case NAOS_STRING:
+      free(*p->sync_s);
+      *p->sync_s = strdup(value);
+      break;
+    case NAOS_BOOL:
+      *p->sync_b = strcmp(value, "1") == 0 || strcmp(value, "true") == 0;
+      break;
+    case NAOS_LONG:
+      *p->sync_l = static_cast<int32_t>(strtol(value, nullptr, 10));
+      break;
+    case NAOS_DOUBLE:
+      *p->sync_d = strtod(value, nullptr);
+      break;
+  }
+}
+
+void resume(dev_task *t) {
+  // switch with jumps as they do not save the signal mask, the context is only used to start the task
+  c.current = t;
+  if (_setjmp(c.host) == 0) {
+    if (!t->started) {
+      t->started = true;
+      setcontext(&t->context);
+    }
+    _longjmp(t->jump, 1);
+  }
+  c.current = nullptr;
+}
+
+void plan() {
+  // cache earliest task
+  c.wake = UINT64_MAX;
+  for (const auto &t : c.tasks) {
+    c.wake = std::min(c.wake, t->notified ? c.time : t->deadline);
+  }
+}
+
+void track(dev_queue *q) {
+  // track peak depth
+  c.queue_peak = std::max(c.queue_peak, static_cast<int>(q->items.size()));
+}
+
+}  // namespace
+
+void boot(const hooks &h, uint64_t seed) {
+  // prepare chip
+  c.h = h;
+  c.random = seed * 0x9e3779b97f4a7c15ull + 1;
+
+  // run firmware initialization
+  app_main();
+}
+
+uint64_t now() { return c.time; }
+
+void advance(uint64_t us) { c.time = std::max(c.time, us); }
+
+uint64_t wake() { return c.wake; }
+
+void run() {
+  // resume due tasks until all wait again
+  for (bool again = true; again;) {
+    again = false;
+    for (const auto &t : c.tasks) {
+      if (t->notified || t->deadline <= c.time) {
+        resume(t.get());
+        again = again || t->notified;
+      }
+    }
+  }
+  plan();
+}
+
+void drive(gpio_num_t pin, int level) {
+  // set level
+  int previous = c.levels[pin];
+  c.levels[pin] = level;
+  if (previous == level || c.handlers[pin] == nullptr) {
+    return;
+  }
+
+  // raise interrupt on matching edge
+  gpio_int_type_t type = c.interrupts[pin];
+  if (type == GPIO_INTR_ANYEDGE || (type == GPIO_INTR_POSEDGE && level) || (type == GPIO_INTR_NEGEDGE && !level)) {
+    c.handlers[pin](c.args[pin]);
+  }
+}
+
+int level(gpio_num_t pin) { return c.levels[pin]; }
+
+uint32_t duty(ledc_channel_t channel) { return c.duties[channel]; }
+
+const naos_config_t &config() { return *c.config; }
+
+bool update(const std::string &name, const std::string &value) {
+  // find parameter
+  naos_param_t *p = find(name.c_str());
+  if (p == nullptr) {
+    return false;
+  }
+
+  // store and synchronize value
+  assign(p, value.c_str());
+  c.flash++;
+
+  // notify firmware
+  if (c.config->update_callback != nullptr) {
+    c.config->update_callback(name.c_str(), value.c_str());
+  }
+
+  return true;
+}
+
+void message(const std::string &topic, const std::string &payload, naos_scope_t scope) {
+  // copy payload as naos provides a zero terminated mutable buffer
+  std::vector<uint8_t> buf(payload.begin(), payload.end());
+  buf.push_back(0);
+
+  // dispatch message
+  if (c.config->message_callback != nullptr) {
+    c.config->message_callback(topic.c_str(), buf.data(), payload.size(), scope);
+  }
+}
+
+void receive(const uint8_t mac[6], const uint8_t *data, int len) {
+  // call receiver
+  if (c.receiver != nullptr) {
+    c.receiver(mac, data, len);
+  }
+}
+
+const heap &allocations() { return c.allocations; }
+
+size_t stack() {
+  // find the deepest painted stack
+  size_t used = 0;
+  for (const auto &t : c.tasks) {
+    size_t untouched = 0;
+    while (untouched < t->stack.size() && t->stack[untouched] == stack_paint) {
+      untouched++;
+    }
+    used = std::max(used, t->stack.size() - untouched);
+  }
+
+  return used;
+}
+
+int queue() {
+  // get and reset peak depth
+  int peak = c.queue_peak;
+  c.queue_peak = 0;
+  for (const auto &q : c.queues) {
+    track(q.get());
+  }
+
+  return peak;
+}
+
+uint64_t flash() { return c.flash; }
+
+uint64_t sent() { return c.sent; }
+
+}  // namespace device
+
+}  // namespace soak
+
+using soak::device::c;
+
+extern "C" {
+
+/* heap */
+
+void *dev_malloc(size_t size) {
+  // allocate with a size header
+  auto *p = static_cast<size_t *>(malloc(size + sizeof(max_align_t)));
+  if (p == nullptr) {
+    return nullptr;
+  }
+  *p = size;
+
+  // account allocation
+  c.allocations.allocs++;
+  c.allocations.live += size;
+  c.allocations.peak = std::max(c.allocations.peak, c.allocations.live);
+
+  return reinterpret_cast<uint8_t *>(p) + sizeof(max_align_t);
+}
+
+void dev_free(void *ptr) {
+  // ignore null
+  if (ptr == nullptr) {
+    return;
+  }
+
+  // account free
+  auto *p = reinterpret_cast<size_t *>(static_cast<uint8_t *>(ptr) - sizeof(max_align_t));
+  c.allocations.frees++;
+  c.allocations.live -= *p;
+  free(p);
+}
+
+void *dev_calloc(size_t num, size_t size) {
+  // allocate and clear
+  void *p = dev_malloc(num * size);
+  if (p != nullptr) {
+    memset(p, 0, num * size);
+  }
+
+  return p;
+}
+
+void *dev_realloc(void *ptr, size_t size) {
+  // allocate, copy and free
+  void *p = dev_malloc(size);
+  if (p != nullptr && ptr != nullptr) {
+    size_t old = *reinterpret_cast<size_t *>(static_cast<uint8_t *>(ptr) - sizeof(max_align_t));
+    memcpy(p, ptr, std::min(old, size));
+    dev_free(ptr);
+  }
+
+  return p;
+}
+
+/* esp */
+
+const char *esp_err_to_name(esp_err_t code) { return code == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+
+void esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *expression) {
+  fprintf(stderr, "ESP_ERROR_CHECK failed: %s (%d) at %s:%d: %s\n", esp_err_to_name(rc), rc, file, line, expression);
+  abort();
+}
+
+uint32_t esp_get_free_heap_size() {
+  return static_cast<uint32_t>(soak::device::heap_size - std::min(soak::device::heap_size, c.allocations.live));
+}
+
+uint32_t esp_get_minimum_free_heap_size() {
+  return static_cast<uint32_t>(soak::device::heap_size - std::min(soak::device::heap_size, c.allocations.peak));
+}
+
+uint32_t esp_random() { return soak::device::next_random(); }
+
+int64_t esp_timer_get_time() { return static_cast<int64_t>(c.time); }
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t, uint8_t mac[6]) {
+  const uint8_t own[6] = {0x24, 0x0a, 0xc4, 0x00, 0x50, 0x4b};
+  memcpy(mac, own, 6);
+  return ESP_OK;
+}
+
+esp_err_t esp_now_init() { return ESP_OK; }
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  c.receiver = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *) { return ESP_OK; }
+
+esp_err_t esp_now_send(const uint8_t *, const uint8_t *, size_t) {
+  c.sent++;
+  return ESP_OK;
+}
+
+/* nvs */
+
+esp_err_t nvs_open(const char *, nvs_open_mode, nvs_handle *handle) {
+  *handle = 1;
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle, const char *key, void *value, size_t *length) {
+  // find blob
+  auto it = c.nvs.find(key);
+  if (it == c.nvs.end()) {
+    return ESP_ERR_NVS_NOT_FOUND;
+  }
+
+  // copy blob
+  memcpy(value, it->second.data(), std::min(*length, it->second.size()));
+  *length = it->second.size();
+
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle, const char *key, const void *value, size_t length) {
+  auto *bytes = static_cast<const uint8_t *>(value);
+  c.nvs[key] = std::vector<uint8_t>(bytes, bytes + length);
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle) {
+  c.flash++;
+  return ESP_OK;
+}
+
+/* gpio */
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+  for (int i = 0; i < GPIO_NUM_MAX; i++) {
+    if (config->pin_bit_mask & (1ULL << i)) {
+      c.interrupts[i] = config->intr_type;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t num, uint32_t level) {
+  c.levels[num] = level != 0;
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t num) { return c.levels[num]; }
+
+esp_err_t gpio_install_isr_service(int) { return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t num, gpio_isr_t handler, void *arg) {
+  c.handlers[num] = handler;
+  c.args[num] = arg;
+  return ESP_OK;
+}
+
+/* ledc */
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *) { return ESP_OK; }
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *config) {
+  c.duties[config->channel] = config->duty;
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t channel, uint32_t duty) {
+  c.fades[channel] = duty;
+  return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t channel) {
+  c.duties[channel] = c.fades[channel];
+  return ESP_OK;
+}
+
+esp_err_t ledc_fade_func_install(int) { return ESP_OK; }
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t, ledc_channel_t channel, uint32_t duty, int) {
+  c.fades[channel] = duty;
+  return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t, ledc_channel_t channel, ledc_fade_mode_t) {
+  c.duties[channel] = c.fades[channel];
+  return ESP_OK;
+}
+
+/* adc */
+
+esp_err_t adc1_config_width(adc_bits_width_t) { return ESP_OK; }
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t, adc_atten_t) { return ESP_OK; }
+
+int adc1_get_raw(adc1_channel_t) { return c.h.adc ? c.h.adc() : 0; }
+
+/* rmt */
+
+esp_err_t rmt_config(const rmt_config_t *) { return ESP_OK; }
+
+esp_err_t rmt_driver_install(rmt_channel_t, size_t, int) { return ESP_OK; }
+
+esp_err_t rmt_write_items(rmt_channel_t, const rmt_item32_t *, int, bool) {
+  if (c.h.trigger) {
+    c.h.trigger();
+  }
+  return ESP_OK;
+}
+
+/* timer */
+
+esp_err_t timer_init(timer_group_t, timer_idx_t, const timer_config_t *) { return ESP_OK; }
+
+esp_err_t timer_start(timer_group_t, timer_idx_t) {
+  c.started = c.time;
+  c.counting = true;
+  return ESP_OK;
+}
+
+esp_err_t timer_pause(timer_group_t, timer_idx_t) {
+  if (c.counting) {
+    c.counter += c.time - c.started;
+    c.counting = false;
+  }
+  return ESP_OK;
+}
+
+esp_err_t timer_set_counter_value(timer_group_t, timer_idx_t, uint64_t value) {
+  c.counter = value;
+  c.started = c.time;
+  return ESP_OK;
+}
+
+esp_err_t timer_get_counter_value(timer_group_t, timer_idx_t, uint64_t *value) {
+  *value = c.counter + (c.counting ? c.time - c.started : 0);
+  return ESP_OK;
+}
+
+/* freertos */
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *, uint32_t depth, void *arg, UBaseType_t,
+                                   TaskHandle_t *handle, BaseType_t) {
+  // prepare painted stack
+  auto t = std::make_unique<dev_task>();
+  t->stack.assign(depth * soak::device::stack_scale, soak::device::stack_paint);
+  t->fn = fn;
+  t->arg = arg;
+  t->started = false;
+  t->notified = false;
+  t->deadline = c.time;
+
+  // prepare context
+  getcontext(&t->context);
+  t->context.uc_stack.ss_sp = t->stack.data();
+  t->context.uc_stack.ss_size = t->stack.size();
+  t->context.uc_link = nullptr;
+  auto ptr = reinterpret_cast<uintptr_t>(t.get());
+  makecontext(&t->context, reinterpret_cast<void (*)()>(soak::device::enter), 2, static_cast<uint32_t>(ptr),
+              static_cast<uint32_t>(ptr >> 32));
+
+  // add task
+  if (handle != nullptr) {
+    *handle = t.get();
+  }
+  c.tasks.push_back(std::move(t));
+  soak::device::plan();
+
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks) {
+  // wait for notification or timeout
+  dev_task *t = c.current;
+  if (!t->notified && ticks > 0) {
+    t->deadline = ticks == portMAX_DELAY ? UINT64_MAX : c.time + static_cast<uint64_t>(ticks) * 1000;
+    soak::device::plan();
+    if (_setjmp(t->jump) == 0) {
+      _longjmp(c.host, 1);
+    }
+  }
+
+  // take notification
+  uint32_t value = t->notified ? 1 : 0;
+  t->notified = false;
+  t->deadline = UINT64_MAX;
+
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  task->notified = true;
+  c.wake = std::min(c.wake, c.time);
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *) {
+  task->notified = true;
+  c.wake = std::min(c.wake, c.time);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  // count untouched bytes
+  size_t untouched = 0;
+  while (untouched < task->stack.size() && task->stack[untouched] == soak::device::stack_paint) {
+    untouched++;
+  }
+
+  return static_cast<UBaseType_t>(untouched);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t size) {
+  auto q = std::make_unique<dev_queue>();
+  q->size = size;
+  q->length = length;
+  c.queues.push_back(std::move(q));
+  return c.queues.back().get();
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t) {
+  // fail if full
+  if (queue->items.size() >= queue->length) {
+    return pdFALSE;
+  }
+
+  // append item
+  auto *bytes = static_cast<const uint8_t *>(item);
+  queue->items.emplace_back(bytes, bytes + queue->size);
+  soak::device::track(queue);
+
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *) {
+  return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t) {
+  // fail if empty
+  if (queue->items.empty()) {
+    return pdFALSE;
+  }
+
+  // take item
+  memcpy(item, queue->items.front().data(), queue->size);
+  queue->items.pop_front();
+
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) { return static_cast<UBaseType_t>(queue->items.size()); }
+
+/* naos */
+
+void naos_init(naos_config_t *config) {
+  // keep config
+  c.config = config;
+
+  // apply defaults
+  for (size_t i = 0; i < config->num_parameters; i++) {
+    naos_param_t *p = &config->parameters[i];
+    char value[32];
+    switch (p->type) {
+      case NAOS_STRING:
+        soak::device::assign(p, p->default_s != nullptr ? p->default_s : "");
+        continue;
+      case NAOS_BOOL:
+        snprintf(value, sizeof(value), "%d", p->default_b);
+        break;
+      case NAOS_LONG:
+        snprintf(value, sizeof(value), "%d", static_cast<int>(p->default_l));
+        break;
+      case NAOS_DOUBLE:
+        snprintf(value, sizeof(value), "%.17g", p->default_d);
+        break;
+    }
+    soak::device::assign(p, value);
+  }
+}
+
+void naos_log(const char *fmt, ...) {
+  // format message
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  // report message
+  if (c.h.log) {
+    c.h.log(buf);
+  }
+}
+
+bool naos_subscribe(const char *, int, naos_scope_t) { return true; }
+
+bool naos_publish_r(const char *topic, void *payload, size_t len, int, bool, naos_scope_t) {
+  if (c.h.publish) {
+    c.h.publish(topic, payload, len);
+  }
+  return true;
+}
+
+bool naos_publish(const char *topic, const char *payload, int qos, bool retained, naos_scope_t scope) {
+  return naos_publish_r(topic, const_cast<char *>(payload), strlen(payload), qos, retained, scope);
+}
+
+bool naos_publish_b(const char *topic, bool payload, int qos, bool retained, naos_scope_t scope) {
+  return naos_publish(topic, payload ? "1" : "0", qos, retained, scope);
+}
+
+bool naos_publish_l(const char *topic, int32_t payload, int qos, bool retained, naos_scope_t scope) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%d", static_cast<int>(payload));
+  return naos_publish(topic, buf, qos, retained, scope);
+}
+
+bool naos_publish_d(const char *topic, double payload, int qos, bool retained, naos_scope_t scope) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%f", payload);
+  return naos_publish(topic, buf, qos, retained, scope);
+}
+
+uint32_t naos_millis() { return static_cast<uint32_t>(c.time / 1000); }
+
+void naos_set(const char *param, const char *value) {
+  // store and synchronize value without calling the update callback like naos
+  naos_param_t *p = soak::device::find(param);
+  if (p != nullptr) {
+    soak::device::assign(p, value);
+    c.flash++;
+  }
+}
+}
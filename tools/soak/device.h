@@ -0,0 +1,179 @@
+#ifndef SOAK_DEVICE_H
+#define SOAK_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+extern "C" {
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <naos.h>
+}
+
+namespace soak {
+
+/**
+ * The emulated ESP32 and naos framework the firmware runs on. The firmware keeps its state in globals, so there is
+ * a single device per process. The host owns the clock: it drives the inputs, raises interrupts, resumes the tasks
+ * when they are notified or their wait expires and calls the naos callbacks.
+ */
+namespace device {
+
+/**
+ * The callbacks through which the device reports to the host.
+ */
+struct hooks {
+  /**
+   * Called for every publish with the raw payload.
+   */
+  std::function<void(const char *topic, const void *payload, size_t len)> publish;
+
+  /**
+   * Called when the firmware triggers the sonar.
+   */
+  std::function<void()> trigger;
+
+  /**
+   * Called when the firmware reads the ADC to get the raw value.
+   */
+  std::function<int()> adc;
+
+  /**
+   * Called for every log message.
+   */
+  std::function<void(const char *message)> log;
+};
+
+/**
+ * The firmware allocations.
+ */
+struct heap {
+  /**
+   * The number of allocations and frees.
+   */
+  uint64_t allocs = 0;
+  uint64_t frees = 0;
+
+  /**
+   * The currently allocated and the peak allocated bytes.
+   */
+  size_t live = 0;
+  size_t peak = 0;
+};
+
+/**
+ * Boot the device by calling app_main.
+ *
+ * @param h The hooks.
+ * @param seed The seed of esp_random.
+ */
+void boot(const hooks &h, uint64_t seed);
+
+/**
+ * Get the simulated time in us.
+ */
+uint64_t now();
+
+/**
+ * Set the simulated time in us. The time must not go backwards.
+ *
+ * @param us The time.
+ */
+void advance(uint64_t us);
+
+/**
+ * Get the time in us at which a task needs to be resumed (now if it has been notified) or UINT64_MAX.
+ */
+uint64_t wake();
+
+/**
+ * Resume all tasks that have been notified or whose wait expired until they wait again.
+ */
+void run();
+
+/**
+ * Set the level of an input pin and raise its interrupt on a matching edge.
+ *
+ * @param pin The pin.
+ * @param level The level.
+ */
+void drive(gpio_num_t pin, int level);
+
+/**
+ * Get the level of a pin.
+ *
+ * @param pin The pin.
+ */
+int level(gpio_num_t pin);
+
+/**
+ * Get the duty of a PWM channel.
+ *
+ * @param channel The channel.
+ */
+uint32_t duty(ledc_channel_t channel);
+
+/**
+ * Get the naos configuration registered by the firmware.
+ */
+const naos_config_t &config();
+
+/**
+ * Set a parameter like a remote update: store and synchronize the value and call the update callback.
+ *
+ * @param name The parameter.
+ * @param value The value.
+ * @return Whether the parameter exists.
+ */
+bool update(const std::string &name, const std::string &value);
+
+/**
+ * Deliver a message to the firmware.
+ *
+ * @param topic The topic.
+ * @param payload The payload.
+ * @param scope The scope.
+ */
+void message(const std::string &topic, const std::string &payload, naos_scope_t scope);
+
+/**
+ * Deliver an ESP-NOW packet to the firmware if it registered a receiver.
+ *
+ * @param mac The sender.
+ * @param data The packet.
+ * @param len The packet length.
+ */
+void receive(const uint8_t mac[6], const uint8_t *data, int len);
+
+/**
+ * Get the firmware allocations.
+ */
+const heap &allocations();
+
+/**
+ * Get the stack in bytes that the tasks used at most.
+ */
+size_t stack();
+
+/**
+ * Get the peak depth of all queues since the last call and reset it.
+ */
+int queue();
+
+/**
+ * Get the number of flash writes (NVS commits and parameter writes).
+ */
+uint64_t flash();
+
+/**
+ * Get the number of sent ESP-NOW packets.
+ */
+uint64_t sent();
+
+}  // namespace device
+
+}  // namespace soak
+
+#endif  // SOAK_DEVICE_H
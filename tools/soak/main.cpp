@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "soak/run.h"
+
+namespace {
+
+struct options {
+  soak::options soak;
+  std::string script;
+  std::string model;
+  std::string out;
+  int window = 3;
+  bool log = false;
+};
+
+void usage() {
+  fprintf(stderr,
+          "usage: soak [--days N] [--seed S] [--script FILE] [--drops N] [--window N] [--model FILE] [--out FILE]\n"
+          "            [--log]\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--log") {
+      o.log = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--days") {
+      o.soak.days = atof(value);
+    } else if (flag == "--seed") {
+      o.soak.seed = strtoull(value, nullptr, 10);
+    } else if (flag == "--script") {
+      o.script = value;
+    } else if (flag == "--drops") {
+      o.soak.drops = atoi(value);
+    } else if (flag == "--window") {
+      o.window = atoi(value);
+    } else if (flag == "--model") {
+      o.model = value;
+    } else if (flag == "--out") {
+      o.out = value;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::string format(int index, const soak::day &d, const char *sep) {
+  // format resources, activity and state times in minutes
+  char buf[512];
+  int n = snprintf(buf, sizeof(buf), "%d%s%zu%s%u%s%llu%s%zu%s%d%s%u%s%llu%s%llu%s%llu%s%.0f", index, sep, d.heap, sep,
+                   d.min_heap, sep, static_cast<unsigned long long>(d.allocs), sep, d.stack, sep, d.queue, sep,
+                   d.dropped, sep, static_cast<unsigned long long>(d.flash), sep,
+                   static_cast<unsigned long long>(d.publishes), sep, static_cast<unsigned long long>(d.events), sep,
+                   d.travel);
+  for (uint32_t ms : d.states) {
+    n += snprintf(buf + n, sizeof(buf) - static_cast<size_t>(n), "%s%.1f", sep, ms / 60000.0);
+  }
+
+  return buf;
+}
+
+std::string header(const char *sep) {
+  // join column names
+  std::string h = "day";
+  for (const char *c : {"heap", "min-heap", "allocs", "stack", "queue", "dropped", "flash", "publishes", "events",
+                        "travel"}) {
+    h += sep + std::string(c);
+  }
+  for (const char *s : soak::state_names) {
+    h += sep + std::string(s);
+  }
+
+  return h;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // load script
+  std::string text = soak::default_script;
+  if (!o.script.empty()) {
+    std::ifstream in(o.script);
+    if (!in) {
+      fprintf(stderr, "soak: failed to read script %s\n", o.script.c_str());
+      return 1;
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    text = ss.str();
+  }
+  std::string error;
+  if (!soak::parse(text, o.soak.events, error)) {
+    fprintf(stderr, "soak: invalid script: %s\n", error.c_str());
+    return 1;
+  }
+
+  // load plant model
+  if (!o.model.empty() && !sim::load(o.model, o.soak.plant)) {
+    fprintf(stderr, "soak: failed to load model %s\n", o.model.c_str());
+    return 1;
+  }
+
+  // print firmware log
+  if (o.log) {
+    o.soak.log = [](uint64_t time, const char *message) {
+      fprintf(stderr, "%llu %s\n", static_cast<unsigned long long>(time), message);
+    };
+  }
+
+  // run soak
+  soak::report r = soak::run(o.soak);
+
+  // print per day resource curves
+  printf("%s\n", header(" ").c_str());
+  for (size_t i = 0; i < r.days.size(); i++) {
+    printf("%s\n", format(static_cast<int>(i + 1), r.days[i], " ").c_str());
+  }
+  if (!o.out.empty()) {
+    std::ofstream out(o.out);
+    out << header(",") << "\n";
+    for (size_t i = 0; i < r.days.size(); i++) {
+      out << format(static_cast<int>(i + 1), r.days[i], ",") << "\n";
+    }
+  }
+
+  // print speed
+  double simulated = o.soak.days * 86400;
+  printf("simulated=%.0fs seconds=%.1f speedup=%.0fx\n", simulated, r.seconds, simulated / r.seconds);
+
+  // fail on growing resources
+  std::vector<std::string> growing = soak::growth(r.days, o.window);
+  if (!growing.empty()) {
+    std::string names;
+    for (const auto &g : growing) {
+      names += (names.empty() ? "" : ", ") + g;
+    }
+    fprintf(stderr, "soak: resources grew on each of the last %d days: %s\n", o.window, names.c_str());
+    return 1;
+  }
+
+  return 0;
+}
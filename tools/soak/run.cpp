@@ -0,0 +1,332 @@
+#include "run.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <random>
+
+#include "device.h"
+
+extern "C" {
+#include <esp_system.h>
+}
+
+namespace soak {
+
+const char *const state_names[num_states] = {"offline", "calibrate", "standby", "move",
+                                             "automate", "reset",    "field",   "stream"};
+
+namespace {
+
+// the length of a day in ms
+const uint64_t day_length = 86400000;
+
+// the time in ms after boot at which the network comes up
+const uint64_t boot_online = 1000;
+
+// the sonar echo delay after the trigger in us and the echo width per cm
+const uint64_t echo_delay = 450;
+const double echo_per_cm = 58.7;
+
+// the pir rest value of the adc
+const int pir_rest = 590;
+
+// the encoder steps per spool rotation and the quadrature levels in counting order
+const int encoder_resolution = 20;
+const int quadrature[4][2] = {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+
+// the time the end stop is held when pressed by hand in ms
+const uint64_t end_hold = 200;
+
+// a scheduled event
+struct item {
+  uint64_t time;
+  event e;
+  bool operator>(const item &other) const { return time > other.time; }
+};
+
+// the cumulative counters of a health report
+struct health {
+  uint32_t dropped = 0;
+  uint32_t states[num_states] = {};
+};
+
+bool parse(const char *payload, size_t len, health &h) {
+  // read "key=value" pairs
+  std::string text(payload, len);
+  char *save = nullptr;
+  bool ok = false;
+  for (char *pair = strtok_r(&text[0], " ", &save); pair != nullptr; pair = strtok_r(nullptr, " ", &save)) {
+    char *eq = strchr(pair, '=');
+    if (eq == nullptr) {
+      continue;
+    }
+    *eq = 0;
+    auto value = static_cast<uint32_t>(strtoul(eq + 1, nullptr, 10));
+    if (strcmp(pair, "dropped") == 0) {
+      h.dropped = value;
+      ok = true;
+    }
+    for (int i = 0; i < num_states; i++) {
+      if (strcmp(pair, state_names[i]) == 0) {
+        h.states[i] = value;
+      }
+    }
+  }
+
+  return ok;
+}
+
+}  // namespace
+
+report run(const options &o) {
+  // prepare randomness
+  std::mt19937_64 random(o.seed);
+  std::normal_distribution<double> normal(0, 1);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  // prepare plant resting at the idle height
+  double height = 50;
+  double velocity = 0;
+  double alpha = 1 - std::exp(-1.0 / o.plant.inertia);
+  double step = o.plant.winding_length / encoder_resolution;
+  auto count = static_cast<int64_t>(std::floor(height / step));
+  int phase = 0;
+  uint64_t released = 0;
+  bool pressed = false;
+
+  // prepare visitors
+  sim::behavior behavior = o.behavior;
+  std::unique_ptr<sim::scenario> visitors;
+  sim::stimulus stimulus;
+
+  // prepare counters
+  report r;
+  day today;
+  health latest;
+  health midnight;
+  uint64_t flash = 0;
+  uint64_t allocs = 0;
+  std::deque<std::pair<uint64_t, int>> echoes;
+
+  // prepare device hooks
+  device::hooks h;
+  h.publish = [&](const char *topic, const void *payload, size_t len) {
+    today.publishes++;
+    if (strcmp(topic, "health") == 0) {
+      parse(static_cast<const char *>(payload), len, latest);
+    }
+  };
+  h.trigger = [&] {
+    // echo the nearest object below the light or the floor
+    double distance = stimulus.object >= 0 && stimulus.object < height ? height - stimulus.object : height;
+    distance = std::max(0.0, distance + normal(random) * o.plant.sonar_noise);
+    uint64_t rise = device::now() + echo_delay;
+    echoes.emplace_back(rise, 1);
+    echoes.emplace_back(rise + static_cast<uint64_t>(distance * echo_per_cm), 0);
+  };
+  h.adc = [&] {
+    // sample the pir magnitude of the visitors
+    int raw = pir_rest + static_cast<int>(std::lround(stimulus.activity + normal(random) * o.plant.pir_noise));
+    return std::max(0, std::min(1023, raw));
+  };
+  if (o.log) {
+    h.log = [&](const char *message) { o.log(device::now() / 1000, message); };
+  }
+
+  // boot device
+  auto start = std::chrono::steady_clock::now();
+  device::boot(h, o.seed);
+  const naos_config_t &config = device::config();
+  uint64_t interval = static_cast<uint64_t>(std::max(1, config.loop_interval));
+
+  // schedule boot, script and first day of drops
+  std::priority_queue<item, std::vector<item>, std::greater<item>> schedule;
+  event online;
+  online.action = "online";
+  schedule.push({boot_online, online});
+  for (const auto &e : o.events) {
+    schedule.push({e.time, e});
+  }
+
+  // run days
+  bool networked = false;
+  auto duration = static_cast<uint64_t>(o.days * static_cast<double>(day_length));
+  uint64_t dawn_at = 1;
+  uint64_t midnight_at = day_length;
+  uint64_t loop_at = interval;
+  for (uint64_t t = 1; t <= duration; t++) {
+    // schedule random network drops of the day
+    if (t == dawn_at) {
+      dawn_at += day_length;
+      for (int i = 0; i < o.drops; i++) {
+        auto at = t + static_cast<uint64_t>(unit(random) * static_cast<double>(day_length));
+        auto length = static_cast<uint64_t>(10000 + unit(random) * 590000);
+        event drop;
+        drop.action = "offline";
+        schedule.push({at, drop});
+        drop.action = "online";
+        schedule.push({at + length, drop});
+      }
+    }
+
+    // raise sonar echo edges within the millisecond
+    uint64_t us = t * 1000;
+    while (!echoes.empty() && echoes.front().first <= us) {
+      device::advance(echoes.front().first);
+      device::drive(GPIO_NUM_22, echoes.front().second);
+      echoes.pop_front();
+    }
+    device::advance(us);
+
+    // apply scripted events
+    while (!schedule.empty() && schedule.top().time <= t) {
+      item i = schedule.top();
+      schedule.pop();
+      if (i.e.every > 0) {
+        schedule.push({i.time + i.e.every, i.e});
+      }
+      const event &e = i.e;
+      today.events++;
+      if (e.action == "offline" && networked) {
+        networked = false;
+        config.offline_callback();
+      } else if (e.action == "online" && !networked) {
+        networked = true;
+        config.online_callback();
+      } else if (e.action == "param" && networked) {
+        device::update(e.args[0], e.args[1]);
+      } else if (e.action == "command" && networked) {
+        std::string payload;
+        for (size_t a = 1; a < e.args.size(); a++) {
+          payload += (a > 1 ? " " : "") + e.args[a];
+        }
+        device::message(e.args[0], payload, NAOS_LOCAL);
+      } else if (e.action == "end") {
+        height = o.top;
+        velocity = 0;
+        released = t + end_hold;
+        pressed = true;
+        device::drive(GPIO_NUM_13, 1);
+      } else if (e.action == "visitors") {
+        behavior.arrivals = atof(e.args[0].c_str());
+        visitors.reset(behavior.arrivals > 0 ? new sim::scenario(behavior, random()) : nullptr);
+        stimulus = sim::stimulus();
+      }
+    }
+
+    // advance visitors
+    if (visitors) {
+      stimulus = visitors->step();
+    }
+
+    // move winch towards the speed of the current duty (first order lag)
+    int direction = device::level(GPIO_NUM_14) ? 1 : device::level(GPIO_NUM_16) ? -1 : 0;
+    double duty = direction != 0 ? device::duty(LEDC_CHANNEL_0) / 4.0 : 0;
+    if (duty > 0 || velocity != 0) {
+      double speed = 0;
+      if (direction > 0 && duty > o.plant.up_offset) {
+        speed = (duty - o.plant.up_offset) / o.plant.up_gain;
+      } else if (direction < 0 && duty > o.plant.down_offset) {
+        speed = -(duty - o.plant.down_offset) / o.plant.down_gain;
+      }
+      velocity += (speed - velocity) * alpha;
+      if (speed == 0 && std::abs(velocity) < 1e-6) {
+        velocity = 0;
+      }
+      double next = std::max(0.0, std::min(o.top, height + velocity / 1000));
+      today.travel += std::abs(next - height);
+      height = next;
+
+      // raise quadrature steps, the encoder counts down when the light rises
+      auto target = static_cast<int64_t>(std::floor(height / step));
+      while (count != target) {
+        phase = (phase + (target > count ? 3 : 1)) % 4;
+        count += target > count ? 1 : -1;
+        device::drive(GPIO_NUM_23, quadrature[phase][0]);
+        device::drive(GPIO_NUM_25, quadrature[phase][1]);
+      }
+    }
+
+    // press end stop at the top and release it below
+    if (height >= o.top && !pressed) {
+      pressed = true;
+      device::drive(GPIO_NUM_13, 1);
+    } else if (height < o.top && pressed && t >= released) {
+      pressed = false;
+      device::drive(GPIO_NUM_13, 0);
+    }
+
+    // resume tasks, run the naos loop while networked and resume notified tasks
+    if (device::wake() <= us) {
+      device::run();
+    }
+    bool tick = t == loop_at;
+    if (tick) {
+      loop_at += interval;
+    }
+    if (networked && tick) {
+      config.loop_callback();
+      if (device::wake() <= us) {
+        device::run();
+      }
+    }
+
+    // complete day
+    if (t == midnight_at) {
+      midnight_at += day_length;
+      const device::heap &heap = device::allocations();
+      today.heap = heap.live;
+      today.min_heap = esp_get_minimum_free_heap_size();
+      today.allocs = heap.allocs - allocs;
+      today.stack = device::stack();
+      today.queue = device::queue();
+      today.dropped = latest.dropped - midnight.dropped;
+      today.flash = device::flash() - flash;
+      for (int i = 0; i < num_states; i++) {
+        today.states[i] = latest.states[i] - midnight.states[i];
+      }
+      r.days.push_back(today);
+
+      // reset counters
+      today = day();
+      midnight = latest;
+      flash = device::flash();
+      allocs = heap.allocs;
+    }
+  }
+
+  // measure duration
+  r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  return r;
+}
+
+std::vector<std::string> growth(const std::vector<day> &days, int window) {
+  // check resources over the last days
+  std::vector<std::string> names;
+  if (window < 1 || days.size() < static_cast<size_t>(window) + 1) {
+    return names;
+  }
+  auto grows = [&](const char *name, const std::function<double(const day &)> &value) {
+    for (size_t i = days.size() - static_cast<size_t>(window); i < days.size(); i++) {
+      if (value(days[i]) <= value(days[i - 1])) {
+        return;
+      }
+    }
+    names.emplace_back(name);
+  };
+  grows("heap", [](const day &d) { return static_cast<double>(d.heap); });
+  grows("min-heap", [](const day &d) { return -static_cast<double>(d.min_heap); });
+  grows("stack", [](const day &d) { return static_cast<double>(d.stack); });
+  grows("queue", [](const day &d) { return d.queue; });
+  grows("dropped", [](const day &d) { return d.dropped; });
+
+  return names;
+}
+
+}  // namespace soak
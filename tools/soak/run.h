@@ -0,0 +1,148 @@
+#ifndef SOAK_RUN_H
+#define SOAK_RUN_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "script.h"
+#include "sim/plant.h"
+#include "sim/visitor.h"
+
+namespace soak {
+
+/**
+ * The number of firmware states (OFFLINE to STREAM).
+ */
+const int num_states = 8;
+
+/**
+ * The names of the firmware states as used in health reports.
+ */
+extern const char *const state_names[num_states];
+
+/**
+ * The soak configuration.
+ */
+struct options {
+  /**
+   * The simulated duration in days.
+   */
+  double days = 7;
+
+  /**
+   * The seed of the device, the plant noise, the visitors and the network drops.
+   */
+  uint64_t seed = 1;
+
+  /**
+   * The scripted events.
+   */
+  std::vector<event> events;
+
+  /**
+   * The number of random network drops per day lasting 10 s to 10 min.
+   */
+  int drops = 4;
+
+  /**
+   * The plant and the visitor behavior (the arrivals are set by the script).
+   */
+  sim::plant plant;
+  sim::behavior behavior;
+
+  /**
+   * The height of the end stop in cm.
+   */
+  double top = 200;
+
+  /**
+   * Called for every firmware log message if set.
+   */
+  std::function<void(uint64_t time, const char *message)> log;
+};
+
+/**
+ * The resources and activity of one simulated day.
+ */
+struct day {
+  /**
+   * The live firmware heap in bytes at the end of the day and the lowest free heap since boot.
+   */
+  size_t heap = 0;
+  uint32_t min_heap = 0;
+
+  /**
+   * The firmware allocations during the day.
+   */
+  uint64_t allocs = 0;
+
+  /**
+   * The deepest task stack in bytes since boot.
+   */
+  size_t stack = 0;
+
+  /**
+   * The peak queue depth during the day.
+   */
+  int queue = 0;
+
+  /**
+   * The bus events dropped, the flash writes, the publishes and the scripted events during the day.
+   */
+  uint32_t dropped = 0;
+  uint64_t flash = 0;
+  uint64_t publishes = 0;
+  uint64_t events = 0;
+
+  /**
+   * The travelled cable length in cm during the day.
+   */
+  double travel = 0;
+
+  /**
+   * The time in ms per state during the day as reported by the health reports.
+   */
+  uint32_t states[num_states] = {};
+};
+
+/**
+ * The result of a soak.
+ */
+struct report {
+  /**
+   * The completed days.
+   */
+  std::vector<day> days;
+
+  /**
+   * The wall clock duration in seconds.
+   */
+  double seconds = 0;
+};
+
+/**
+ * Boot the firmware on the emulated device and run it through the scripted events against the plant and the
+ * visitors. The firmware is advanced at its loop interval, its tasks are resumed when notified or due and sonar
+ * echoes, encoder steps and the end stop are raised as interrupts. As the firmware keeps its state in globals a soak
+ * can only be run once per process.
+ *
+ * @param o The options.
+ * @return The report.
+ */
+report run(const options &o);
+
+/**
+ * Find resources that grew on each of the last days: the live heap, the stack, the peak queue depth and the dropped
+ * events grow when they increase and the free heap grows when it decreases.
+ *
+ * @param days The days.
+ * @param window The number of days that must each grow.
+ * @return The names of the growing resources.
+ */
+std::vector<std::string> growth(const std::vector<day> &days, int window);
+
+}  // namespace soak
+
+#endif  // SOAK_RUN_H
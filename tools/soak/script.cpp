@@ -0,0 +1,142 @@
+#include "script.h"
+
+#include <cctype>
+#include <sstream>
+
+namespace soak {
+
+namespace {
+
+// the arguments required per action
+struct action {
+  const char *name;
+  size_t args;
+};
+
+const action actions[] = {
+    {"offline", 0}, {"online", 0}, {"param", 2}, {"command", 1}, {"end", 0}, {"visitors", 1},
+};
+
+}  // namespace
+
+const char *const default_script = R"(# the floor opens at 10:00 and closes at 18:00 with automation during opening hours
+9h50m every 1d param automate 1
+10h every 1d visitors 2
+13h every 1d visitors 4
+15h every 1d visitors 2
+18h every 1d visitors 0
+18h10m every 1d param automate 0
+
+# the network restarts every night
+3h every 1d offline
+3h2m every 1d online
+
+# an operator tweaks the motion thresholds and the health interval
+12h every 1d param pir-high 450
+14h every 1d param pir-high 400
+1d4h every 3d param health-interval 30000
+2d4h every 3d param health-interval 60000
+
+# evening shows with scenes, flashes and fields
+19h every 1d command scene-store 1 120 0 0 0 512 2000 0
+19h1m every 1d command scene 1
+19h5m every 1d command flash 0 0 0 1023 200
+19h6m every 1d command fade 200 100 0 0 1000
+19h10m every 1d command field wave 120 20 300 10000
+19h40m every 1d command stop
+20h every 1d command scene-record 2 1000
+21h every 1d command move 60
+
+# the end stop gets hit by hand every other day
+6h every 2d end
+
+# weekly manual calibration
+5h every 7d command calibrate
+)";
+
+bool duration(const std::string &text, uint64_t &ms) {
+  // parse number and unit pairs
+  ms = 0;
+  size_t i = 0;
+  while (i < text.size()) {
+    // read number
+    if (!isdigit(static_cast<unsigned char>(text[i]))) {
+      return false;
+    }
+    uint64_t n = 0;
+    while (i < text.size() && isdigit(static_cast<unsigned char>(text[i]))) {
+      n = n * 10 + static_cast<uint64_t>(text[i++] - '0');
+    }
+
+    // read unit
+    std::string unit;
+    while (i < text.size() && isalpha(static_cast<unsigned char>(text[i]))) {
+      unit += text[i++];
+    }
+    if (unit == "d") {
+      n *= 86400000;
+    } else if (unit == "h") {
+      n *= 3600000;
+    } else if (unit == "m") {
+      n *= 60000;
+    } else if (unit == "s") {
+      n *= 1000;
+    } else if (!unit.empty() && unit != "ms") {
+      return false;
+    }
+    ms += n;
+  }
+
+  return !text.empty();
+}
+
+bool parse(const std::string &text, std::vector<event> &events, std::string &error) {
+  // parse lines
+  std::istringstream in(text);
+  std::string line;
+  for (int number = 1; std::getline(in, line); number++) {
+    // strip comment and split words
+    line = line.substr(0, line.find('#'));
+    std::istringstream words(line);
+    std::vector<std::string> w;
+    for (std::string word; words >> word;) {
+      w.push_back(word);
+    }
+    if (w.empty()) {
+      continue;
+    }
+
+    // read time and period
+    event e;
+    size_t next = 1;
+    bool ok = duration(w[0], e.time);
+    if (ok && w.size() > 2 && w[1] == "every") {
+      ok = duration(w[2], e.every) && e.every > 0;
+      next = 3;
+    }
+    if (!ok || next >= w.size()) {
+      error = "line " + std::to_string(number) + ": invalid time";
+      return false;
+    }
+
+    // read action and arguments
+    e.action = w[next];
+    e.args.assign(w.begin() + static_cast<long>(next) + 1, w.end());
+    bool known = false;
+    for (const auto &a : actions) {
+      if (e.action == a.name) {
+        known = e.args.size() >= a.args;
+      }
+    }
+    if (!known) {
+      error = "line " + std::to_string(number) + ": invalid action '" + e.action + "'";
+      return false;
+    }
+
+    events.push_back(e);
+  }
+
+  return true;
+}
+
+}  // namespace soak
@@ -0,0 +1,66 @@
+#ifndef SOAK_SCRIPT_H
+#define SOAK_SCRIPT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace soak {
+
+/**
+ * A scripted event.
+ */
+struct event {
+  /**
+   * The time of the first occurrence in ms since boot.
+   */
+  uint64_t time = 0;
+
+  /**
+   * The repetition period in ms or zero if the event occurs once.
+   */
+  uint64_t every = 0;
+
+  /**
+   * The action and its arguments:
+   *
+   * - "offline" and "online" drop and restore the network.
+   * - "param <name> <value>" sets a parameter like a remote update.
+   * - "command <topic> [payload]" delivers a command message.
+   * - "end" presses the end stop.
+   * - "visitors <rate>" sets the visitor arrivals per minute (0 empties the floor).
+   */
+  std::string action;
+  std::vector<std::string> args;
+};
+
+/**
+ * Parse a duration made of numbers with the units "d", "h", "m", "s" and "ms" (e.g. "1d2h30m"). A number without unit
+ * is in ms.
+ *
+ * @param text The text.
+ * @param ms The duration in ms.
+ * @return Whether the duration is valid.
+ */
+bool duration(const std::string &text, uint64_t &ms);
+
+/**
+ * Parse a script with one event per line: "<time> [every <period>] <action> [args...]". Comments ("#") and blank
+ * lines are ignored.
+ *
+ * @param text The script.
+ * @param events The parsed events.
+ * @param error The error message with the line number.
+ * @return Whether the script is valid.
+ */
+bool parse(const std::string &text, std::vector<event> &events, std::string &error);
+
+/**
+ * The default script: an installation that opens during the day with automation, restarts its network at night,
+ * tweaks parameters, shows scenes and fields in the evening, gets its end stop hit and calibrates weekly.
+ */
+extern const char *const default_script;
+
+}  // namespace soak
+
+#endif  // SOAK_SCRIPT_H
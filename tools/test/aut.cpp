@@ -0,0 +1,94 @@
+#include <cmath>
+#include <cstdio>
+
+#include "check.h"
+#include "sim/visitor.h"
+
+extern "C" {
+#include "aut.h"
+}
+
+namespace {
+
+aut_filter_t filter(double deadband, double hysteresis, double rate, uint32_t dwell) {
+  aut_filter_t f = {};
+  f.deadband = deadband;
+  f.hysteresis = hysteresis;
+  f.rate = rate;
+  f.dwell = dwell;
+  return f;
+}
+
+void test_deadband() {
+  // the first target passes and changes within the deadband are ignored
+  aut_filter_t f = filter(1, 0, 0, 0);
+  CHECK(aut_filter(&f, 100, 0) == 100);
+  CHECK(aut_filter(&f, 100.9, 10) == 100);
+  CHECK(aut_filter(&f, 99.1, 20) == 100);
+  CHECK(aut_filter(&f, 101.5, 30) == 101.5);
+}
+
+void test_rate() {
+  // changes are limited to the rate per elapsed time
+  aut_filter_t f = filter(0, 0, 10, 0);
+  aut_filter(&f, 100, 0);
+  CHECK_NEAR(aut_filter(&f, 150, 100), 101, 1e-9);
+  CHECK_NEAR(aut_filter(&f, 150, 600), 106, 1e-9);
+  CHECK_NEAR(aut_filter(&f, 50, 700), 105, 1e-9);
+}
+
+void test_reversal() {
+  // a reversal requires the hysteresis and the dwell since the last direction change
+  aut_filter_t f = filter(0, 4, 0, 1000);
+  aut_filter(&f, 100, 0);
+  CHECK(aut_filter(&f, 110, 10) == 110);
+  CHECK(aut_filter(&f, 107, 20) == 110);
+  CHECK(aut_filter(&f, 100, 500) == 110);
+  CHECK(aut_filter(&f, 100, 1010) == 100);
+
+  // the same direction is followed without dwell
+  CHECK(aut_filter(&f, 99, 1020) == 99);
+  CHECK(aut_filter(&f, 103, 1030) == 99);
+}
+
+void test_traces() {
+  // compare reversals and tracking of the conditioned and the raw target on the same visitor traces
+  sim::config filtered;
+  sim::config raw = filtered;
+  raw.target_deadband = 0;
+  raw.target_hysteresis = 0;
+  raw.target_rate = 0;
+  raw.target_dwell = 0;
+  sim::score f;
+  sim::score r;
+  const int traces = 8;
+  for (uint64_t seed = 1; seed <= traces; seed++) {
+    sim::score a = sim::simulate(filtered, sim::plant(), sim::behavior(), seed, 1800000);
+    sim::score b = sim::simulate(raw, sim::plant(), sim::behavior(), seed, 1800000);
+    f.reversals += a.reversals / traces;
+    f.response += a.response / traces;
+    f.contact += a.contact / traces;
+    r.reversals += b.reversals / traces;
+    r.response += b.response / traces;
+    r.contact += b.contact / traces;
+  }
+  printf("filtered reversals=%.2f/min response=%.0fms contact=%.3f\n", f.reversals, f.response, f.contact);
+  printf("raw      reversals=%.2f/min response=%.0fms contact=%.3f\n", r.reversals, r.response, r.contact);
+
+  // the filter saves reversals without losing the hand
+  CHECK(f.reversals < r.reversals);
+  CHECK(f.contact < r.contact + 0.1);
+}
+
+}  // namespace
+
+int main() {
+  test_deadband();
+  test_rate();
+  test_reversal();
+  test_traces();
+
+  printf("ok\n");
+
+  return 0;
+}
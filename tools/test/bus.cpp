@@ -0,0 +1,136 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "check.h"
+
+extern "C" {
+#include "bus.h"
+}
+
+namespace {
+
+struct event {
+  uint32_t seq;
+  uint32_t check;
+};
+
+BUS_TOPIC(small, event, 8);
+
+void publish(bus_topic_t *t, uint32_t seq) {
+  auto *e = static_cast<event *>(bus_claim(t));
+  e->seq = seq;
+  e->check = ~seq;
+  bus_commit(t);
+}
+
+void test_order() {
+  // a subscription only sees events published after subscribing
+  publish(&small, 100);
+  bus_sub_t s;
+  bus_subscribe(&s, &small);
+  CHECK(bus_next(&s) == nullptr);
+
+  // events are read in order
+  for (uint32_t i = 0; i < 5; i++) {
+    publish(&small, i);
+  }
+  for (uint32_t i = 0; i < 5; i++) {
+    auto *e = static_cast<const event *>(bus_next(&s));
+    CHECK(e != nullptr && e->seq == i);
+  }
+  CHECK(bus_next(&s) == nullptr);
+  CHECK(s.dropped == 0);
+}
+
+void test_overflow() {
+  // a subscriber that falls behind skips to the oldest event still in the ring
+  bus_sub_t s;
+  bus_subscribe(&s, &small);
+  for (uint32_t i = 0; i < 13; i++) {
+    publish(&small, i);
+  }
+  for (uint32_t i = 5; i < 13; i++) {
+    auto *e = static_cast<const event *>(bus_next(&s));
+    CHECK(e != nullptr && e->seq == i);
+  }
+  CHECK(bus_next(&s) == nullptr);
+  CHECK(s.dropped == 5);
+
+  // flushing discards pending events and keeps the count
+  publish(&small, 13);
+  publish(&small, 14);
+  bus_flush(&s);
+  CHECK(bus_next(&s) == nullptr);
+  CHECK(s.dropped == 5);
+  publish(&small, 15);
+  auto *e = static_cast<const event *>(bus_next(&s));
+  CHECK(e != nullptr && e->seq == 15);
+}
+
+void test_wrap() {
+  // sequences wrap around without losing events
+  small.head = UINT32_MAX - 3;
+  bus_sub_t s;
+  bus_subscribe(&s, &small);
+  for (uint32_t i = 0; i < 6; i++) {
+    publish(&small, i);
+  }
+  CHECK(small.head == 2);
+  for (uint32_t i = 0; i < 6; i++) {
+    auto *e = static_cast<const event *>(bus_next(&s));
+    CHECK(e != nullptr && e->seq == i);
+  }
+  CHECK(s.dropped == 0);
+}
+
+BUS_TOPIC(shared, event, 32);
+
+void test_threads() {
+  // a publisher thread bursts ten events per ms while the subscriber polls every ms like the naos loop
+  bus_sub_t s;
+  bus_subscribe(&s, &shared);
+  std::atomic<bool> done{false};
+  std::thread publisher([&] {
+    for (uint32_t i = 0; i < 2000; i++) {
+      publish(&shared, i);
+      if (i % 10 == 9) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    done = true;
+  });
+  uint32_t next = 0;
+  uint32_t received = 0;
+  for (;;) {
+    bool finished = done;
+    const void *p;
+    while ((p = bus_next(&s)) != nullptr) {
+      auto *e = static_cast<const event *>(p);
+      CHECK(e->check == ~e->seq);
+      CHECK(e->seq >= next);
+      next = e->seq + 1;
+      received++;
+    }
+    if (finished) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  publisher.join();
+  CHECK(next == 2000);
+  CHECK(received + s.dropped == 2000);
+}
+
+}  // namespace
+
+int main() {
+  test_order();
+  test_overflow();
+  test_wrap();
+  test_threads();
+
+  printf("ok\n");
+
+  return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Abort the test with the location and the expression if the condition does not hold.
+ */
+#define CHECK(cond)                                                    \
+  do {                                                                 \
+    if (!(cond)) {                                                     \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(1);                                                         \
+    }                                                                  \
+  } while (0)
+
+/**
+ * Check that two values are within the tolerance of each other.
+ */
+#define CHECK_NEAR(a, b, tol) CHECK((a) - (b) <= (tol) && (b) - (a) <= (tol))
+
+#endif  // TEST_CHECK_H
@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "client/lights.h"
+#include "client/mqtt.h"
+
+namespace {
+
+void test_match() {
+  // exact and wildcard filters
+  CHECK(client::match("lights/1/state", "lights/1/state"));
+  CHECK(!client::match("lights/1/state", "lights/2/state"));
+  CHECK(client::match("lights/+/state", "lights/12/state"));
+  CHECK(!client::match("lights/+/state", "lights/12/position"));
+  CHECK(!client::match("lights/+", "lights/1/state"));
+  CHECK(client::match("lights/#", "lights/1/state"));
+  CHECK(client::match("lights/#", "lights"));
+  CHECK(!client::match("lights/1", "lights"));
+}
+
+void test_commands() {
+  // commands use the firmware topics and payloads
+  auto c = client::command::move(120.5);
+  CHECK(c.topic == "move" && c.payload == "120.5");
+  CHECK(client::command::up().payload == "up");
+  CHECK(client::command::stop().topic == "stop");
+  c = client::command::flash({1023, 0, 512, 0}, 250);
+  CHECK(c.topic == "flash" && c.payload == "1023 0 512 0 250");
+  c = client::command::fade({1, 2, 3, 4}, 5);
+  CHECK(c.topic == "fade" && c.payload == "1 2 3 4 5");
+  CHECK(client::command::automate(true).payload == "1");
+  c = client::command::set("max-velocity", 0.25);
+  CHECK(c.topic == "naos/set/max-velocity" && c.payload == "0.25");
+  CHECK(client::command::set("automate", false).payload == "0");
+  CHECK(client::command::set("rate", 10L).payload == "10");
+
+  // light lists
+  std::vector<int> ids;
+  CHECK(client::parse("1,3,5-7", 0, ids) && ids == std::vector<int>({1, 3, 5, 6, 7}));
+  CHECK(client::parse("all", 3, ids) && ids == std::vector<int>({1, 2, 3}));
+  CHECK(!client::parse("all", 0, ids));
+  CHECK(!client::parse("3-1", 0, ids));
+  CHECK(!client::parse("x", 0, ids));
+}
+
+void test_telemetry() {
+  // split topics without copying
+  std::string topic = "lights/42/position";
+  std::string payload = "123.5";
+  client::sample s;
+  CHECK(client::parse("lights", topic, payload, s));
+  CHECK(s.light == 42 && s.name == "position" && s.payload.data() == payload.data());
+  CHECK(!client::parse("lights", "lights/x/position", payload, s));
+  CHECK(!client::parse("lights", "light/1/position", payload, s));
+  CHECK(!client::parse("lights", "lights/1", payload, s));
+
+  // read pairs
+  client::pairs p("heap=1200 flash=3 state=MOVE");
+  double heap = 0;
+  std::string_view state;
+  CHECK(p.get("heap", heap) && heap == 1200);
+  CHECK(p.get("state", state) && state == "MOVE");
+  CHECK(!p.get("state", heap));
+  CHECK(!p.get("missing", state));
+
+  // read plans
+  client::plan pl;
+  CHECK(client::parse("1000 10.5 -0.2 120 0.3 0.1", pl));
+  CHECK(pl.start == 1000 && pl.position == 10.5 && pl.velocity == -0.2 && pl.target == 120);
+  CHECK(pl.max_velocity == 0.3 && pl.max_acceleration == 0.1);
+  CHECK(!client::parse("1000 10.5 -0.2 120 0.3", pl));
+  CHECK(!client::parse("1000 10.5 -0.2 120 0.3 0.1 x", pl));
+}
+
+void test_lights() {
+  // fleet commands are published as a single batch
+  client::loopback t;
+  client::lights fleet(t, "lights");
+  fleet.send({1, 2, 3}, client::command::flash({1, 2, 3, 4}, 100)).get();
+  auto sent = t.take();
+  CHECK(sent.size() == 3);
+  CHECK(sent[2].topic == "lights/3/flash" && sent[2].payload == "1 2 3 4 100");
+
+  // subscriptions receive typed telemetry
+  double position = 0;
+  int light = 0;
+  fleet.on_position([&](int l, double p) {
+    light = l;
+    position = p;
+  });
+  t.inject("lights/7/position", "55.25");
+  CHECK(light == 7 && position == 55.25);
+  t.inject("lights/7/distance", "10");
+  CHECK(position == 55.25);
+
+  // a move completes once all lights left MOVE
+  auto done = fleet.move({1, 2}, 100, std::chrono::seconds(5));
+  CHECK(t.take().size() == 2);
+  t.inject("lights/1/state", "MOVE");
+  t.inject("lights/2/state", "STANDBY");
+  t.inject("lights/2/telemetry", "position=1 state=MOVE");
+  t.inject("lights/1/state", "STANDBY");
+  CHECK(done.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+  t.inject("lights/2/telemetry", "state=AUTOMATE");
+  CHECK(done.wait_for(std::chrono::seconds(1)) == std::future_status::ready && done.get());
+  CHECK(fleet.state(2) == "AUTOMATE");
+
+  // a calibration that never starts times out
+  auto failed = fleet.calibrate({3}, std::chrono::milliseconds(20));
+  CHECK(failed.wait_for(std::chrono::seconds(1)) == std::future_status::ready && !failed.get());
+}
+
+void test_mqtt() {
+  // start broker
+  client::broker b;
+  std::string error;
+  CHECK(b.start(0, error));
+
+  // connect a light and a client
+  client::options o;
+  o.port = b.port();
+  o.id = "light";
+  client::mqtt light(o);
+  CHECK(light.connect(error));
+  o.id = "client";
+  client::mqtt transport(o);
+  CHECK(transport.connect(error));
+
+  // the light reports its state in reply to commands
+  std::atomic<int> commands{0};
+  light.receive([&](std::string_view topic, std::string_view payload) {
+    commands++;
+    std::string prefix(topic.substr(0, topic.rfind('/')));
+    if (topic.substr(topic.rfind('/') + 1) == "move") {
+      light.publish({{prefix + "/state", "MOVE"}, {prefix + "/position", std::string(payload)},
+                     {prefix + "/state", "STANDBY"}});
+    }
+  });
+  light.subscribe("lights/+/move");
+  light.subscribe("lights/+/stop");
+
+  // wait for the subscriptions to reach the broker
+  client::lights fleet(transport, "lights");
+  std::atomic<int> positions{0};
+  fleet.on_position([&](int, double) { positions++; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // move and stop three lights
+  auto moved = fleet.move({1, 2, 3}, 42, std::chrono::seconds(5));
+  CHECK(moved.get());
+  fleet.send({1, 2, 3}, client::command::stop()).get();
+  for (int i = 0; i < 100 && commands < 6; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(commands == 6);
+  CHECK(positions == 3);
+  CHECK(b.forwarded() >= 15);
+
+  // pending publishes fail after closing
+  transport.close();
+  CHECK(!transport.connected());
+  bool failed = false;
+  try {
+    transport.publish({{"lights/1/stop", ""}}).get();
+  } catch (const std::exception &e) {
+    failed = true;
+  }
+  CHECK(failed);
+  light.close();
+  b.stop();
+}
+
+}  // namespace
+
+int main() {
+  test_match();
+  test_commands();
+  test_telemetry();
+  test_lights();
+  test_mqtt();
+
+  printf("ok\n");
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstdio>
+
+#include "check.h"
+#include "crowd/world.h"
+
+namespace {
+
+crowd::world single(const crowd::params &p) {
+  // create a floor with a single light in the center
+  crowd::light l;
+  l.x = 200;
+  l.y = 200;
+  l.height = 100;
+  return crowd::world(p, {l}, 400, 400, 1);
+}
+
+void run(crowd::world &w, double seconds) {
+  while (static_cast<double>(w.time()) < seconds * 1000) {
+    w.step(1);
+  }
+}
+
+void test_empty() {
+  // an empty floor rests the pir and echoes the floor
+  crowd::params p;
+  p.sonar_dropout = 0;
+  crowd::world w = single(p);
+  run(w, 1);
+  CHECK(w.lights()[0].sampled == 1000);
+  CHECK(std::abs(w.lights()[0].pir - 590) < 6 * p.pir_noise);
+  CHECK_NEAR(w.lights()[0].pulse, 100 * 58.7, 6 * p.sonar_noise * 58.7);
+}
+
+void test_reach() {
+  // a reaching hand is echoed and triggers the pir
+  crowd::params p;
+  p.sonar_dropout = 0;
+  crowd::world w = single(p);
+  crowd::agent a;
+  a.x = a.gx = 245;
+  a.y = a.gy = 200;
+  a.head = 170;
+  a.activity = crowd::reaching;
+  a.hand = 40;
+  a.reach = 80;
+  a.target = 0;
+  a.until = 1e9;
+  w.add(a);
+  run(w, 5);
+  CHECK_NEAR(w.agents()[0].hand, 80, 1e-9);
+  CHECK_NEAR(w.lights()[0].pulse, 20 * 58.7, 6 * p.sonar_noise * 58.7);
+  CHECK(std::abs(w.lights()[0].pir - 590) > 150);
+
+  // a child under the light occludes a hand
+  w = single(p);
+  a.x = a.gx = 300;
+  a.hand = 80;
+  w.add(a);
+  crowd::agent c;
+  c.x = c.gx = 200;
+  c.y = c.gy = 200;
+  c.head = 90;
+  c.activity = crowd::standing;
+  c.until = 1e9;
+  w.add(c);
+  run(w, 6);
+  CHECK_NEAR(w.lights()[0].pulse, 10 * 58.7, 6 * p.sonar_noise * 58.7);
+}
+
+void test_crowd() {
+  // agents stay on the floor and keep their distance
+  double width = 0, depth = 0;
+  auto lights = crowd::grid(16, 250, 100, width, depth);
+  CHECK(width == 1000 && depth == 1000);
+  crowd::world w(crowd::params(), lights, width, depth, 1);
+  w.populate(200);
+  CHECK(w.agents().size() == 200);
+  run(w, 30);
+  size_t close = 0;
+  for (size_t i = 0; i < w.agents().size(); i++) {
+    const crowd::agent &a = w.agents()[i];
+    CHECK(a.x >= 0 && a.x <= width && a.y >= 0 && a.y <= depth);
+    for (size_t j = i + 1; j < w.agents().size(); j++) {
+      if (std::hypot(a.x - w.agents()[j].x, a.y - w.agents()[j].y) < 20) {
+        close++;
+      }
+    }
+  }
+  CHECK(close < 10);
+
+  // every light has been sampled at its phase
+  for (const auto &l : w.lights()) {
+    CHECK(l.sampled == 30000 || l.sampled == 29950);
+  }
+}
+
+void test_threads() {
+  // results do not depend on the number of threads
+  double width = 0, depth = 0;
+  auto lights = crowd::grid(64, 200, 120, width, depth);
+  crowd::world a(crowd::params(), lights, width, depth, 7);
+  crowd::world b(crowd::params(), lights, width, depth, 7);
+  a.populate(1000);
+  b.populate(1000);
+  for (int i = 0; i < 100; i++) {
+    a.step(1);
+    b.step(4);
+  }
+  for (size_t i = 0; i < a.agents().size(); i++) {
+    CHECK(a.agents()[i].x == b.agents()[i].x && a.agents()[i].y == b.agents()[i].y);
+  }
+  for (size_t i = 0; i < a.lights().size(); i++) {
+    CHECK(a.lights()[i].pir == b.lights()[i].pir && a.lights()[i].pulse == b.lights()[i].pulse);
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_empty();
+  test_reach();
+  test_crowd();
+  test_threads();
+
+  printf("ok\n");
+
+  return 0;
+}
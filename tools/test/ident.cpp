@@ -0,0 +1,59 @@
+#include <cmath>
+#include <cstdio>
+
+#include "check.h"
+#include "ident/fit.h"
+
+namespace {
+
+void test_trace() {
+  // round trip rows through a file
+  std::vector<ident::row> rows = {{10, 0, 0, 100.5f}, {20, 1200, 1, -1}, {30, -800, -2, 99.0f}};
+  CHECK(ident::write("ident-test.csv", rows));
+  std::vector<ident::row> read;
+  CHECK(ident::read("ident-test.csv", read));
+  remove("ident-test.csv");
+  CHECK(read.size() == 3);
+  CHECK(read[1].time == 20 && read[1].duty == 1200 && read[1].encoder == 1 && read[1].sonar < 0);
+  CHECK(read[2].duty == -800 && read[2].encoder == -2 && read[2].sonar == 99.0f);
+}
+
+void test_fit() {
+  // record a light with a plant that differs from the firmware model
+  sim::plant truth;
+  truth.up_gain = 80;
+  truth.up_offset = 120;
+  truth.down_gain = 52;
+  truth.down_offset = 75;
+  truth.inertia = 110;
+  truth.winding_length = 8.2;
+  truth.sonar_noise = 1.5;
+  auto rows = ident::record(sim::config(), truth, sim::behavior(), 3, 3600000);
+  CHECK(!rows.empty());
+
+  // fit from the defaults
+  ident::result r = ident::fit(rows, sim::plant());
+  printf("up=%.2f/%.2f down=%.2f/%.2f inertia=%.1f winding=%.3f noise=%.3f rms=%.4f windows=%zu it=%d\n",
+         r.plant.up_gain, r.plant.up_offset, r.plant.down_gain, r.plant.down_offset, r.plant.inertia,
+         r.plant.winding_length, r.plant.sonar_noise, r.rms, r.windows, r.iterations);
+  CHECK(r.windows > 1000);
+  CHECK(std::abs(r.plant.winding_length / truth.winding_length - 1) < 0.01);
+  CHECK(std::abs(r.plant.sonar_noise / truth.sonar_noise - 1) < 0.1);
+  CHECK(std::abs(r.plant.up_gain / truth.up_gain - 1) < 0.05);
+  CHECK(std::abs(r.plant.up_offset / truth.up_offset - 1) < 0.05);
+  CHECK(std::abs(r.plant.down_gain / truth.down_gain - 1) < 0.05);
+  CHECK(std::abs(r.plant.down_offset / truth.down_offset - 1) < 0.05);
+  CHECK(std::abs(r.plant.inertia / truth.inertia - 1) < 0.2);
+  CHECK_NEAR(r.radius, truth.winding_length / (2 * M_PI), 0.02);
+}
+
+}  // namespace
+
+int main() {
+  test_trace();
+  test_fit();
+
+  printf("ok\n");
+
+  return 0;
+}
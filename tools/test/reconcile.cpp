@@ -0,0 +1,194 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "check.h"
+#include "reconcile/reconciler.h"
+#include "soak/device.h"
+
+namespace {
+
+reconcile::schema light_schema() {
+  reconcile::schema s;
+  std::string error;
+  CHECK(reconcile::load(RECONCILE_DIR "/tm-lo.schema", s, error));
+  return s;
+}
+
+uint32_t reported(const std::string &payload) {
+  // read digest of a config report
+  size_t at = payload.find("digest=");
+  CHECK(at != std::string::npos);
+  return static_cast<uint32_t>(strtoul(payload.c_str() + at + 7, nullptr, 16));
+}
+
+void test_schema() {
+  // values are formatted like the firmware
+  reconcile::param p{"x", reconcile::kind::DOUBLE, ""};
+  std::string out;
+  CHECK(reconcile::normalize(p, "0.30", out) && out == "0.3");
+  CHECK(reconcile::normalize(p, "69.889081", out) && out == "69.8891");
+  CHECK(!reconcile::normalize(p, "x", out));
+  p.type = reconcile::kind::BOOL;
+  CHECK(reconcile::normalize(p, "true", out) && out == "1");
+  CHECK(!reconcile::normalize(p, "yes", out));
+  p.type = reconcile::kind::LONG;
+  CHECK(reconcile::normalize(p, "-1", out) && out == "-1");
+  CHECK(!reconcile::normalize(p, "1.5", out));
+
+  // invalid schemas are rejected
+  reconcile::schema s;
+  std::string error;
+  CHECK(!reconcile::parse("x bool 1\n", s, error));
+  CHECK(!reconcile::parse("type a\nx float 1\n", s, error) && error.find("line 2") == 0);
+  CHECK(reconcile::parse("# test\ntype a\n\nx string\n", s, error) && s.params.size() == 1 && s.params[0].value.empty());
+}
+
+void test_firmware() {
+  // boot the firmware and capture its config reports
+  std::string config;
+  soak::device::hooks h;
+  h.publish = [&](const char *topic, const void *payload, size_t len) {
+    if (strcmp(topic, "config") == 0) {
+      config.assign(static_cast<const char *>(payload), len);
+    }
+  };
+  h.trigger = [] {};
+  h.adc = [] { return 200; };
+  soak::device::boot(h, 1);
+  const naos_config_t &c = soak::device::config();
+  c.online_callback();
+  soak::device::run();
+
+  // the schema matches the parameter table of the firmware
+  reconcile::schema s = light_schema();
+  CHECK(s.type == c.device_type && s.version == c.firmware_version);
+  CHECK(s.params.size() == c.num_parameters);
+  for (size_t i = 0; i < s.params.size(); i++) {
+    CHECK(s.params[i].name == c.parameters[i].name);
+  }
+
+  // the digest of the defaults matches the report
+  CHECK(!config.empty());
+  CHECK(reported(config) == reconcile::digest(s, reconcile::defaults(s)));
+
+  // the digest matches again after updates settled
+  config.clear();
+  CHECK(soak::device::update("base-height", "110.0"));
+  CHECK(soak::device::update("automate", "1"));
+  for (uint64_t ms = 1; ms <= 600; ms++) {
+    soak::device::advance(ms * 1000);
+    c.loop_callback();
+    soak::device::run();
+  }
+  auto values = reconcile::defaults(s);
+  values[static_cast<size_t>(s.index("base-height"))] = "110";
+  values[static_cast<size_t>(s.index("automate"))] = "1";
+  CHECK(!config.empty() && reported(config) == reconcile::digest(s, values));
+}
+
+void run(reconcile::fleet &f, reconcile::reconciler &r, uint64_t &now, uint64_t until) {
+  // advance in 100 ms steps
+  for (; now < until; now += 100) {
+    f.step(now);
+    r.step(now);
+  }
+}
+
+void test_diff() {
+  // converged devices receive only the changed parameters
+  reconcile::schema s = light_schema();
+  reconcile::fleet f(s, 4);
+  reconcile::reconciler r(f, {s});
+  uint64_t now = 0;
+  run(f, r, now, 1000);
+  CHECK(r.converged() && r.count().devices[static_cast<int>(reconcile::status::CONVERGED)] == 4);
+  CHECK(r.count().messages == 0);
+  std::string error;
+  CHECK(r.want({}, "base-height", "110", error));
+  CHECK(r.want({2, 3}, "automate", "1", error));
+  CHECK(r.want({3}, "base-height", "90", error));
+  CHECK(!r.want({}, "missing", "1", error));
+  CHECK(!r.want({}, "automate", "maybe", error));
+  run(f, r, now, 3000);
+  CHECK(r.converged());
+  CHECK(r.count().messages == 6 && r.count().resyncs == 0);
+  CHECK(f.values(1)[static_cast<size_t>(s.index("base-height"))] == "110");
+  CHECK(f.values(3)[static_cast<size_t>(s.index("base-height"))] == "90");
+  CHECK(f.values(2)[static_cast<size_t>(s.index("automate"))] == "1");
+
+  // a device reset to defaults gets the diff against the defaults
+  for (const auto &p : s.params) {
+    f.set(2, p.name, p.value);
+  }
+  run(f, r, now, 5000);
+  CHECK(r.converged() && r.count().messages == 8 && r.count().resyncs == 0);
+
+  // a device with unknown values gets all parameters
+  f.set(4, "pir-low", "150");
+  f.set(4, "idle-light", "50");
+  run(f, r, now, 7000);
+  CHECK(r.converged() && r.count().resyncs == 1 && r.count().messages == 8 + s.params.size());
+
+  // other firmware versions are left alone
+  f.version(1, "0.9.0");
+  f.set(1, "pir-low", "150");
+  run(f, r, now, 9000);
+  CHECK(r.get(1) == reconcile::status::OUTDATED && r.converged());
+  CHECK(r.count().messages == 8 + s.params.size());
+}
+
+void test_concurrency() {
+  // at most the configured number of devices are pending
+  reconcile::schema s = light_schema();
+  reconcile::fleet f(s, 10);
+  reconcile::options o;
+  o.concurrency = 3;
+  reconcile::reconciler r(f, {s}, o);
+  std::string error;
+  CHECK(r.want({}, "coalesce", "1", error));
+  f.step(0);
+  r.step(0);
+  CHECK(r.count().devices[static_cast<int>(reconcile::status::PENDING)] == 3);
+  CHECK(f.updates() == 3);
+  uint64_t now = 0;
+  run(f, r, now, 3000);
+  CHECK(r.converged() && f.updates() == 10);
+}
+
+void test_backoff() {
+  // lost messages are retried with a growing delay
+  reconcile::schema s = light_schema();
+  reconcile::fleet f(s, 50, 0.3, 7);
+  reconcile::options o;
+  o.timeout = 1000;
+  o.backoff = 200;
+  reconcile::reconciler r(f, {s}, o);
+  std::string error;
+  CHECK(r.want({}, "twin", "1", error));
+  CHECK(r.want({}, "twin-bound", "1.5", error));
+
+  // devices whose report is lost are retried
+  uint64_t now = 0;
+  run(f, r, now, 60000);
+  auto c = r.count();
+  CHECK(r.converged() && c.devices[static_cast<int>(reconcile::status::CONVERGED)] == 50);
+  CHECK(c.retries > 0 && c.pushes == 50 + c.retries);
+  for (int id = 1; id <= 50; id++) {
+    CHECK(f.values(id)[static_cast<size_t>(s.index("twin-bound"))] == "1.5");
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_schema();
+  test_firmware();
+  test_diff();
+  test_concurrency();
+  test_backoff();
+
+  printf("ok\n");
+
+  return 0;
+}
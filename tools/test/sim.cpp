@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <string>
+
+#include "check.h"
+#include "sim/light.h"
+#include "sim/visitor.h"
+
+namespace {
+
+void test_idle() {
+  // a light without visitors stays at idle height
+  sim::config c;
+  sim::light l(c, sim::plant(), 1);
+  for (int i = 0; i < 60000; i++) {
+    l.step(sim::stimulus());
+  }
+  CHECK_NEAR(l.height(), c.idle_height, 1);
+  CHECK(!l.motion());
+  CHECK(l.statistics().reversals == 0);
+}
+
+void test_approach() {
+  // a standing visitor raises the light to base height
+  sim::config c;
+  sim::light l(c, sim::plant(), 1);
+  sim::stimulus s;
+  s.activity = 320;
+  for (int i = 0; i < 20000; i++) {
+    l.step(s);
+  }
+  CHECK(l.motion());
+  CHECK_NEAR(l.height(), c.base_height, 2);
+
+  // a hand below the light raises it to keep the approach target
+  s.object = 90;
+  for (int i = 0; i < 20000; i++) {
+    l.step(s);
+  }
+  CHECK_NEAR(l.height(), 90 + c.approach_target, 2);
+}
+
+void test_simulate() {
+  // the defaults keep visitors out of contact most of the time
+  sim::score r = sim::simulate(sim::config(), sim::plant(), sim::behavior(), 1, 600000);
+  CHECK(r.reaches > 0);
+  CHECK(r.contact < 0.5);
+  CHECK(r.response > 0);
+
+  // simulations are deterministic
+  sim::score r2 = sim::simulate(sim::config(), sim::plant(), sim::behavior(), 1, 600000);
+  CHECK(r.response == r2.response && r.reversals == r2.reversals && r.travel == r2.travel);
+}
+
+void test_plant() {
+  // round trip plant model through a file
+  sim::plant p;
+  p.up_gain = 71.5;
+  p.inertia = 120;
+  p.sonar_noise = 2.25;
+  std::string path = "sim-test.model";
+  CHECK(sim::save(path, p));
+  sim::plant q;
+  CHECK(sim::load(path, q));
+  CHECK_NEAR(q.up_gain, 71.5, 1e-9);
+  CHECK_NEAR(q.inertia, 120, 1e-9);
+  CHECK_NEAR(q.sonar_noise, 2.25, 1e-9);
+  remove(path.c_str());
+
+  // reject unknown names
+  CHECK(!sim::set(q, "foo", 1));
+}
+
+void test_profile() {
+  // format profile payload
+  sim::config c;
+  CHECK(sim::set(c, "approach-range", 35.25));
+  CHECK(sim::set(c, "pir-interval", 2500.4));
+  CHECK(!sim::set(c, "foo", 1));
+  CHECK(sim::profile(c, {"approach-range", "pir-interval"}) == "approach-range=35.2 pir-interval=2500");
+}
+
+}  // namespace
+
+int main() {
+  test_idle();
+  test_approach();
+  test_simulate();
+  test_plant();
+  test_profile();
+
+  printf("ok\n");
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+#include <cstdio>
+
+#include "check.h"
+#include "soak/run.h"
+
+namespace {
+
+void test_duration() {
+  // units combine and a bare number is in ms
+  uint64_t ms = 0;
+  CHECK(soak::duration("1d2h30m", ms) && ms == 95400000);
+  CHECK(soak::duration("1m30s250ms", ms) && ms == 90250);
+  CHECK(soak::duration("500", ms) && ms == 500);
+  CHECK(!soak::duration("", ms));
+  CHECK(!soak::duration("3x", ms));
+  CHECK(!soak::duration("h", ms));
+}
+
+void test_parse() {
+  // events are parsed with their period and arguments
+  std::vector<soak::event> events;
+  std::string error;
+  CHECK(soak::parse("# comment\n\n1h every 1d param pir-high 450\n2h30m command move 60\n3h end\n", events, error));
+  CHECK(events.size() == 3);
+  CHECK(events[0].time == 3600000 && events[0].every == 86400000 && events[0].action == "param");
+  CHECK(events[0].args.size() == 2 && events[0].args[0] == "pir-high" && events[0].args[1] == "450");
+  CHECK(events[1].time == 9000000 && events[1].every == 0 && events[1].args.size() == 2);
+  CHECK(events[2].action == "end" && events[2].args.empty());
+
+  // invalid lines are reported with their number
+  events.clear();
+  CHECK(!soak::parse("1h online\n2h jump\n", events, error));
+  CHECK(error.find('2') != std::string::npos);
+  CHECK(!soak::parse("1h param pir-high\n", events, error));
+  CHECK(!soak::parse("1h every online\n", events, error));
+
+  // the default script is valid
+  CHECK(soak::parse(soak::default_script, events, error));
+}
+
+void test_growth() {
+  // resources must grow on each day of the window
+  std::vector<soak::day> days(5);
+  for (size_t i = 0; i < days.size(); i++) {
+    days[i].heap = 100;
+    days[i].min_heap = 1000;
+    days[i].queue = 2;
+  }
+  CHECK(soak::growth(days, 3).empty());
+  days[2].heap = 110;
+  days[3].heap = 120;
+  days[4].heap = 130;
+  days[4].min_heap = 990;
+  auto names = soak::growth(days, 3);
+  CHECK(names.size() == 1 && names[0] == "heap");
+  CHECK(soak::growth(days, 4).empty());
+  days[2].min_heap = 998;
+  days[3].min_heap = 995;
+  names = soak::growth(days, 3);
+  CHECK(names.size() == 2 && names[1] == "min-heap");
+
+  // too few days never grow
+  CHECK(soak::growth(days, 5).empty());
+}
+
+void test_run() {
+  // soak a day with the default script and a network drop
+  soak::options o;
+  o.days = 1;
+  o.drops = 1;
+  std::string error;
+  CHECK(soak::parse(soak::default_script, o.events, error));
+  soak::report r = soak::run(o);
+  CHECK(r.days.size() == 1);
+  const soak::day &d = r.days[0];
+  printf("heap=%zu allocs=%llu stack=%zu queue=%d publishes=%llu travel=%.0f seconds=%.1f\n", d.heap,
+         static_cast<unsigned long long>(d.allocs), d.stack, d.queue, static_cast<unsigned long long>(d.publishes),
+         d.travel, r.seconds);
+
+  // the firmware allocates at boot only and stays within its stack
+  CHECK(d.allocs < 10);
+  CHECK(d.heap < 1000);
+  CHECK(d.stack > 0 && d.stack < 8192);
+  CHECK(d.queue > 0);
+
+  // the light goes online, publishes and moves
+  CHECK(d.publishes > 1000);
+  CHECK(d.travel > 100);
+  CHECK(d.states[0] < 3600000);
+
+  // the health reports cover the day up to their interval
+  uint64_t total = 0;
+  for (uint32_t ms : d.states) {
+    total += ms;
+  }
+  CHECK(total > 86400000 - 120000 && total <= 86400000);
+}
+
+}  // namespace
+
+int main() {
+  test_duration();
+  test_parse();
+  test_growth();
+  test_run();
+
+  printf("ok\n");
+
+  return 0;
+}
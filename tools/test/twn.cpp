@@ -0,0 +1,96 @@
+#include <cmath>
+#include <cstdio>
+
+#include "check.h"
+
+extern "C" {
+#include "mot.h"
+#include "twn.h"
+}
+
+namespace {
+
+twn_plan_t plan(uint32_t start, double position, double velocity, double target) {
+  return twn_plan_t{start, position, velocity, target, MOT_MAX_VELOCITY, MOT_MAX_ACCELERATION};
+}
+
+double reference(const twn_plan_t &p, double t) {
+  // integrate the profile in small steps: accelerate up to the maximum velocity and brake just in time
+  double distance = std::fabs(p.target - p.position);
+  double dir = p.target >= p.position ? 1 : -1;
+  double v = std::fmin(std::fmax(p.velocity * dir, 0), p.max_velocity);
+  double d = 0;
+  const double dt = 0.05;
+  for (double s = 0; s < t && d < distance; s += dt) {
+    if (distance - d <= v * v / (2 * p.max_acceleration)) {
+      v = std::fmax(v - p.max_acceleration * dt, 1e-9);
+    } else {
+      v = std::fmin(v + p.max_acceleration * dt, p.max_velocity);
+    }
+    d += v * dt;
+  }
+
+  return p.position + dir * std::fmin(d, distance);
+}
+
+void test_endpoints() {
+  // the plan starts at its position and ends at its target
+  twn_plan_t p = plan(1000, 50, 0, 150);
+  CHECK(twn_predict(&p, 1000) == 50);
+  CHECK(twn_predict(&p, 1000 + 60000) == 150);
+
+  // invalid plans predict the target
+  twn_plan_t still = plan(0, 80, 0, 80);
+  CHECK(twn_predict(&still, 500) == 80);
+  twn_plan_t broken = plan(0, 80, 0, 120);
+  broken.max_acceleration = 0;
+  CHECK(twn_predict(&broken, 500) == 120);
+}
+
+void test_profile() {
+  // long and short moves in both directions with and without initial velocity follow the integrated profile
+  const twn_plan_t plans[] = {
+      plan(0, 50, 0, 150),       plan(0, 150, 0, 50),      plan(0, 100, 0, 105),
+      plan(0, 100, 0.01, 140),   plan(0, 140, -0.01, 100), plan(0, 100, 0.015, 101),
+      plan(0, 100, -0.01, 130),
+  };
+  for (const auto &p : plans) {
+    double last = p.position;
+    double dir = p.target >= p.position ? 1 : -1;
+    for (uint32_t t = 0; t <= 20000; t += 50) {
+      twn_plan_t copy = p;
+      double x = twn_predict(&copy, t);
+
+      // the prediction moves monotonically towards the target within the velocity limit
+      CHECK((x - last) * dir >= -1e-9);
+      CHECK(std::fabs(x - last) <= p.max_velocity * 50 + 1e-9);
+      CHECK((p.target - x) * dir >= -1e-9);
+      last = x;
+
+      // the prediction matches the integrated profile
+      CHECK_NEAR(x, reference(p, t), 0.02);
+    }
+    CHECK(last == p.target);
+  }
+}
+
+void test_wrap() {
+  // plans across the wrap of the millisecond clock predict the same positions
+  twn_plan_t a = plan(0, 50, 0, 150);
+  twn_plan_t b = plan(UINT32_MAX - 999, 50, 0, 150);
+  for (uint32_t t = 0; t < 20000; t += 100) {
+    CHECK(twn_predict(&a, t) == twn_predict(&b, b.start + t));
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_endpoints();
+  test_profile();
+  test_wrap();
+
+  printf("ok\n");
+
+  return 0;
+}
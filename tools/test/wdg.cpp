@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+extern "C" {
+#include "wdg.h"
+}
+
+namespace {
+
+// the timings of the supply and light firmware
+const uint32_t cycle_time = 5000;
+const uint32_t timeout = 60000;
+const uint32_t alive_interval = 10000;
+const uint32_t boot_time = 8000;
+
+struct light {
+  std::string id;
+  int bank = 0;
+  bool wedged = false;
+  bool dead = false;
+  bool off = false;
+  uint32_t wedged_at = 0;
+  uint32_t boot_until = 0;
+  uint32_t next_alive = 0;
+};
+
+struct result {
+  int wedges = 0;
+  int recovered = 0;
+  int cycles = 0;
+  double ttr_sum = 0;
+  double ttr_max = 0;
+};
+
+/**
+ * A supply powering simulated lights on three banks that runs the watchdog like the supply firmware. Lights send a
+ * heartbeat every ten seconds unless they are wedged, which only a power cycle of their bank resolves.
+ */
+class supply {
+ public:
+  explicit supply(int count) {
+    // create lights on all banks
+    wdg_reset();
+    for (int i = 0; i < count; i++) {
+      light l;
+      l.id = "light" + std::to_string(i + 1);
+      l.bank = i % 3 + 1;
+      l.next_alive = static_cast<uint32_t>(i) * 300;
+      lights.push_back(l);
+    }
+  }
+
+  void step(uint32_t now, bool network = true) {
+    // power lights and send heartbeats
+    for (auto &l : lights) {
+      if (cycle_bank == l.bank) {
+        l.off = true;
+        continue;
+      }
+      if (l.off) {
+        l.off = false;
+        l.wedged = l.dead;
+        l.boot_until = now + boot_time;
+        l.next_alive = l.boot_until;
+      }
+      if (l.wedged || now < l.next_alive) {
+        continue;
+      }
+      l.next_alive = now + alive_interval;
+      if (l.wedged_at > 0) {
+        double ttr = static_cast<double>(now - l.wedged_at) / 1000;
+        res.recovered++;
+        res.ttr_sum += ttr;
+        res.ttr_max = std::max(res.ttr_max, ttr);
+        l.wedged_at = 0;
+      }
+      if (network) {
+        wdg_seen(l.id.c_str(), l.bank, now);
+      }
+    }
+
+    // restore power after cycle
+    if (cycle_bank != 0) {
+      if (now - cycle_start >= cycle_time) {
+        cycle_bank = 0;
+      }
+      return;
+    }
+
+    // cycle bank with silent lights with spacing
+    int bank = wdg_check(now, timeout);
+    if (bank != 0) {
+      CHECK(res.cycles == 0 || now - cycle_start >= 2 * 60 * 1000);
+      cycle_bank = bank;
+      cycle_start = now;
+      res.cycles++;
+    }
+  }
+
+  void wedge(light &l, uint32_t now) {
+    // stop heartbeats until power cycled
+    if (!l.wedged) {
+      l.wedged = true;
+      l.wedged_at = now;
+      res.wedges++;
+    }
+  }
+
+  std::vector<light> lights;
+  result res;
+
+ private:
+  int cycle_bank = 0;
+  uint32_t cycle_start = 0;
+};
+
+void test_recovery() {
+  // wedge 30 lights randomly every two days on average for 30 days and kill one light for good on day 10
+  supply s(30);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> chance(0, 1);
+  const uint32_t days = 30;
+  for (uint32_t now = 1000; now < days * 86400 * 1000; now += 1000) {
+    for (auto &l : s.lights) {
+      if (!l.dead && chance(rng) < 1.0 / (2 * 86400)) {
+        s.wedge(l, now);
+      }
+    }
+    if (now == 10u * 86400 * 1000) {
+      s.lights.back().dead = true;
+      s.lights.back().wedged = true;
+    }
+    s.step(now);
+  }
+
+  // all wedged lights recovered with few cycles, the dead light was given up
+  const result &r = s.res;
+  printf("wdg lights=30 days=%u wedges=%d recovered=%d cycles=%d mean-ttr=%.1fs max-ttr=%.1fs\n",
+         days, r.wedges, r.recovered, r.cycles, r.ttr_sum / r.recovered, r.ttr_max);
+  CHECK(r.wedges > 100);
+  CHECK(r.recovered >= r.wedges - 1);
+  CHECK(r.cycles <= r.wedges + 5);
+  CHECK(r.ttr_sum / r.recovered < 5 * 60);
+}
+
+void test_outage() {
+  // lights silent because of a network outage are not cycled
+  supply s(9);
+  uint32_t now = 1000;
+  for (; now < 600000; now += 1000) {
+    s.step(now);
+  }
+  for (; now < 1800000; now += 1000) {
+    s.step(now, false);
+  }
+  CHECK(s.res.cycles == 0);
+}
+
+void test_deregister() {
+  // a light without bank is forgotten
+  supply s(9);
+  uint32_t now = 1000;
+  for (; now < 60000; now += 1000) {
+    s.step(now);
+  }
+  light &l = s.lights.front();
+  wdg_seen(l.id.c_str(), 0, now);
+  l.dead = true;
+  l.wedged = true;
+  for (; now < 600000; now += 1000) {
+    s.step(now);
+  }
+  CHECK(s.res.cycles == 0);
+
+  // a bank that is cycled too often gives up its silent lights until they return
+  l.bank = 1;
+  l.wedged = false;
+  l.dead = false;
+  l.next_alive = now;
+  s.step(now);
+  l.dead = true;
+  l.wedged = true;
+  for (; now < 4 * 3600 * 1000; now += 1000) {
+    s.step(now);
+  }
+  CHECK(s.res.cycles == 5);
+  l.dead = false;
+  l.wedged = false;
+  for (; now < 5 * 3600 * 1000; now += 1000) {
+    s.step(now);
+  }
+  CHECK(s.res.cycles == 5);
+}
+
+}  // namespace
+
+int main() {
+  test_recovery();
+  test_outage();
+  test_deregister();
+
+  printf("ok\n");
+
+  return 0;
+}
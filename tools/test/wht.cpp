@@ -0,0 +1,95 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "check.h"
+
+extern "C" {
+#include "wht.h"
+}
+
+namespace {
+
+struct light {
+  double r, g, b;
+};
+
+led_color_t color(int r, int g, int b, int w) { return led_color_t{r, g, b, w}; }
+
+light emitted(led_color_t c, int r, int g, int b) {
+  // add the output of the white channel to the color channels
+  return light{c.r + c.w * r / 1023.0, c.g + c.w * g / 1023.0, c.b + c.w * b / 1023.0};
+}
+
+void test_examples() {
+  // grey moves to a neutral white channel
+  led_color_t c = wht_extract(color(500, 500, 500, 0), 1023, 1023, 1023);
+  CHECK(c.r == 0 && c.g == 0 && c.b == 0 && c.w == 500);
+
+  // white of a warm white channel is limited by red
+  c = wht_extract(color(1023, 1023, 1023, 0), 1023, 800, 500);
+  CHECK(c.r == 0 && c.g == 223 && c.b == 523 && c.w == 1023);
+
+  // white is limited by the headroom of the white channel
+  c = wht_extract(color(500, 500, 500, 900), 1023, 1023, 1023);
+  CHECK(c.r == 377 && c.g == 377 && c.b == 377 && c.w == 1023);
+
+  // saturated colors and a zero calibration are kept
+  c = wht_extract(color(1023, 0, 0, 0), 1023, 1023, 1023);
+  CHECK(c.r == 1023 && c.g == 0 && c.b == 0 && c.w == 0);
+  c = wht_extract(color(500, 500, 500, 0), 0, 0, 0);
+  CHECK(c.r == 500 && c.g == 500 && c.b == 500 && c.w == 0);
+
+  // a white channel without blue takes the white of red and green
+  c = wht_extract(color(400, 300, 200, 0), 1023, 1023, 0);
+  CHECK(c.r == 100 && c.g == 0 && c.b == 200 && c.w == 300);
+}
+
+void test_accuracy() {
+  // convert random colors with random calibrations
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> duty(0, 1023);
+  double max_error = 0;
+  double before = 0;
+  double after = 0;
+  const int colors = 200000;
+  for (int i = 0; i < colors; i++) {
+    int r = duty(rng);
+    int g = duty(rng);
+    int b = duty(rng);
+    led_color_t in = color(duty(rng), duty(rng), duty(rng), i % 4 == 0 ? duty(rng) : 0);
+    led_color_t out = wht_extract(in, r, g, b);
+
+    // channels stay within range
+    CHECK(out.r >= 0 && out.g >= 0 && out.b >= 0 && out.w >= in.w && out.w <= 1023);
+    CHECK(out.r <= in.r && out.g <= in.g && out.b <= in.b);
+
+    // the emitted light differs by less than one count per channel
+    light want = emitted(in, r, g, b);
+    light got = emitted(out, r, g, b);
+    double error = std::fmax(std::fabs(want.r - got.r), std::fabs(want.g - got.g));
+    error = std::fmax(error, std::fabs(want.b - got.b));
+    CHECK(error < 1);
+    max_error = std::fmax(max_error, error);
+
+    // no further white fits into the channels or the white channel
+    int w = out.w - in.w;
+    CHECK(out.w == 1023 || (w + 1) * r > in.r * 1023 || (w + 1) * g > in.g * 1023 || (w + 1) * b > in.b * 1023);
+    before += in.r + in.g + in.b;
+    after += out.r + out.g + out.b;
+  }
+
+  // report the error and the color duty moved to the white channel
+  printf("wht colors=%d max-error=%.3f rgb-duty=-%.1f%%\n", colors, max_error, (1 - after / before) * 100);
+}
+
+}  // namespace
+
+int main() {
+  test_examples();
+  test_accuracy();
+
+  printf("ok\n");
+
+  return 0;
+}
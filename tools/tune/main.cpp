@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sim/pool.h"
+#include "sim/visitor.h"
+
+namespace {
+
+struct gene {
+  const char *name;
+  double min, max;
+};
+
+// the tuned automation parameters and their search bounds
+const gene genes[] = {
+    {"approach-range", 20, 80},  {"approach-target", 5, 40}, {"base-height", 60, 140}, {"rise-height", 90, 190},
+    {"pir-low", 50, 400},        {"pir-high", 100, 600},     {"pir-interval", 500, 6000},
+};
+const size_t num_genes = sizeof(genes) / sizeof(genes[0]);
+
+struct options {
+  int generations = 30;
+  int population = 32;
+  int scenarios = 4;
+  double minutes = 10;
+  unsigned threads = 0;
+  uint64_t seed = 1;
+  std::string model;
+  std::string out;
+  bool bench = false;
+  double w_response = 1;
+  double w_contact = 20;
+  double w_reversals = 0.5;
+  double w_travel = 0.01;
+};
+
+struct candidate {
+  std::vector<double> genes;
+  sim::config config;
+  sim::score score;
+  double cost = 0;
+  bool evaluated = false;
+};
+
+void usage() {
+  fprintf(stderr,
+          "usage: tune [--generations N] [--population N] [--scenarios N] [--minutes M] [--threads N] [--seed S]\n"
+          "            [--model FILE] [--out FILE] [--w-response W] [--w-contact W] [--w-reversals W]\n"
+          "            [--w-travel W] [--bench]\n");
+}
+
+bool parse(int argc, char **argv, options &o) {
+  // read flags
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--bench") {
+      o.bench = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    const char *value = argv[++i];
+    if (flag == "--generations") {
+      o.generations = atoi(value);
+    } else if (flag == "--population") {
+      o.population = std::max(4, atoi(value));
+    } else if (flag == "--scenarios") {
+      o.scenarios = std::max(1, atoi(value));
+    } else if (flag == "--minutes") {
+      o.minutes = atof(value);
+    } else if (flag == "--threads") {
+      o.threads = static_cast<unsigned>(atoi(value));
+    } else if (flag == "--seed") {
+      o.seed = strtoull(value, nullptr, 10);
+    } else if (flag == "--model") {
+      o.model = value;
+    } else if (flag == "--out") {
+      o.out = value;
+    } else if (flag == "--w-response") {
+      o.w_response = atof(value);
+    } else if (flag == "--w-contact") {
+      o.w_contact = atof(value);
+    } else if (flag == "--w-reversals") {
+      o.w_reversals = atof(value);
+    } else if (flag == "--w-travel") {
+      o.w_travel = atof(value);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+sim::config decode(const std::vector<double> &g) {
+  // map normalized genes to parameters
+  sim::config c;
+  for (size_t i = 0; i < num_genes; i++) {
+    sim::set(c, genes[i].name, genes[i].min + g[i] * (genes[i].max - genes[i].min));
+  }
+
+  // keep heights and thresholds ordered
+  c.rise_height = std::max(c.rise_height, std::min(190.0, c.base_height + 10));
+  c.pir_high = std::max(c.pir_high, c.pir_low);
+
+  return c;
+}
+
+std::vector<double> encode(const sim::config &c) {
+  // map parameters to normalized genes
+  std::vector<double> g(num_genes);
+  for (size_t i = 0; i < num_genes; i++) {
+    double value = 0;
+    sim::get(c, genes[i].name, value);
+    g[i] = std::max(0.0, std::min(1.0, (value - genes[i].min) / (genes[i].max - genes[i].min)));
+  }
+
+  return g;
+}
+
+double cost(const options &o, const sim::score &s) {
+  return o.w_response * s.response / 1000 + o.w_contact * s.contact + o.w_reversals * s.reversals +
+         o.w_travel * s.travel;
+}
+
+void evaluate(const options &o, const sim::plant &p, std::vector<candidate> &pop) {
+  // collect simulations of all unevaluated candidates
+  std::vector<std::pair<size_t, int>> jobs;
+  for (size_t i = 0; i < pop.size(); i++) {
+    if (!pop[i].evaluated) {
+      for (int s = 0; s < o.scenarios; s++) {
+        jobs.emplace_back(i, s);
+      }
+    }
+  }
+
+  // run simulations in parallel using the same scenarios for every candidate
+  std::vector<sim::score> scores(jobs.size());
+  auto duration = static_cast<uint64_t>(o.minutes * 60000);
+  sim::parallel_for(jobs.size(), sim::threads(o.threads), [&](size_t j) {
+    scores[j] = sim::simulate(pop[jobs[j].first].config, p, sim::behavior(), o.seed * 1000 + jobs[j].second, duration);
+  });
+
+  // average scores per candidate
+  for (size_t j = 0; j < jobs.size(); j++) {
+    candidate &c = pop[jobs[j].first];
+    if (!c.evaluated) {
+      c.score = sim::score();
+      c.evaluated = true;
+    }
+    c.score.response += scores[j].response / o.scenarios;
+    c.score.contact += scores[j].contact / o.scenarios;
+    c.score.reversals += scores[j].reversals / o.scenarios;
+    c.score.travel += scores[j].travel / o.scenarios;
+    c.score.reaches += scores[j].reaches;
+  }
+  for (auto &c : pop) {
+    c.cost = cost(o, c.score);
+  }
+}
+
+void print(const char *label, const candidate &c) {
+  printf("%s cost=%.3f response=%.0fms contact=%.3f reversals=%.2f/min travel=%.1fcm/min reaches=%u\n", label, c.cost,
+         c.score.response, c.score.contact, c.score.reversals, c.score.travel, c.score.reaches);
+}
+
+int bench(const options &o, const sim::plant &p) {
+  // run one simulated minute per simulation
+  const uint64_t duration = 60000;
+  unsigned workers = sim::threads(o.threads);
+  size_t count = std::max<size_t>(8, workers * 4);
+
+  // measure single and multi threaded throughput
+  for (unsigned n : {1u, workers}) {
+    auto start = std::chrono::steady_clock::now();
+    sim::parallel_for(count, n, [&](size_t i) { sim::simulate(sim::config(), p, sim::behavior(), i + 1, duration); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("threads=%u simulations=%zu seconds=%.3f sims/s=%.1f sims/s/core=%.1f speedup=%.0fx\n", n, count, seconds,
+           count / seconds, count / seconds / n, count * duration / 1000.0 / seconds / n);
+    if (n == workers) {
+      break;
+    }
+  }
+
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // parse options
+  options o;
+  if (!parse(argc, argv, o)) {
+    usage();
+    return 1;
+  }
+
+  // load plant model
+  sim::plant p;
+  if (!o.model.empty() && !sim::load(o.model, p)) {
+    fprintf(stderr, "tune: failed to load model %s\n", o.model.c_str());
+    return 1;
+  }
+
+  // run benchmark
+  if (o.bench) {
+    return bench(o, p);
+  }
+
+  // seed population with the firmware defaults and random candidates
+  std::mt19937_64 random(o.seed);
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::normal_distribution<double> normal(0, 1);
+  std::vector<candidate> pop(static_cast<size_t>(o.population));
+  for (size_t i = 0; i < pop.size(); i++) {
+    if (i == 0) {
+      pop[i].genes = encode(sim::config());
+    } else {
+      pop[i].genes.resize(num_genes);
+      for (double &g : pop[i].genes) {
+        g = unit(random);
+      }
+    }
+    pop[i].config = decode(pop[i].genes);
+  }
+
+  // evaluate defaults
+  evaluate(o, p, pop);
+  candidate defaults = pop[0];
+  print("defaults:", defaults);
+
+  // evolve population
+  size_t elite = std::max<size_t>(2, pop.size() / 4);
+  double sigma = 0.2;
+  for (int gen = 0; gen < o.generations; gen++) {
+    // rank candidates
+    std::sort(pop.begin(), pop.end(), [](const candidate &a, const candidate &b) { return a.cost < b.cost; });
+    char label[32];
+    snprintf(label, sizeof(label), "generation %d:", gen);
+    print(label, pop[0]);
+
+    // replace all but the elite with mutated crossovers of elite parents
+    for (size_t i = elite; i < pop.size(); i++) {
+      const candidate &a = pop[random() % elite];
+      const candidate &b = pop[random() % elite];
+      pop[i].genes.resize(num_genes);
+      for (size_t g = 0; g < num_genes; g++) {
+        double v = unit(random) < 0.5 ? a.genes[g] : b.genes[g];
+        pop[i].genes[g] = std::max(0.0, std::min(1.0, v + normal(random) * sigma));
+      }
+      pop[i].config = decode(pop[i].genes);
+      pop[i].evaluated = false;
+    }
+
+    // evaluate offspring
+    evaluate(o, p, pop);
+
+    // narrow search
+    sigma = std::max(0.02, sigma * 0.9);
+  }
+
+  // report best candidate
+  std::sort(pop.begin(), pop.end(), [](const candidate &a, const candidate &b) { return a.cost < b.cost; });
+  print("best:", pop[0]);
+
+  // output profile
+  std::vector<std::string> names;
+  for (const auto &g : genes) {
+    names.emplace_back(g.name);
+  }
+  std::string profile = sim::profile(pop[0].config, names);
+  printf("%s\n", profile.c_str());
+  if (!o.out.empty()) {
+    std::ofstream(o.out) << profile << "\n";
+  }
+
+  return 0;
+}